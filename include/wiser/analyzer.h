@@ -0,0 +1,120 @@
+#pragma once
+
+/**
+ * @file analyzer.h
+ * @brief 分析器：把码点序列切分为词元，索引（Tokenizer）与查询（SearchEngine::getTokenIds、
+ *        Utils::tokenizeQueryTokens）共用同一套切分规则。
+ *
+ * 忽略字符（见 char_class.h）切断连续段，其余码点先做 ASCII 小写化：
+ *  - AnalyzerType::NGRAM：每个连续段切分为重叠的 N-gram；
+ *  - AnalyzerType::HYBRID：ASCII 字母/数字（kCharWord）的连续段整体作为一个词元，
+ *    其余字符（如 CJK）的连续段仍切分为重叠的 N-gram。英文正文因此每个词只产生一个 posting，
+ *    而不是每个字符一个，"th"、"he" 这类文档频率极高的 gram 也不再出现。
+ *    词字符与小写化的范围都只限 ASCII，带重音等的非 ASCII 字母与 NGRAM 一样切分 N-gram 且不归一化。
+ * 长度不足 N 的 N-gram 段不产出词元。词元按在文本中的顺序产出，序号即其在文档中的位置。
+ */
+
+#include "types.h"
+#include "config.h"
+#include "char_class.h"
+#include "utils.h"
+#include <algorithm>
+#include <array>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace wiser {
+    /**
+     * @brief 码点来源：UTF-32 数组（整体作为一块）
+     */
+    class Utf32Source {
+    public:
+        explicit Utf32Source(std::span<const UTF32Char> text) : text_(text) {}
+
+        std::span<const UTF32Char> nextBlock() { return std::exchange(text_, {}); }
+
+    private:
+        std::span<const UTF32Char> text_;
+    };
+
+    /**
+     * @brief 码点来源：直接从 UTF-8 字节串中分块解码到定长缓冲（内存占用与正文长度无关）
+     */
+    class Utf8Source {
+    public:
+        explicit Utf8Source(std::string_view text) : text_(text) {}
+
+        std::span<const UTF32Char> nextBlock() {
+            const size_t count = Utils::decodeUtf8(text_, pos_, buffer_.data(), buffer_.size());
+            return { buffer_.data(), count };
+        }
+
+    private:
+        std::string_view text_;
+        size_t pos_ = 0;
+        std::array<UTF32Char, 256> buffer_;
+    };
+
+    /**
+     * @brief 按分析器规则枚举词元
+     *
+     * N-gram 以滑动窗口产出：窗口保存当前 N-gram 段的最后 N 个码点，段长度达到 N 后每读入一个码点产出一个，
+     * 顺序与起点一致。HYBRID 下 ASCII 词在遇到非词字符或文本结束时整体产出。
+     * 码点按块读入，每个码点查一次分类表同时得到忽略判定、词字符判定与小写化结果。
+     * @tparam CodePointSource 提供 std::span<const UTF32Char> nextBlock()（空表示结束）的码点来源
+     * @param analyzer 分析器类型
+     * @param n N-gram 的 N 值（为 0 时不产出任何词元）
+     * @param source 码点来源
+     * @param window 滑动窗口暂存（调用方复用）
+     * @param word 整词暂存（调用方复用）
+     * @param emit 以 std::span<const UTF32Char>（已小写化的码点）调用，每个词元一次
+     */
+    template <typename CodePointSource, typename Emit>
+    void forEachTerm(AnalyzerType analyzer, size_t n, CodePointSource& source, std::vector<UTF32Char>& window,
+                     std::vector<UTF32Char>& word, Emit&& emit) {
+        if (n == 0) {
+            return;
+        }
+        // NGRAM 下不设词字符位，所有码点都进入滑动窗口
+        const std::uint8_t word_mask = analyzer == AnalyzerType::HYBRID ? kCharWord : 0;
+        window.resize(n);
+        word.clear();
+        size_t run = 0;
+        auto flush_word = [&] {
+            if (!word.empty()) {
+                emit(std::span<const UTF32Char>(word));
+                word.clear();
+            }
+        };
+        for (auto block = source.nextBlock(); !block.empty(); block = source.nextBlock()) {
+            for (UTF32Char ch: block) {
+                const std::uint8_t cls = charClass(ch);
+                if (cls & kCharIgnored) {
+                    flush_word();
+                    run = 0;
+                    continue;
+                }
+                // 与 foldCodePoint 相同：大写 ASCII 置 0x20 位
+                const UTF32Char folded = ch | static_cast<UTF32Char>((cls & kCharUpper) << 4);
+                if (cls & word_mask) {
+                    word.push_back(folded);
+                    run = 0;
+                    continue;
+                }
+                flush_word();
+                if (run < n) {
+                    window[run++] = folded;
+                } else {
+                    std::shift_left(window.begin(), window.end(), 1);
+                    window[n - 1] = folded;
+                }
+                if (run == n) {
+                    emit(std::span<const UTF32Char>(window.data(), n));
+                }
+            }
+        }
+        flush_word();
+    }
+} // namespace wiser
@@ -0,0 +1,41 @@
+#pragma once
+
+/**
+ * @file bitpacking.h
+ * @brief 定宽位打包（BP128）整数序列编码
+ *
+ * 序列按 kBitPackBlockSize 个整数分组，每组独立选取位宽 b = bit_width(max)：
+ *  - 满组：[b:uint8][b 个 128 位字]，采用 4 路纵向布局（第 i 个整数属于第 i % 4 路），
+ *    每路 32 个整数依次打包进各字的对应 32 位槽，解码时 4 路可并行移位/掩码（SSE2）；
+ *  - 末尾不足一组：[b:uint8][ceil(n * b / 32) 个 32 位字]，按顺序横向打包。
+ * 所有 32 位字按本机字节序存储。调用方需自行记录整数个数。
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace wiser {
+    /**
+     * @brief 每组整数个数
+     */
+    constexpr size_t kBitPackBlockSize = 128;
+
+    /**
+     * @brief 将整数序列位打包后追加到输出
+     * @param values 待编码整数
+     * @param out 输出缓冲区（追加）
+     */
+    void bitPackEncode(std::span<const std::uint32_t> values, std::vector<char>& out);
+
+    /**
+     * @brief 从 p 处解码 count 个整数
+     * @param p 输入位置，成功时前移到已读数据之后
+     * @param end 输入末尾
+     * @param count 整数个数（须与编码时一致）
+     * @param out 输出数组（至少 count 个元素）
+     * @return 数据完整返回 true
+     */
+    bool bitPackDecode(const char*& p, const char* end, size_t count, std::uint32_t* out);
+} // namespace wiser
@@ -0,0 +1,60 @@
+#pragma once
+
+/**
+ * @file bloom_filter.h
+ * @brief 分块 Bloom 过滤器：判断一个键“一定不存在”或“可能存在”。
+ *
+ * 每个键只落在一个 512 位（一条缓存行）的块内，块由哈希的高位选出，块内 kBloomProbes 个位由哈希的其余位派生；
+ * 一次查询只访问一条缓存行。按每键 kBloomBitsPerKey 位分配时误判率约 1%。
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace wiser {
+    constexpr size_t kBloomBitsPerKey = 10; ///< 每个键分配的位数
+    constexpr size_t kBloomProbes = 7;      ///< 每个键在块内设置的位数
+
+    /**
+     * @class BloomFilter
+     * @brief 以 64 位哈希为键的分块 Bloom 过滤器（构建后只读，可并发查询）
+     */
+    class BloomFilter {
+    public:
+        BloomFilter() = default;
+
+        /**
+         * @brief 按预计的键数分配位数组（清空已有内容）
+         * @param expected_keys 预计插入的键数
+         */
+        void reset(size_t expected_keys);
+
+        /**
+         * @brief 插入键
+         * @param hash 键的 64 位哈希
+         */
+        void add(std::uint64_t hash);
+
+        /**
+         * @brief 查询键是否可能存在
+         * @param hash 键的 64 位哈希
+         * @return false 表示一定不存在；true 表示可能存在。未分配时总是返回 false
+         */
+        [[nodiscard]] bool mayContain(std::uint64_t hash) const;
+
+        /**
+         * @brief 位数组占用的字节数
+         */
+        [[nodiscard]] size_t memoryUsage() const { return blocks_.size() * sizeof(Block); }
+
+    private:
+        struct alignas(64) Block {
+            std::uint64_t words[8];
+        };
+
+        std::vector<Block> blocks_;
+
+        size_t blockIndex(std::uint64_t hash) const;
+    };
+} // namespace wiser
@@ -0,0 +1,133 @@
+#pragma once
+
+/**
+ * @file char_class.h
+ * @brief 分词用字符分类：忽略字符判定、ASCII 小写化与 ASCII 词字符判定，由编译期生成的 BMP 两级查找表完成。
+ *
+ * 第一级以码点高 8 位索引到块号，第二级为每块 256 个码点的类别字节；不含任何特殊字符的块
+ * 共用全零的 0 号块，因此整张表只有几 KB。BMP 之外的码点既不忽略也不归一化。
+ * 分类与原先基于 std::isspace/std::ispunct（"C" locale）与 CJK 标点列表的判定完全一致，但不依赖 locale，可内联。
+ */
+
+#include "types.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace wiser {
+    constexpr std::uint8_t kCharIgnored = 0x01; ///< 分隔字符（空白、标点），不参与分词
+    constexpr std::uint8_t kCharUpper = 0x02;   ///< ASCII 大写字母，归一化为小写
+    constexpr std::uint8_t kCharWord = 0x04;    ///< ASCII 字母与数字：混合分析器（AnalyzerType::HYBRID）中按整词切分。
+                                                ///< 与小写化范围一致，非 ASCII 字母（如 É）仍走 N-gram，不做大小写归一化
+
+    namespace detail {
+        constexpr size_t kCharClassMaxBlocks = 8;
+
+        /// 需要忽略的非 ASCII 字符（CJK 与全角标点、弯引号）
+        constexpr UTF32Char kIgnoredNonAscii[] = {
+                0x3000, // 全角空格
+                0x3001, // 、
+                0x3002, // 。
+                0xFF08, // （
+                0xFF09, // ）
+                0xFF01, // ！
+                0xFF0C, // ，
+                0xFF1A, // ：
+                0xFF1B, // ；
+                0xFF1F, // ？
+                0xFF3B, // ［
+                0xFF3D, // ］
+                0x201C, // “
+                0x201D, // ”
+                0x2018, // ‘
+                0x2019, // ’
+        };
+
+        /**
+         * @brief ASCII 字符的类别
+         *
+         * 空白一律忽略；标点大多忽略，但保留 '.'：这样小数（如 2.5）会形成连续字符序列，
+         * 从而在 N=2 时产生 "2."、".5" 等 token，支持对小数的检索。若把 '.' 也当作标点忽略，
+         * 则会把 "2" 与 "5" 分割成两个长度 < N 的片段，导致查询无法产生 token。
+         */
+        constexpr std::uint8_t asciiCharClass(UTF32Char ch) {
+            const bool space = ch == ' ' || (ch >= '\t' && ch <= '\r');
+            const bool punct = (ch >= '!' && ch <= '/') || (ch >= ':' && ch <= '@') || (ch >= '[' && ch <= '`') ||
+                               (ch >= '{' && ch <= '~');
+            if (space || (punct && ch != '.')) {
+                return kCharIgnored;
+            }
+            if (ch >= 'A' && ch <= 'Z') {
+                return kCharUpper | kCharWord;
+            }
+            if ((ch >= 'a' && ch <= 'z') || (ch >= '0' && ch <= '9')) {
+                return kCharWord;
+            }
+            return 0;
+        }
+
+        struct CharClassTable {
+            std::array<std::uint8_t, 256> block_of{}; ///< 码点高 8 位 -> 块号
+            std::array<std::array<std::uint8_t, 256>, kCharClassMaxBlocks> blocks{}; ///< 0 号块全零
+        };
+
+        constexpr CharClassTable buildCharClassTable() {
+            CharClassTable table{};
+            size_t count = 1;
+            table.block_of[0] = static_cast<std::uint8_t>(count++);
+            for (UTF32Char ch = 0; ch < 128; ++ch) {
+                table.blocks[1][ch] = asciiCharClass(ch);
+            }
+            for (UTF32Char ch: kIgnoredNonAscii) {
+                std::uint8_t& block = table.block_of[ch >> 8];
+                if (block == 0) {
+                    block = static_cast<std::uint8_t>(count++);
+                }
+                table.blocks[block][ch & 0xFF] |= kCharIgnored;
+            }
+            return table;
+        }
+
+        inline constexpr CharClassTable kCharClassTable = buildCharClassTable();
+    } // namespace detail
+
+    /**
+     * @brief 字符类别（kCharIgnored / kCharUpper / kCharWord 的组合）
+     * @param ch UTF-32 字符
+     * @return 类别位
+     */
+    constexpr std::uint8_t charClass(UTF32Char ch) {
+        if (ch > 0xFFFF) {
+            return 0;
+        }
+        return detail::kCharClassTable.blocks[detail::kCharClassTable.block_of[ch >> 8]][ch & 0xFF];
+    }
+
+    /**
+     * @brief 是否为应忽略的分隔字符
+     */
+    constexpr bool isIgnoredCodePoint(UTF32Char ch) {
+        return (charClass(ch) & kCharIgnored) != 0;
+    }
+
+    /**
+     * @brief 是否为 ASCII 字母或数字（混合分析器中组成整词的字符）
+     */
+    constexpr bool isWordCodePoint(UTF32Char ch) {
+        return (charClass(ch) & kCharWord) != 0;
+    }
+
+    /**
+     * @brief 归一化码点：ASCII 大写字母转为小写，其余不变（无分支）
+     */
+    constexpr UTF32Char foldCodePoint(UTF32Char ch) {
+        // kCharUpper (0x02) 左移 4 位即 0x20，大小写字母只差这一位
+        return ch | static_cast<UTF32Char>((charClass(ch) & kCharUpper) << 4);
+    }
+
+    static_assert(isIgnoredCodePoint(' ') && isIgnoredCodePoint(',') && !isIgnoredCodePoint('.'));
+    static_assert(isIgnoredCodePoint(0x3002) && isIgnoredCodePoint(0xFF0C) && !isIgnoredCodePoint(0x4E2D));
+    static_assert(isWordCodePoint('Z') && isWordCodePoint('7') && !isWordCodePoint(0x00E9) && !isWordCodePoint('.') &&
+                  !isWordCodePoint(0x00C9) && !isWordCodePoint(0x4E2D));
+    static_assert(foldCodePoint('A') == 'a' && foldCodePoint('a') == 'a' && foldCodePoint('@') == '@');
+} // namespace wiser
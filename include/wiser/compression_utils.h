@@ -1,7 +1,9 @@
 #pragma once
 
+#include <bit>
 #include <vector>
 #include <cstdint>
+#include <cstring>
 #include <cmath>
 #include <stdexcept>
 #include <string>
@@ -10,25 +12,33 @@ namespace wiser {
 
     /**
      * @brief 位流写入器
-     * 用于按位写入数据
+     * 用于按位写入数据（高位在前）
+     *
+     * 内部使用 64 位累加器，一次写入多位只需一次移位/或运算，
+     * 累计满 32 位时整字输出到缓冲区。
      */
     class BitWriter {
     public:
         void writeBit(bool bit) {
-            if (bit_count_ == 8) {
-                buffer_.push_back(current_byte_);
-                current_byte_ = 0;
-                bit_count_ = 0;
-            }
-            if (bit) {
-                current_byte_ |= (1 << (7 - bit_count_));
-            }
-            bit_count_++;
+            writeBits(bit ? 1u : 0u, 1);
         }
 
+        /**
+         * @brief 写入 value 的低 bits 位（0 <= bits <= 32）
+         */
         void writeBits(uint32_t value, int bits) {
-            for (int i = bits - 1; i >= 0; --i) {
-                writeBit((value >> i) & 1);
+            if (bits <= 0) {
+                return;
+            }
+            acc_ = (acc_ << bits) | (static_cast<uint64_t>(value) & ((uint64_t{ 1 } << bits) - 1));
+            fill_ += bits;
+            if (fill_ >= 32) {
+                fill_ -= 32;
+                const auto word = static_cast<uint32_t>(acc_ >> fill_);
+                buffer_.push_back(static_cast<char>(word >> 24));
+                buffer_.push_back(static_cast<char>(word >> 16));
+                buffer_.push_back(static_cast<char>(word >> 8));
+                buffer_.push_back(static_cast<char>(word));
             }
         }
 
@@ -38,55 +48,73 @@ namespace wiser {
          * 写入 q 个 1，以 0 结束
          */
         void writeUnary(uint32_t q) {
-            for (uint32_t i = 0; i < q; ++i) {
-                writeBit(true);
+            while (q >= 32) {
+                writeBits(0xFFFFFFFFu, 32);
+                q -= 32;
             }
-            writeBit(false);
+            // q 个 1 后接一个 0，共 q + 1 <= 32 位
+            writeBits(((uint32_t{ 1 } << q) - 1) << 1, static_cast<int>(q) + 1);
         }
 
         /**
          * @brief 刷入缓冲区并返回数据
+         *
+         * 末尾不足 1 字节的部分以 0 补齐；不修改写入器状态。
          */
-        std::vector<char> getData() {
-            if (bit_count_ > 0) {
-                buffer_.push_back(current_byte_);
-                // 不重置，允许继续写入（如果不清理的话），但通常是用一次获取
+        std::vector<char> getData() const {
+            std::vector<char> data = buffer_;
+            int fill = fill_;
+            while (fill >= 8) {
+                fill -= 8;
+                data.push_back(static_cast<char>(acc_ >> fill));
+            }
+            if (fill > 0) {
+                data.push_back(static_cast<char>(acc_ << (8 - fill)));
             }
-            return buffer_;
+            return data;
         }
 
     private:
         std::vector<char> buffer_;
-        unsigned char current_byte_ = 0;
-        int bit_count_ = 0;
+        uint64_t acc_ = 0; ///< 低 fill_ 位为尚未输出的数据
+        int fill_ = 0;     ///< 累加器中的有效位数（< 32）
     };
 
     /**
      * @brief 位流读取器
-     * 用于按位读取数据
+     * 用于按位读取数据（高位在前）
+     *
+     * 内部维护一个左对齐的 64 位窗口，按字补充；
+     * readBits 为一次移位/掩码，readUnary 通过前导零计数（clz）一次跨过连续的 1。
+     * 读取越过流末尾时抛出 std::out_of_range。
      */
     class BitReader {
     public:
-        BitReader(const std::vector<char>& data) : data_(data) {}
+        BitReader(const std::vector<char>& data)
+            : BitReader(data.data(), data.size()) {}
+
+        BitReader(const char* data, size_t size)
+            : data_(reinterpret_cast<const unsigned char*>(data)), size_(size) {}
 
         bool readBit() {
-            if (byte_index_ >= data_.size()) {
-                throw std::out_of_range("BitReader: End of stream");
-            }
-            bool bit = (data_[byte_index_] >> (7 - bit_index_)) & 1;
-            bit_index_++;
-            if (bit_index_ == 8) {
-                bit_index_ = 0;
-                byte_index_++;
-            }
-            return bit;
+            return readBits(1) != 0;
         }
 
+        /**
+         * @brief 读取 bits 位（0 <= bits <= 32）
+         */
         uint32_t readBits(int bits) {
-            uint32_t value = 0;
-            for (int i = 0; i < bits; ++i) {
-                value = (value << 1) | (readBit() ? 1 : 0);
+            if (bits <= 0) {
+                return 0;
+            }
+            if (avail_ < bits) {
+                refill();
+                if (avail_ < bits) {
+                    throw std::out_of_range("BitReader: End of stream");
+                }
             }
+            const auto value = static_cast<uint32_t>(window_ >> (64 - bits));
+            consume(bits);
             return value;
         }
 
@@ -96,20 +124,82 @@ namespace wiser {
          */
         uint32_t readUnary() {
             uint32_t q = 0;
-            while (readBit()) {
-                q++;
+            while (true) {
+                if (avail_ == 0) {
+                    refill();
+                    if (avail_ == 0) {
+                        throw std::out_of_range("BitReader: End of stream");
+                    }
+                }
+                // 取反后前导零个数即为窗口开头连续 1 的个数
+                const int ones = std::countl_zero(~window_);
+                if (ones < avail_) {
+                    q += static_cast<uint32_t>(ones);
+                    consume(ones + 1);
+                    return q;
+                }
+                q += static_cast<uint32_t>(avail_);
+                consume(avail_);
             }
-            return q;
         }
 
         bool eof() const {
-             return byte_index_ >= data_.size();
+            return pos_ >= size_ && avail_ == 0;
         }
 
     private:
-        const std::vector<char>& data_;
-        size_t byte_index_ = 0;
-        int bit_index_ = 0;
+        const unsigned char* data_;
+        size_t size_;
+        size_t pos_ = 0;      ///< 下一个待装入窗口的字节下标
+        uint64_t window_ = 0; ///< 左对齐的位窗口，最高位为下一个待读位
+        int avail_ = 0;       ///< 窗口中的有效位数
+
+        void consume(int bits) {
+            window_ = bits >= 64 ? 0 : (window_ << bits);
+            avail_ -= bits;
+        }
+
+        void refill() {
+            if (pos_ + 8 <= size_) {
+                // 整字装入：窗口中已有的有效位之后紧接新字节；超出 avail_ 的位与下次装入内容一致，可安全重复或入
+                uint64_t word;
+                std::memcpy(&word, data_ + pos_, sizeof(word));
+                if constexpr (std::endian::native == std::endian::little) {
+                    word = byteswap64(word);
+                }
+                window_ |= word >> avail_;
+                const int bytes = (63 - avail_) >> 3;
+                pos_ += static_cast<size_t>(bytes);
+                avail_ += bytes * 8;
+                return;
+            }
+            while (avail_ <= 56 && pos_ < size_) {
+                window_ |= static_cast<uint64_t>(data_[pos_++]) << (56 - avail_);
+                avail_ += 8;
+            }
+        }
+
+        static uint64_t byteswap64(uint64_t v) {
+            v = ((v & 0x00FF00FF00FF00FFull) << 8) | ((v >> 8) & 0x00FF00FF00FF00FFull);
+            v = ((v & 0x0000FFFF0000FFFFull) << 16) | ((v >> 16) & 0x0000FFFF0000FFFFull);
+            return (v << 32) | (v >> 32);
+        }
+    };
+
+    /**
+     * @brief 预先计算的 Golomb 参数
+     *
+     * b = ceil(log2(M))，cutoff = 2^b - M；余数使用截断二进制编码：
+     * r < cutoff 时写 b-1 位，否则写 r + cutoff 的 b 位。
+     */
+    struct GolombParams {
+        uint32_t M;
+        int b;
+        uint32_t cutoff;
+
+        constexpr explicit GolombParams(uint32_t m)
+            : M(m), b(m <= 1 ? 0 : static_cast<int>(std::bit_width(m - 1))),
+              cutoff((uint32_t{ 1 } << b) - m) {}
     };
 
     /**
@@ -120,69 +210,67 @@ namespace wiser {
         /**
          * @brief 编码一个整数
          * @param x 要编码的整数 (必须 >= 0)
-         * @param M Golomb 参数 M
+         * @param params 预计算的 Golomb 参数
          * @param writer 位流写入器
          */
-        static void encode(uint32_t x, int M, BitWriter& writer) {
-            uint32_t q = x / M;
-            uint32_t r = x % M;
+        static void encode(uint32_t x, const GolombParams& params, BitWriter& writer) {
+            uint32_t q = x / params.M;
+            uint32_t r = x % params.M;
 
             // 1. 写入商 q (Unary)
             writer.writeUnary(q);
 
             // 2. 写入余数 r (Truncated Binary)
-            int b = 0;
-            // 计算 b = ceil(log2(M))
-            // 简单的做法是寻找满足 2^b >= M 的最小 b
-            int tempM = M;
-            while ((1 << b) < tempM) {
-                b++;
-            }
-
-            int cutoff = (1 << b) - M;
-
-            if (r < static_cast<uint32_t>(cutoff)) {
-                writer.writeBits(r, b - 1);
+            if (r < params.cutoff) {
+                writer.writeBits(r, params.b - 1);
             } else {
-                writer.writeBits(r + cutoff, b);
+                writer.writeBits(r + params.cutoff, params.b);
             }
         }
+
+        /**
+         * @brief 编码一个整数
+         * @param x 要编码的整数 (必须 >= 0)
+         * @param M Golomb 参数 M
+         * @param writer 位流写入器
+         */
+        static void encode(uint32_t x, int M, BitWriter& writer) {
+            encode(x, GolombParams(static_cast<uint32_t>(M)), writer);
+        }
     };
 
     class GolombDecoder {
     public:
         /**
          * @brief 解码一个整数
-         * @param M Golomb 参数 M
+         * @param params 预计算的 Golomb 参数
          * @param reader 位流读取器
          * @return 解码后的整数
          */
-        static uint32_t decode(int M, BitReader& reader) {
+        static uint32_t decode(const GolombParams& params, BitReader& reader) {
             // 1. 读取商 q (Unary)
             uint32_t q = reader.readUnary();
 
-            // 2. 读取余数 r (Truncated Binary)
-            int b = 0;
-            int tempM = M;
-            while ((1 << b) < tempM) {
-                b++;
+            // 2. 读取余数 r (Truncated Binary)：先读 b-1 位，不小于 cutoff 时再读 1 位
+            uint32_t r = 0;
+            if (params.b > 0) {
+                r = reader.readBits(params.b - 1);
+                if (r >= params.cutoff) {
+                    r = ((r << 1) | reader.readBits(1)) - params.cutoff;
+                }
             }
 
-            int cutoff = (1 << b) - M;
-
-            // 先读 b-1 位
-            uint32_t r = reader.readBits(b - 1);
-            if (r < static_cast<uint32_t>(cutoff)) {
-                // r = value
-            } else {
-                // 再读 1 位
-                // 原有的 r 是高 (b-1) 位
-                uint32_t next_bit = reader.readBits(1);
-                r = (r << 1) | next_bit;
-                r = r - cutoff;
-            }
+            return q * params.M + r;
+        }
 
-            return q * M + r;
+        /**
+         * @brief 解码一个整数
+         * @param M Golomb 参数 M
+         * @param reader 位流读取器
+         * @return 解码后的整数
+         */
+        static uint32_t decode(int M, BitReader& reader) {
+            return decode(GolombParams(static_cast<uint32_t>(M)), reader);
         }
     };
 
@@ -19,6 +19,14 @@ namespace wiser {
         BM25    ///< BM25 概率相关性模型（默认）
     };
 
+    /**
+     * @brief 分析器（文本切分为词元的方式）枚举
+     */
+    enum class AnalyzerType {
+        NGRAM, ///< 所有文字一律切分为重叠的 N-gram（默认）
+        HYBRID ///< ASCII 字母/数字连续段输出整词（小写），其余文字（如 CJK）仍为重叠的 N-gram
+    };
+
     /**
      * @brief 系统配置结构体
      *
@@ -46,6 +54,12 @@ namespace wiser {
          */
         std::int32_t token_len = 2; // N-Gram default
 
+        /** 
+         * @brief 分析器类型（默认为纯 N-gram） 
+         * @note 改变此值需要重建索引。
+         */
+        AnalyzerType analyzer = AnalyzerType::NGRAM;
+
         /** 
          * @brief 倒排列表压缩方式（默认为无压缩） 
          * @note 改变此值需要重建索引。
@@ -71,6 +85,20 @@ namespace wiser {
          */
         std::int32_t max_index_count = -1; // -1 = Unlimited
 
+        /** 
+         * @brief 批量导入（WiserEnvironment::addDocuments）时并行分词的线程数
+         * 
+         * 0 表示使用 std::thread::hardware_concurrency()；1 表示在调用线程上逐个分词。
+         */
+        std::int32_t index_threads = 0;
+
+        /** 
+         * @brief 合并产生的段是否写成内存映射倒排文件（见 postings_file.h）
+         * 
+         * 只影响之后写出的段；已有的段无论存放在哪里都可以读取。
+         */
+        bool mmap_postings = false;
+
         // --- 搜索与评分控制 ---
 
         /** 
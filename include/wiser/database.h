@@ -6,6 +6,12 @@
  *
  * 注意：
  *  - 该类管理 sqlite3* 生命周期，提供一组预编译语句以减少开销；
+ *  - 倒排按不可变段存储：每次刷新写入一个新段（segments + segment_postings），后台合并为更大的段；
+ *    tokens 表只保存词元字典，旧版库中 tokens.postings 的数据作为只读的基础段继续参与查询；
+ *  - segment_postings 的每一行是一个词元在某段中的倒排块，附带文档 ID 区间 [first_doc, last_doc]，
+ *    查询可按候选区间跳过整块而不读取其 BLOB；
+ *  - 合并产生的段也可以写成数据库旁的只读倒排文件（segments.file = 1，见 postings_file.h），
+ *    打开时映射到内存，查询读取这些段时不经过 SQL、不加语句锁；
  *  - 非线程安全，跨线程使用时需外部序列化调用；
  *  - 事务：更新倒排时建议成对使用 begin/commit/rollback。
  */
@@ -18,22 +24,87 @@
 #include <vector>
 #include <optional>
 #include <utility>
+#include <functional>
+#include <limits>
+#include <span>
 #include <mutex>
 
 struct sqlite3;
 struct sqlite3_stmt;
 
 namespace wiser {
-    struct TokenInfo {
-        TokenId id;
-        Count docs_count;
+    class MappedPostingsFile;
+
+    /**
+     * @brief 索引段元数据
+     */
+    struct SegmentInfo {
+        SegmentId id;
+        std::int64_t size; ///< 段内倒排总字节数（合并策略按此分层）
     };
 
-    struct PostingsRecord {
+    /**
+     * @brief 段内一个词元的倒排记录
+     */
+    struct SegmentPostingsRecord {
+        TokenId token_id;
         Count docs_count;
+        DocId first_doc; ///< 记录中最小的文档 ID
+        DocId last_doc;  ///< 记录中最大的文档 ID
         std::vector<char> postings;
     };
 
+    /**
+     * @brief 词元全部倒排记录的汇总信息（不读取倒排 BLOB）
+     */
+    struct PostingsStats {
+        Count docs_count = 0; ///< 各记录文档数之和（df）
+        DocId first_doc = 0;  ///< 各记录中最小的文档 ID（含旧版记录时为 kMinDocId）
+        DocId last_doc = 0;   ///< 各记录中最大的文档 ID（含旧版记录时为 kMaxDocId）
+    };
+
+    /**
+     * @brief 已发布的倒排文件段
+     */
+    struct FileSegment {
+        SegmentId id;
+        std::shared_ptr<const MappedPostingsFile> file;
+    };
+
+    /**
+     * @brief 倒排文件段集合的不可变快照（按段 ID 升序）
+     *
+     * 持有快照期间其中文件的映射保持有效，即使这些段已被合并、文件已被删除。
+     */
+    using FileSegments = std::vector<FileSegment>;
+
+    /**
+     * @brief 调用方在访问回调之外读取倒排记录时需持有的数据（见 Database::collectPostings）
+     *
+     * SQLite 结果行中的 BLOB 在语句重置后失效，这部分记录复制到 blobs 中；
+     * 倒排文件段的记录直接指向映射内存，file_segments 保存读取所用的文件段快照以保持映射有效。
+     */
+    struct PostingsSnapshot {
+        std::vector<std::vector<char>> blobs;                           ///< SQL 记录的副本
+        std::vector<std::shared_ptr<const FileSegments>> file_segments; ///< 读取所用的文件段快照（通常只有一个）
+    };
+
+    constexpr DocId kMinDocId = std::numeric_limits<DocId>::min(); ///< 文档区间下界（不限）
+    constexpr DocId kMaxDocId = std::numeric_limits<DocId>::max(); ///< 文档区间上界（不限）
+
+    /**
+     * @brief 倒排记录访问回调
+     *
+     * postings 直接指向 SQLite 结果行中的 BLOB 内存，只在回调期间有效（语句随后被重置）。
+     */
+    using PostingsVisitor = std::function<void(Count docs_count, std::span<const char> postings)>;
+
+    /**
+     * @brief 段倒排记录访问回调（postings 的有效期同 PostingsVisitor）
+     */
+    using SegmentPostingsVisitor = std::function<void(SegmentId segment_id, Count docs_count, DocId first_doc,
+                                                      DocId last_doc, std::span<const char> postings)>;
+
     /**
      * @brief 数据库类
      * 
@@ -130,14 +201,6 @@ namespace wiser {
          */
         bool updateDocumentTokenCount(DocId doc_id, int token_count);
 
-        /**
-         * @brief 查询词元信息
-         * @param token 词元字符串
-         * @param insert 若不存在是否插入
-         * @return 词元信息（包含 ID 与文档数）；若不存在且 insert 为 false 则返回空
-         */
-        [[nodiscard]] std::optional<TokenInfo> getTokenInfo(std::string_view token, bool insert = false);
-
         /**
          * @brief 根据词元 ID 获取词元字符串
          * @param token_id 词元 ID
@@ -146,20 +209,153 @@ namespace wiser {
         std::string getToken(TokenId token_id);
 
         /**
-         * @brief 获取词元的倒排记录
+         * @brief 获取全部词元的 (id, token)
+         * @return 按词元字节序排列的词元 ID 与词元字符串列表（用于预热词元字典）
+         */
+        [[nodiscard]] std::vector<std::pair<TokenId, std::string>> getAllTokens();
+
+        /**
+         * @brief 批量写入已分配 ID 的新词元
+         * @param tokens (id, token) 列表
+         * @return 全部写入成功返回 true，否则返回 false
+         */
+        [[nodiscard]] bool storeTokens(const std::vector<std::pair<TokenId, std::string>>& tokens);
+
+        /**
+         * @brief 获取词元全部倒排记录的汇总信息（只读取各记录的元数据，不读取倒排 BLOB）
+         *
+         * 旧版记录没有文档区间，存在时区间视为不限。
+         * @param token_id 词元 ID
+         * @return 汇总信息；词元没有任何倒排记录时返回 std::nullopt
+         */
+        [[nodiscard]] std::optional<PostingsStats> getPostingsStats(TokenId token_id);
+
+        /**
+         * @brief 不拷贝地依次访问词元与文档区间 [min_doc, max_doc] 相交的倒排记录
+         *
+         * 先访问 tokens 表中的旧版记录（非空时，不按区间过滤），再访问各已发布段中的记录（见 visitSegmentPostings）；
+         * 区间之外的段记录由 SQL 条件排除，不读取其 BLOB。
+         * 回调在语句仍处于当前行时执行，直接读取 sqlite3_column_blob 的内存，调用方应在回调内完成解码
+         * （如解码到可复用的 PostingsList）。回调内不得再次读取倒排记录（会重置同一语句）。
+         * 不同记录的文档可能重叠（同一标题的文档被重新导入时），合并时应按文档 ID 归并。
+         * @param token_id 词元 ID
+         * @param visitor 回调，参数为文档数与倒排 BLOB 视图
+         * @param min_doc 区间下界
+         * @param max_doc 区间上界
+         * @return 至少访问了一条记录返回 true，否则返回 false
+         */
+        bool visitPostings(TokenId token_id, const PostingsVisitor& visitor, DocId min_doc = kMinDocId,
+                           DocId max_doc = kMaxDocId);
+
+        /**
+         * @brief 取得词元与文档区间 [min_doc, max_doc] 相交的倒排记录，供调用方在之后读取（如查询求值期间）
+         *
+         * 记录与顺序同 visitPostings。倒排文件段的记录以 span 直接指向映射内存，不拷贝，
+         * 所用的文件段快照记入 snapshot；SQLite 中的记录复制到 snapshot 中。持有 snapshot 期间 postings 中的视图有效。
          * @param token_id 词元 ID
-         * @return 包含文档数与序列化倒排列表的记录，若不存在返回空
+         * @param postings 输出：追加各记录的倒排视图
+         * @param snapshot 输出：追加视图所指向数据的持有者（可跨多个词元复用）
+         * @param min_doc 区间下界
+         * @param max_doc 区间上界
+         * @return 至少取得了一条记录返回 true，否则返回 false
          */
-        [[nodiscard]] std::optional<PostingsRecord> getPostings(TokenId token_id);
+        bool collectPostings(TokenId token_id, std::vector<std::span<const char>>& postings,
+                             PostingsSnapshot& snapshot, DocId min_doc = kMinDocId, DocId max_doc = kMaxDocId);
 
         /**
-         * @brief 更新词元的倒排记录
+         * @brief 访问词元在各已发布段中的倒排记录（不含旧版记录）
+         *
+         * 先按段 ID 升序访问存放在 segment_postings 中的段，再按段 ID 升序访问倒排文件段；
+         * 文件段的回调在释放语句锁之后执行，postings 指向映射内存，在回调期间有效。
          * @param token_id 词元 ID
-         * @param docs_count 文档数
-         * @param postings 序列化后的倒排列表
-         * @return 更新成功返回 true，否则返回 false
+         * @param visitor 回调，参数为段 ID、文档数、文档 ID 区间与倒排 BLOB 视图
+         * @param min_doc 只访问与 [min_doc, max_doc] 相交的记录
+         * @param max_doc 区间上界
+         * @return 至少访问了一条记录返回 true，否则返回 false
+         */
+        bool visitSegmentPostings(TokenId token_id, const SegmentPostingsVisitor& visitor,
+                                  DocId min_doc = kMinDocId, DocId max_doc = kMaxDocId);
+
+        /**
+         * @brief 创建一个未发布的新段（查询不可见，直到 publishSegment）
+         * @return 段 ID，失败返回 std::nullopt
+         */
+        [[nodiscard]] std::optional<SegmentId> createSegment();
+
+        /**
+         * @brief 向段写入一个词元的倒排记录
+         * @param segment_id 段 ID
+         * @param record 倒排记录（含文档 ID 区间）
+         * @return 写入成功返回 true，否则返回 false
+         */
+        [[nodiscard]] bool addSegmentPostings(SegmentId segment_id, const SegmentPostingsRecord& record);
+
+        /**
+         * @brief 在一个事务内向段批量写入倒排记录
+         *
+         * 整个事务期间持有语句锁，其他线程的语句不会混入该事务；调用方须保证此时没有未结束的事务。
+         * @param segment_id 段 ID
+         * @param records 倒排记录
+         * @return 全部写入并提交成功返回 true，否则回滚并返回 false
+         */
+        [[nodiscard]] bool addSegmentPostingsBatch(SegmentId segment_id,
+                                                   const std::vector<SegmentPostingsRecord>& records);
+
+        /**
+         * @brief 发布段，使其对查询可见
+         * @param segment_id 段 ID
+         * @param size 段内倒排总字节数
+         * @param file 段的倒排存放在 segmentFilePath(segment_id) 中（由 replaceSegments 负责映射）
+         * @return 成功返回 true
+         */
+        [[nodiscard]] bool publishSegment(SegmentId segment_id, std::int64_t size, bool file = false);
+
+        /**
+         * @brief 在一个事务内发布合并得到的新段并删除被合并的段
+         *
+         * 整个事务期间持有语句锁，查询要么看到全部旧段、要么只看到新段；调用方须保证此时没有未结束的事务。
+         * 被合并的倒排文件段在提交后删除文件（仍在读取它们的查询持有映射，可以安全读完）。
+         * @param segment_id 新段 ID
+         * @param size 新段内倒排总字节数
+         * @param replaced 被合并的段
+         * @param file 新段的倒排已写入 segmentFilePath(segment_id)（而不是 segment_postings）
+         * @return 提交成功返回 true；任一被合并的段已不是已发布状态或写入失败时回滚并返回 false
+         */
+        [[nodiscard]] bool replaceSegments(SegmentId segment_id, std::int64_t size,
+                                           const std::vector<SegmentId>& replaced, bool file = false);
+
+        /**
+         * @brief 删除一个未发布的段及其全部倒排记录（含可能已写出的倒排文件）
+         * @param segment_id 段 ID
+         * @return 成功返回 true
+         */
+        bool dropSegment(SegmentId segment_id);
+
+        /**
+         * @brief 删除所有未发布的段（上次运行中断时遗留的合并结果），以及不属于任何已发布段的倒排文件
+         * @return 成功返回 true
          */
-        [[nodiscard]] bool updatePostings(TokenId token_id, Count docs_count, const std::vector<char>& postings);
+        bool dropUnpublishedSegments();
+
+        /**
+         * @brief 段的倒排文件路径（数据库文件旁的 <db_path>.seg<id>）
+         * @param segment_id 段 ID
+         * @return 文件路径
+         */
+        [[nodiscard]] std::string segmentFilePath(SegmentId segment_id) const;
+
+        /**
+         * @brief 获取全部已发布的段
+         * @return 段元数据（按段 ID 升序）
+         */
+        [[nodiscard]] std::vector<SegmentInfo> getSegments();
+
+        /**
+         * @brief 获取段内全部词元
+         * @param segment_id 段 ID
+         * @return 词元 ID（升序）
+         */
+        [[nodiscard]] std::vector<TokenId> getSegmentTokens(SegmentId segment_id);
 
         /**
          * @brief 获取当前数据库存储的配置
@@ -226,6 +422,11 @@ namespace wiser {
     private:
         mutable std::recursive_mutex stmt_mutex_; // Statement protection
         sqlite3* db_;
+        std::string db_path_;
+
+        // 文件段集合的快照：只在持有 stmt_mutex_ 时替换（与段表的变化同步），读取方在持有 stmt_mutex_ 时复制快照，
+        // 之后无锁读取映射内存
+        std::shared_ptr<const FileSegments> file_segments_;
 
         // 预编译语句
         sqlite3_stmt* get_document_id_stmt_;
@@ -233,11 +434,19 @@ namespace wiser {
         sqlite3_stmt* get_document_body_stmt_;
         sqlite3_stmt* insert_document_stmt_;
         sqlite3_stmt* update_document_stmt_;
-        sqlite3_stmt* get_token_id_stmt_;
         sqlite3_stmt* get_token_stmt_;
-        sqlite3_stmt* store_token_stmt_;
+        sqlite3_stmt* store_token_with_id_stmt_;
+        sqlite3_stmt* list_tokens_stmt_;
         sqlite3_stmt* get_postings_stmt_;
-        sqlite3_stmt* update_postings_stmt_;
+        sqlite3_stmt* get_segment_postings_stmt_;
+        sqlite3_stmt* get_postings_stats_stmt_;
+        sqlite3_stmt* create_segment_stmt_;
+        sqlite3_stmt* insert_segment_postings_stmt_;
+        sqlite3_stmt* publish_segment_stmt_;
+        sqlite3_stmt* delete_segment_postings_stmt_;
+        sqlite3_stmt* delete_segment_stmt_;
+        sqlite3_stmt* list_segments_stmt_;
+        sqlite3_stmt* list_segment_tokens_stmt_;
         sqlite3_stmt* get_settings_stmt_;
         sqlite3_stmt* replace_settings_stmt_;
         sqlite3_stmt* get_document_count_stmt_;
@@ -253,7 +462,16 @@ namespace wiser {
 
         // 辅助函数
         bool createTables();
+        bool addColumnIfMissing(const char* table, const char* column, const std::string& definition);
         bool prepareStatements();
+        bool loadFileSegments();
+        bool visitLegacyPostings(TokenId token_id, const PostingsVisitor& visitor);
+        std::shared_ptr<const FileSegments> visitStoredSegmentPostings(TokenId token_id,
+                                                                       const SegmentPostingsVisitor& visitor,
+                                                                       DocId min_doc, DocId max_doc, bool& visited);
+        static bool visitFileSegmentPostings(const FileSegments* file_segments, TokenId token_id,
+                                             const SegmentPostingsVisitor& visitor, DocId min_doc, DocId max_doc);
+        bool dropSegmentRows(SegmentId segment_id);
         void finalizeStatements();
 
         // 禁用复制的辅助函数
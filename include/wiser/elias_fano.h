@@ -0,0 +1,98 @@
+#pragma once
+
+/**
+ * @file elias_fano.h
+ * @brief Elias-Fano 单调序列编码与支持 nextGEQ 的只读视图
+ *
+ * n 个不超过 universe 的非降整数，低位宽 l = floor(log2(universe / n))（universe < n 时为 0）：
+ *  - 低位区：每个整数的低 l 位依次打包，共 ceil(n * l / 64) 个 64 位字；
+ *  - 高位区：第 i 个整数的高位 h_i 置位于第 h_i + i 位，共 ceil((n + (universe >> l) + 1) / 64) 个 64 位字。
+ * 所有 64 位字按本机字节序存储；n 与 universe 由调用方另行记录，不写入数据。
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace wiser {
+    /**
+     * @brief 计算编码后的字节数
+     * @param count 整数个数
+     * @param universe 整数上界（含）
+     * @return 字节数
+     */
+    size_t eliasFanoSize(size_t count, std::uint32_t universe);
+
+    /**
+     * @brief 将非降序列编码后追加到输出
+     * @param values 非降整数序列，每个不超过 universe
+     * @param universe 整数上界（含）
+     * @param out 输出缓冲区（追加 eliasFanoSize 个字节）
+     */
+    void eliasFanoEncode(std::span<const std::uint32_t> values, std::uint32_t universe, std::vector<char>& out);
+
+    /**
+     * @brief Elias-Fano 序列的只读前向游标
+     *
+     * 直接读取编码数据，不解码整个序列；nextGEQ 先在高位区定位目标高位所在的桶（按字 popcount 跳过），
+     * 只比较同一桶内的少量元素。
+     *
+     * @note 视图不拥有数据，调用方须保证数据在视图生命周期内有效。
+     */
+    class EliasFanoView {
+    public:
+        EliasFanoView() = default;
+
+        /**
+         * @brief 构造视图并定位到第一个元素
+         * @param data 编码数据（至少 eliasFanoSize(count, universe) 个字节）
+         * @param count 整数个数
+         * @param universe 整数上界（含）
+         */
+        EliasFanoView(const char* data, size_t count, std::uint32_t universe);
+
+        /**
+         * @brief 当前元素下标
+         * @return 下标；耗尽时等于 size()
+         */
+        size_t index() const { return index_; }
+
+        size_t size() const { return count_; }
+
+        /**
+         * @brief 当前元素值（须未耗尽）
+         */
+        std::uint32_t value() const { return value_; }
+
+        /**
+         * @brief 前进到下一个元素
+         */
+        void next();
+
+        /**
+         * @brief 前进到第一个不小于 target 的元素（不会后退）
+         * @param target 目标值
+         */
+        void nextGEQ(std::uint32_t target);
+
+    private:
+        const char* low_ = nullptr;
+        const char* high_ = nullptr;
+        size_t count_ = 0;
+        size_t high_bits_ = 0; ///< 高位区有效位数
+        int l_ = 0;
+
+        size_t index_ = 0;
+        size_t high_pos_ = 0;  ///< 当前元素在高位区中的位位置
+        std::uint32_t value_ = 0;
+
+        std::uint64_t word(const char* base, size_t i) const;
+        std::uint32_t lowBits(size_t i) const;
+
+        /**
+         * @brief 从高位区第 pos 位（含）起找到下一个置位并更新当前元素
+         */
+        void seekHigh(size_t pos);
+    };
+} // namespace wiser
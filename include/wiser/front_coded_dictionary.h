@@ -0,0 +1,74 @@
+#pragma once
+
+/**
+ * @file front_coded_dictionary.h
+ * @brief 前缀压缩（front coding）的只读有序词元字典。
+ *
+ * 词元按字节序排列，每 kFrontCodingBlockSize 个分为一块：
+ *   块首项：[length:varint][bytes]
+ *   其余项：[shared:varint][suffix_length:varint][suffix bytes]，shared 为与前一项相同的前缀长度
+ * 查找时先按块首项二分定位块，再在块内顺序解码比较；词元 ID 按序存放在单独的数组中。
+ * 相邻 n-gram 往往共享前缀，存储远小于逐个保存完整词元与哈希槽位。
+ */
+
+#include "types.h"
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace wiser {
+    constexpr size_t kFrontCodingBlockSize = 16; ///< 每块词元数
+
+    /**
+     * @class FrontCodedDictionary
+     * @brief 构建后只读的前缀压缩词元字典（可并发查询）
+     */
+    class FrontCodedDictionary {
+    public:
+        FrontCodedDictionary() = default;
+
+        /**
+         * @brief 由 (id, token) 列表构建（替换已有内容）
+         * @param tokens 词元 ID 与词元；未按词元字节序排列时先排序，重复的词元只保留第一个
+         */
+        void build(std::vector<std::pair<TokenId, std::string>> tokens);
+
+        /**
+         * @brief 查找词元 ID
+         * @param token 词元（UTF-8）
+         * @return 词元 ID；不存在返回空
+         */
+        [[nodiscard]] std::optional<TokenId> find(std::string_view token) const;
+
+        /**
+         * @brief 清空字典
+         */
+        void clear();
+
+        /**
+         * @brief 词元数
+         */
+        [[nodiscard]] size_t size() const { return ids_.size(); }
+
+        /**
+         * @brief 占用的字节数（压缩数据、块偏移与 ID 数组）
+         */
+        [[nodiscard]] size_t memoryUsage() const;
+
+        /**
+         * @brief 最大的词元 ID（字典为空时为 0）
+         */
+        [[nodiscard]] TokenId maxId() const { return max_id_; }
+
+    private:
+        std::string data_;                  ///< 各块的前缀压缩数据
+        std::vector<size_t> block_offsets_; ///< 每块在 data_ 中的起始偏移
+        std::vector<TokenId> ids_;          ///< 按词元字节序排列的 ID
+        TokenId max_id_ = 0;
+
+        [[nodiscard]] std::string_view firstKey(size_t block) const;
+    };
+} // namespace wiser
@@ -2,62 +2,29 @@
 
 /**
  * @file postings.h
- * @brief 倒排项/倒排列表/倒排索引的数据结构与序列化接口。
+ * @brief 倒排列表/倒排索引的数据结构与序列化接口。
  */
 
 #include "types.h"
+#include <cstdint>
 #include <vector>
 #include <memory>
+#include <span>
 #include <unordered_map>
 
 namespace wiser {
-    /**
-     * @brief 倒排列表项
-     * 
-     * 代表一个文档中的词元出现位置集合。
-     */
-    class PostingsItem {
-    public:
-        /**
-         * @brief 构造倒排列表项
-         * @param doc_id 文档 ID
-         * @param positions 词元位置信息数组
-         */
-        PostingsItem(DocId doc_id, std::vector<Position> positions);
-
-        /** 
-         * @brief 获取文档 ID
-         * @return 文档 ID
-         */
-        DocId getDocumentId() const { return document_id_; }
-
-        /** 
-         * @brief 获取位置信息数组
-         * @return 位置信息常引用
-         */
-        const std::vector<Position>& getPositions() const { return positions_; }
-
-        /** 
-         * @brief 获取位置个数
-         * @return 位置数量
-         */
-        Count getPositionsCount() const { return static_cast<Count>(positions_.size()); }
-
-        /**
-         * @brief 添加一个出现位置
-         * @param position 在文档中的位置
-         */
-        void addPosition(Position position);
-
-    private:
-        DocId document_id_;               ///< 文档编号
-        std::vector<Position> positions_; ///< 位置信息数组
-    };
-
     /**
      * @brief 倒排列表
      * 
      * 包含某个词元的所有文档及位置信息。
+     *
+     * 采用列式存储：
+     *  - doc_ids_：按升序排列的文档 ID 数组；
+     *  - position_ends_：第 i 个文档的位置在 positions_ 中的结束偏移（起始偏移为前一项的结束偏移），
+     *    因此 tf = position_ends_[i] - position_ends_[i-1]；
+     *  - positions_：所有文档共享的一块连续位置池。
+     *
+     * 文档 ID 递增到达（索引构建的常规情况）时，addPosting 为 O(1) 追加，不产生逐文档的堆分配。
      */
     class PostingsList {
     public:
@@ -72,6 +39,8 @@ namespace wiser {
 
         /**
          * @brief 向倒排列表添加一条记录
+         *
+         * 若 document_id 不小于当前最后一个文档 ID，走 O(1) 追加快路径；否则按序插入。
          * @param document_id 文档 ID
          * @param position 词元在文档中的位置
          */
@@ -80,29 +49,73 @@ namespace wiser {
         /**
          * @brief 合并另一个倒排列表（同一词元）
          * 
-         * 对同一 doc_id 的位置向量进行拼接，必要时保持升序。
+         * 对同一 doc_id 的位置按升序归并；当 other 的文档 ID 全部大于当前列表时直接整段追加。
          * @param other 另一个倒排列表（将被移动）
          */
         void merge(PostingsList&& other);
 
-        /** 
-         * @brief 获取内部项的只读数组
-         * @return 倒排列表项的智能指针数组
+        /**
+         * @brief 追加一个新文档及其全部位置（须保证 document_id 大于当前最后一个文档 ID）
+         * @param document_id 文档 ID
+         * @param positions 该文档的位置（升序）
          */
-        const std::vector<std::unique_ptr<PostingsItem>>& getItems() const { return items_; }
+        void appendDocument(DocId document_id, std::span<const Position> positions);
 
         /** 
          * @brief 获取涉及的文档数量
          * @return 文档数量
          */
-        Count getDocumentsCount() const { return static_cast<Count>(items_.size()); }
+        Count getDocumentsCount() const { return static_cast<Count>(doc_ids_.size()); }
+
+        /**
+         * @brief 是否为空
+         * @return 不含任何文档时返回 true
+         */
+        bool empty() const { return doc_ids_.empty(); }
+
+        /**
+         * @brief 获取升序文档 ID 数组
+         * @return 文档 ID 数组常引用
+         */
+        const std::vector<DocId>& getDocumentIds() const { return doc_ids_; }
+
+        /**
+         * @brief 获取第 i 个文档的 ID
+         * @param i 下标（须小于 getDocumentsCount()）
+         * @return 文档 ID
+         */
+        DocId getDocumentId(size_t i) const { return doc_ids_[i]; }
+
+        /**
+         * @brief 获取第 i 个文档的位置个数（即词频 tf）
+         * @param i 下标（须小于 getDocumentsCount()）
+         * @return 位置数量
+         */
+        Count getPositionsCount(size_t i) const {
+            return static_cast<Count>(position_ends_[i] - positionsBegin(i));
+        }
+
+        /**
+         * @brief 获取第 i 个文档的位置数组视图
+         * @param i 下标（须小于 getDocumentsCount()）
+         * @return 指向共享位置池的只读视图
+         */
+        std::span<const Position> getPositions(size_t i) const {
+            return { positions_.data() + positionsBegin(i), positions_.data() + position_ends_[i] };
+        }
+
+        /**
+         * @brief 清空列表
+         */
+        void clear();
 
         /**
          * @brief 序列化倒排列表
          * @param method 压缩方法 (默认: NONE)
+         * @param doc_bitmap 是否附带文档位图（高文档频率词元，见 useDocBitmap）
          * @return 序列化后的字节数组
          */
-        std::vector<char> serialize(CompressMethod method = CompressMethod::NONE) const;
+        std::vector<char> serialize(CompressMethod method = CompressMethod::NONE, bool doc_bitmap = false) const;
 
         /**
          * @brief 从字节数组反序列化
@@ -111,15 +124,30 @@ namespace wiser {
          */
         void deserialize(const std::vector<char>& data, CompressMethod method = CompressMethod::NONE);
 
+        /**
+         * @brief 从字节区间反序列化（自动识别分块格式与旧格式）
+         *
+         * 直接读取给定内存（可为 SQLite BLOB 或映射文件），不做整体拷贝。原有内容被清空但容量保留，
+         * 同一列表可反复用于解码不同词元而不重新分配数组。
+         * @param data 数据起始地址
+         * @param size 数据字节数
+         * @param method 压缩方法
+         */
+        void deserialize(const char* data, size_t size, CompressMethod method);
+
     private:
-        std::vector<std::unique_ptr<PostingsItem>> items_;
+        std::vector<DocId> doc_ids_;                 ///< 升序文档 ID
+        std::vector<std::uint32_t> position_ends_;   ///< 每个文档位置段在 positions_ 中的结束偏移
+        std::vector<Position> positions_;            ///< 共享位置池
+
+        std::uint32_t positionsBegin(size_t i) const { return i == 0 ? 0u : position_ends_[i - 1]; }
 
         /**
-         * @brief 查找或创建指定文档 ID 的项
+         * @brief 乱序到达时的慢路径：按序插入或追加到已有文档
          * @param document_id 文档 ID
-         * @return 指向该项的指针
+         * @param position 位置
          */
-        PostingsItem* findOrCreateItem(DocId document_id);
+        void insertPosting(DocId document_id, Position position);
     };
 
     /**
@@ -146,6 +174,25 @@ namespace wiser {
          */
         void addPosting(TokenId token_id, DocId document_id, Position position);
 
+        /**
+         * @brief 添加某个词元在一个文档中的全部位置
+         *
+         * 文档 ID 大于该词元已有的最后一个文档时整段追加，否则逐个位置插入。
+         * @param token_id 词元 ID
+         * @param document_id 文档 ID
+         * @param positions 位置（升序）
+         */
+        void addDocument(TokenId token_id, DocId document_id, std::span<const Position> positions);
+
+        /**
+         * @brief 合并另一个倒排索引
+         *
+         * 逐词元调用 PostingsList::merge：other 的文档 ID 全部大于本索引时（如按文档 ID 区间依次合并
+         * 并行分词的局部索引）每个倒排列表都是整段追加；本索引没有的词元直接接管其倒排列表。
+         * @param other 另一个倒排索引（将被移动）
+         */
+        void merge(InvertedIndex&& other);
+
         /**
          * @brief 获取（可写）倒排列表
          * @param token_id 词元 ID
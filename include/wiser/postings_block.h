@@ -0,0 +1,234 @@
+#pragma once
+
+/**
+ * @file postings_block.h
+ * @brief 分块倒排格式与按块跳跃的倒排游标。
+ *
+ * 分块格式（所有定宽字段按本机字节序存储）：
+ *   [marker:int32 = kTaggedPostingsMarker][docs_count:Count][docs_section_size:uint32]
+ *   [codec:uint8][flags:uint8][reserved:uint16]，flags 含 kPostingsFlagDocBitmap 时追加 [bitmap_size:uint32]
+ *   跳表：每块一项 [last_doc:DocId][doc_offset:uint32][pos_offset:uint32][max_tf:Count]
+ *   （max_tf 为块内最大词频，目前只随数据写入，读取时不使用）
+ *   文档区：各块的 (doc_id, tf) 依次拼接，doc_offset 相对文档区起点
+ *   位置区：各块的位置依次拼接，pos_offset 相对位置区起点
+ *   文档位图（可选）：高文档频率的词元（见 useDocBitmap）附带全部文档 ID 的 Roaring 位图，供多词查询直接按位图求交
+ *
+ * codec 为编码该列表的 CompressMethod，读取时按它在 PostingsCodecRegistry 中选择编解码器，
+ * 与调用方传入的方法无关；因此同一索引中的列表可以使用不同的编码（AUTO 按列表选择，切换方法也无需重建索引）。
+ *
+ * 文档与位置分开存放：只需要 tf 的查询（如未启用短语搜索）完全不触及位置区。
+ *
+ * 每块最多 kPostingsBlockSize 个文档，块内编码由编解码器决定（见 postings_codec.h）：
+ *  - NONE：文档区逐文档 [doc_id][tf]；位置区逐文档 [position * tf]
+ *  - GOLOMB：文档区与位置区各为块内独立位流（字节对齐），
+ *    doc_id 相对上一块末尾文档做差分，位置在每个文档内做差分
+ *  - GOLOMB_ADAPTIVE：同 GOLOMB，但 M 按列表的实际间隔估计（见 chooseGolombParams），
+ *    以 [m_doc:uint32][m_tf:uint32][m_pos:uint32] 写在文档区起始处（块偏移已包含这 12 字节）
+ *  - BP128：文档区为 doc_id 差分与 tf 两组位打包数据，位置区为整块位置差分的位打包数据（见 bitpacking.h），
+ *    差分方式同 GOLOMB
+ *  - ELIAS_FANO：文档区为 doc_id（相对上一块末尾文档，上界取本块 last_doc）的 Elias-Fano 序列（见 elias_fano.h）
+ *    与位打包 tf；位置区同 BP128。游标块内 advance 直接在 Elias-Fano 高位区上 nextGEQ，不解码整块文档 ID
+ *
+ * 旧格式（首个 int32 为文档数，非负）仍可读取，见 PostingsList::deserialize。
+ */
+
+#include "types.h"
+#include "postings.h"
+#include "postings_codec.h"
+#include "postings_cursor.h"
+#include "roaring_bitmap.h"
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace wiser {
+    /**
+     * @brief 带编码器标签的分块格式标记（位于 BLOB 起始处，负数以区别旧格式的文档数）
+     */
+    constexpr std::int32_t kTaggedPostingsMarker = -4;
+
+    /**
+     * @brief 带标签分块格式 flags 字段：附带文档位图
+     */
+    constexpr std::uint8_t kPostingsFlagDocBitmap = 0x01;
+
+    /**
+     * @brief 附带文档位图的最小文档频率占比（df / 总文档数）
+     */
+    constexpr double kDocBitmapMinDfRatio = 1.0 / 16;
+
+    /**
+     * @brief 附带文档位图的最小文档数（避免小语料中每个词元都带位图）
+     */
+    constexpr size_t kDocBitmapMinDocs = 128;
+
+    /**
+     * @brief 每块文档数
+     */
+    constexpr size_t kPostingsBlockSize = 128;
+
+    /**
+     * @brief AUTO 选择时，解码较快的编码器体积不超过最小体积的该倍数即优先选用
+     */
+    constexpr double kAutoFastDecodeSlack = 1.1;
+
+    /**
+     * @brief 判断序列化数据是否为分块格式
+     * @param data 数据起始地址
+     * @param size 数据字节数
+     * @return 分块格式返回 true
+     */
+    bool isBlockedPostings(const char* data, size_t size);
+
+    /**
+     * @brief 判断倒排列表是否应附带文档位图
+     * @param docs_count 列表文档数（df）
+     * @param total_docs 总文档数
+     * @return 需要附带返回 true
+     */
+    bool useDocBitmap(Count docs_count, Count total_docs);
+
+    /**
+     * @brief 将倒排列表编码为分块格式
+     * @param list 倒排列表
+     * @param method 块内压缩方法；AUTO 时按列表逐个尝试已注册的编解码器，取体积最小者，
+     *               若解码较快的编码器体积在 kAutoFastDecodeSlack 倍以内则取之
+     * @param doc_bitmap 是否附带文档位图
+     * @return 序列化后的字节数组
+     */
+    std::vector<char> encodeBlockedPostings(const PostingsList& list, CompressMethod method, bool doc_bitmap = false);
+
+    /**
+     * @brief 将文档 ID 全部大于原列表末尾的新文档追加到已编码的分块数据
+     *
+     * 原有的完整块（跳表项、文档区与位置区字节）原样复制，只有未满的最后一块被解码后与新文档一起重新编码；
+     * 位图（若有）追加新文档 ID 后重新序列化。列表参数（如 GOLOMB_ADAPTIVE 的 M）沿用原列表。
+     * @param data 原数据起始地址
+     * @param size 原数据字节数
+     * @param tail 新文档（非空、按文档 ID 升序）
+     * @param method 配置的压缩方法；与原列表的编码不同时不追加（AUTO 沿用原编码）
+     * @param doc_bitmap 追加后的列表是否附带文档位图
+     * @return 追加后的数据；原数据非法、编码或位图设置变化、或新文档与原列表有重叠时返回 std::nullopt，
+     *         调用方应退回完整解码合并后重新编码
+     */
+    std::optional<std::vector<char>> appendBlockedPostings(const char* data, size_t size, const PostingsList& tail,
+                                                           CompressMethod method, bool doc_bitmap);
+
+    /**
+     * @brief 读取分块格式数据附带的文档位图
+     * @param data 序列化数据
+     * @return 无位图或数据非法时返回 std::nullopt
+     */
+    std::optional<RoaringBitmap> readDocBitmap(std::span<const char> data);
+
+    /**
+     * @brief 将分块格式数据整体解码并追加到倒排列表
+     * @param data 数据起始地址
+     * @param size 数据字节数
+     * @param out 输出倒排列表（追加，已有文档 ID 须小于数据中的文档 ID）
+     * @return 数据完整返回 true；损坏时保留已完整解码的文档并返回 false
+     */
+    bool decodeBlockedPostings(const char* data, size_t size, PostingsList& out);
+
+    /**
+     * @brief 分块倒排游标
+     *
+     * 直接读取序列化数据，仅在需要时解码单个块的 (doc_id, tf)；advance 先在跳表上二分定位目标块，
+     * 被跳过的块不做任何解码。位置只在调用 positions() 时才解码（NONE 按文档读取，其他方法按块解码一次）。
+     * 旧格式数据整体解码为一个块，接口行为一致。
+     *
+     * @note 游标不拥有数据，调用方须保证 data 在游标生命周期内有效。
+     */
+    class BlockPostingsCursor final : public PostingsCursor {
+    public:
+        /**
+         * @brief 构造游标并定位到第一个文档
+         * @param data 序列化数据起始地址
+         * @param size 数据字节数
+         * @param method 旧格式的压缩方法（分块格式按头部标签选择编解码器）
+         */
+        BlockPostingsCursor(const char* data, size_t size, CompressMethod method);
+
+        /**
+         * @brief 构造游标并定位到第一个文档
+         * @param data 序列化数据（如 SQLite BLOB 的副本或倒排文件的映射内存）
+         * @param method 旧格式的压缩方法（分块格式按头部标签选择编解码器）
+         */
+        BlockPostingsCursor(std::span<const char> data, CompressMethod method)
+            : BlockPostingsCursor(data.data(), data.size(), method) {}
+
+        /**
+         * @brief 获取列表中的文档总数
+         * @return 文档数
+         */
+        Count size() const override { return docs_count_; }
+
+        /**
+         * @brief 当前文档 ID
+         * @return 文档 ID；耗尽时返回 kEndDocId
+         */
+        DocId docId() const override { return cur_doc_; }
+
+        /**
+         * @brief 前进到下一个文档
+         */
+        void next() override;
+
+        /**
+         * @brief 前进到第一个 ID 不小于 target 的文档（不会后退）
+         * @param target 目标文档 ID
+         */
+        void advance(DocId target) override;
+
+        /**
+         * @brief 当前文档的词频（须未耗尽）
+         * @return tf
+         */
+        Count tf() const override { return static_cast<Count>(block_pos_ends_[index_] - positionsBegin(index_)); }
+
+        /**
+         * @brief 当前文档的位置（须未耗尽），首次访问时才解码
+         * @return 升序位置视图，游标移动前有效
+         */
+        std::span<const Position> positions() override;
+
+    private:
+        const PostingsCodec* codec_ = nullptr;
+        PostingsCodecParams params_;
+        bool legacy_ = false;          ///< 旧格式：整体解码为唯一的块（位置已就绪）
+        bool ef_docs_ = false;         ///< 编解码器支持文档视图（ELIAS_FANO）：块内文档 ID 由 block_ef_ 按需读取
+        Count docs_count_ = 0;
+        size_t block_count_ = 0;
+        const char* skip_table_ = nullptr;
+        const char* docs_begin_ = nullptr;
+        size_t docs_size_ = 0;         ///< 文档区字节数
+        const char* positions_begin_ = nullptr;
+        size_t positions_size_ = 0;    ///< 位置区字节数
+
+        // 当前块解码结果
+        DocId cur_doc_ = kEndDocId;
+        size_t block_size_ = 0;        ///< 当前块文档数
+        std::vector<DocId> block_docs_; ///< 块内文档 ID（ELIAS_FANO 时为空）
+        EliasFanoView block_ef_;
+        DocId block_base_ = 0;         ///< ELIAS_FANO 序列的基准（上一块末尾文档）
+        std::vector<std::uint32_t> block_pos_ends_; ///< 块内 tf 前缀和
+        std::vector<Position> block_positions_;     ///< 整块位置（GOLOMB/BP128/旧格式）
+        bool block_positions_ready_ = false;
+        std::vector<Position> doc_positions_;       ///< 单文档位置（定宽位置的编解码器，如 NONE）
+        size_t block_index_ = 0;       ///< 当前块号（== block_count_ 表示耗尽）
+        size_t index_ = 0;             ///< 块内下标
+
+        std::uint32_t positionsBegin(size_t i) const { return i == 0 ? 0u : block_pos_ends_[i - 1]; }
+        DocId lastDocOf(size_t block) const;
+        void syncDocId();
+
+        /**
+         * @brief 解码第 block 块的 (doc_id, tf) 并定位到块首；失败或越界时游标耗尽
+         * @param block 块号
+         */
+        void loadBlock(size_t block);
+    };
+} // namespace wiser
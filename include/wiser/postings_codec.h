@@ -0,0 +1,217 @@
+#pragma once
+
+/**
+ * @file postings_codec.h
+ * @brief 倒排列表编解码器接口与注册表。
+ *
+ * 分块格式（见 postings_block.h）的跳表、分区与文档位图与编码方式无关；块内 (doc_id, tf) 与位置的编码
+ * 由 PostingsCodec 实现，按 CompressMethod 在 PostingsCodecRegistry 中查找。带标签的分块数据在头部记录
+ * 编码器标签，读取时按标签选择编码器，同一索引中不同列表可以使用不同的编码器。
+ *
+ * 新增编码方式只需实现 PostingsCodec 并在启动阶段注册（注册表不加锁，注册须在并发读取之前完成）。
+ */
+
+#include "types.h"
+#include "postings.h"
+#include "compression_utils.h"
+#include "elias_fano.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace wiser {
+    /**
+     * @brief GOLOMB 编码使用的固定参数（分块格式与旧格式相同）
+     */
+    constexpr GolombParams kGolombDocParams{ 128 };  ///< DocID 差分
+    constexpr GolombParams kGolombCountParams{ 8 };  ///< 位置个数（tf）
+    constexpr GolombParams kGolombPosParams{ 16 };   ///< Position 差分
+
+    /**
+     * @brief 一个倒排列表使用的 Golomb 参数（默认为 GOLOMB 的固定参数）
+     */
+    struct GolombListParams {
+        GolombParams doc = kGolombDocParams;
+        GolombParams count = kGolombCountParams;
+        GolombParams pos = kGolombPosParams;
+    };
+
+    /**
+     * @brief 按列表的平均文档间隔、平均 tf 与平均位置间隔估计 GOLOMB_ADAPTIVE 参数
+     * @param list 倒排列表
+     * @return 估计的参数（M ≈ 0.69 × 平均值，至少为 1）
+     */
+    GolombListParams chooseGolombParams(const PostingsList& list);
+
+    /**
+     * @brief 列表级编码参数（由编码器的列表前言写入/读取）
+     */
+    struct PostingsCodecParams {
+        GolombListParams golomb;
+    };
+
+    /**
+     * @brief 块内编解码器
+     *
+     * 块之间互不依赖：文档 ID 的基准 prev_doc 为上一块跳表项的 last_doc（首块为 0）。
+     * 解码失败时记录错误日志并返回 false，输出只保留已完整解码的部分。
+     */
+    class PostingsCodec {
+    public:
+        virtual ~PostingsCodec() = default;
+
+        /**
+         * @brief 编码器标签（写入带标签分块数据的头部）
+         */
+        virtual CompressMethod method() const = 0;
+
+        /**
+         * @brief 编码器名称（与命令行 -c 参数一致）
+         */
+        virtual std::string_view name() const = 0;
+
+        /**
+         * @brief 解码是否足够快（AUTO 选择时体积相近则优先）
+         */
+        virtual bool fastDecode() const { return false; }
+
+        /**
+         * @brief 位置是否为定宽存储（游标可按 tf 前缀和直接定位单个文档的位置）
+         */
+        virtual bool fixedWidthPositions() const { return false; }
+
+        /**
+         * @brief 编码列表前言（写在文档区起始处，块偏移已包含前言）
+         * @param list 倒排列表（非空）
+         * @param params 输出列表参数
+         * @param out 文档区缓冲区（追加）
+         */
+        virtual void encodePrologue(const PostingsList& /*list*/, PostingsCodecParams& /*params*/,
+                                    std::vector<char>& /*out*/) const {}
+
+        /**
+         * @brief 读取列表前言
+         * @param data 文档区起始地址
+         * @param size 文档区字节数
+         * @param params 输出列表参数
+         * @return 前言合法返回 true
+         */
+        virtual bool decodePrologue(const char* /*data*/, size_t /*size*/, PostingsCodecParams& /*params*/) const {
+            return true;
+        }
+
+        /**
+         * @brief 编码一个块的 (doc_id, tf)
+         * @param list 倒排列表
+         * @param first 块内首个文档下标
+         * @param last 块内末个文档下标（不含）
+         * @param prev_doc 上一块的最后一个文档 ID（首块为 0）
+         * @param params 列表参数
+         * @param out 文档区缓冲区（追加）
+         */
+        virtual void encodeDocs(const PostingsList& list, size_t first, size_t last, DocId prev_doc,
+                                const PostingsCodecParams& params, std::vector<char>& out) const = 0;
+
+        /**
+         * @brief 编码一个块的全部位置
+         * @param list 倒排列表
+         * @param first 块内首个文档下标
+         * @param last 块内末个文档下标（不含）
+         * @param params 列表参数
+         * @param out 位置区缓冲区（追加）
+         */
+        virtual void encodePositions(const PostingsList& list, size_t first, size_t last,
+                                     const PostingsCodecParams& params, std::vector<char>& out) const = 0;
+
+        /**
+         * @brief 解码一个块的 (doc_id, tf)
+         * @param p 块在文档区中的起始地址
+         * @param size 块字节数
+         * @param params 列表参数
+         * @param prev_doc 上一块的最后一个文档 ID（首块为 0）
+         * @param last_doc 本块的最后一个文档 ID（跳表记录）
+         * @param docs 本块文档数
+         * @param doc_ids 输出文档 ID（追加）
+         * @param pos_ends 输出块内 tf 前缀和（追加）
+         * @return 完整解码返回 true
+         */
+        virtual bool decodeDocs(const char* p, size_t size, const PostingsCodecParams& params, DocId prev_doc,
+                                DocId last_doc, size_t docs, std::vector<DocId>& doc_ids,
+                                std::vector<std::uint32_t>& pos_ends) const = 0;
+
+        /**
+         * @brief 解码一个块的全部位置
+         * @param p 块在位置区中的起始地址
+         * @param size 块字节数
+         * @param params 列表参数
+         * @param pos_ends 块内 tf 前缀和（由 decodeDocs 得到）
+         * @param positions 输出位置（覆盖）；失败时只保留已完整解码的文档的位置
+         * @return 完整解码返回 true
+         */
+        virtual bool decodePositions(const char* p, size_t size, const PostingsCodecParams& params,
+                                     const std::vector<std::uint32_t>& pos_ends,
+                                     std::vector<Position>& positions) const = 0;
+
+        /**
+         * @brief 是否支持不解码文档 ID、直接在 Elias-Fano 视图上跳跃（见 openDocsView）
+         */
+        virtual bool hasDocsView() const { return false; }
+
+        /**
+         * @brief 只解码 tf，为块内文档 ID 建立 Elias-Fano 视图（值相对 prev_doc）
+         * @param p 块在文档区中的起始地址
+         * @param size 块字节数
+         * @param prev_doc 上一块的最后一个文档 ID（首块为 0）
+         * @param last_doc 本块的最后一个文档 ID（跳表记录）
+         * @param docs 本块文档数
+         * @param view 输出视图
+         * @param pos_ends 输出块内 tf 前缀和（追加）
+         * @return 完整解码返回 true
+         */
+        virtual bool openDocsView(const char* /*p*/, size_t /*size*/, DocId /*prev_doc*/, DocId /*last_doc*/,
+                                  size_t /*docs*/, EliasFanoView& /*view*/,
+                                  std::vector<std::uint32_t>& /*pos_ends*/) const {
+            return false;
+        }
+    };
+
+    /**
+     * @brief 编解码器注册表（进程内单例），构造时注册内置的 NONE/GOLOMB/GOLOMB_ADAPTIVE/BP128/ELIAS_FANO
+     */
+    class PostingsCodecRegistry {
+    public:
+        static PostingsCodecRegistry& instance();
+
+        /**
+         * @brief 注册编解码器（同一标签的已有编解码器被替换）
+         * @param codec 编解码器
+         */
+        void add(std::unique_ptr<PostingsCodec> codec);
+
+        /**
+         * @brief 按标签查找
+         * @param method 编码器标签
+         * @return 未注册时返回 nullptr
+         */
+        const PostingsCodec* find(CompressMethod method) const;
+
+        /**
+         * @brief 按名称查找
+         * @param name 编码器名称
+         * @return 未注册时返回 nullptr
+         */
+        const PostingsCodec* find(std::string_view name) const;
+
+        /**
+         * @brief 全部已注册的编解码器（按注册顺序）
+         */
+        std::vector<const PostingsCodec*> codecs() const;
+
+    private:
+        PostingsCodecRegistry();
+
+        std::vector<std::unique_ptr<PostingsCodec>> codecs_;
+    };
+} // namespace wiser
@@ -0,0 +1,131 @@
+#pragma once
+
+/**
+ * @file postings_cursor.h
+ * @brief 倒排游标接口及内存倒排、并集游标实现。
+ *
+ * 查询按文档逐个（doc-at-a-time）推进各词元的游标求交、短语校验与打分，不物化整个倒排列表；
+ * 每个查询的内存只与词元数有关。实现：
+ *  - BlockPostingsCursor：持久化分块数据（全部编解码器，见 postings_block.h）
+ *  - MemoryPostingsCursor：内存中的 PostingsList（InvertedIndex 缓冲区）
+ *  - UnionPostingsCursor：两个游标的有序并集（持久化 + 未刷新的缓冲区）
+ */
+
+#include "types.h"
+#include "postings.h"
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace wiser {
+    /**
+     * @brief 倒排游标：按文档 ID 升序前向遍历一个词元的倒排
+     */
+    class PostingsCursor {
+    public:
+        /**
+         * @brief 游标耗尽时 docId() 的返回值
+         */
+        static constexpr DocId kEndDocId = std::numeric_limits<DocId>::max();
+
+        virtual ~PostingsCursor() = default;
+
+        /**
+         * @brief 获取列表中的文档总数
+         * @return 文档数
+         */
+        virtual Count size() const = 0;
+
+        /**
+         * @brief 当前文档 ID
+         * @return 文档 ID；耗尽时返回 kEndDocId
+         */
+        virtual DocId docId() const = 0;
+
+        /**
+         * @brief 前进到下一个文档
+         */
+        virtual void next() = 0;
+
+        /**
+         * @brief 前进到第一个 ID 不小于 target 的文档（不会后退）
+         * @param target 目标文档 ID
+         */
+        virtual void advance(DocId target) = 0;
+
+        /**
+         * @brief 当前文档的词频（须未耗尽）
+         * @return tf
+         */
+        virtual Count tf() const = 0;
+
+        /**
+         * @brief 当前文档的位置（须未耗尽），首次访问时才解码
+         * @return 升序位置视图，游标移动前有效
+         */
+        virtual std::span<const Position> positions() = 0;
+    };
+
+    /**
+     * @brief 内存倒排列表上的游标
+     *
+     * @note 游标不拥有列表，调用方须保证列表在游标生命周期内有效且不被修改。
+     */
+    class MemoryPostingsCursor final : public PostingsCursor {
+    public:
+        explicit MemoryPostingsCursor(const PostingsList& list)
+            : list_(list) {}
+
+        Count size() const override { return list_.getDocumentsCount(); }
+
+        DocId docId() const override {
+            return index_ < list_.getDocumentIds().size() ? list_.getDocumentId(index_) : kEndDocId;
+        }
+
+        void next() override { ++index_; }
+
+        void advance(DocId target) override;
+
+        Count tf() const override { return list_.getPositionsCount(index_); }
+
+        std::span<const Position> positions() override { return list_.getPositions(index_); }
+
+    private:
+        const PostingsList& list_;
+        size_t index_ = 0;
+    };
+
+    /**
+     * @brief 两个游标的有序并集
+     *
+     * 同一文档同时出现在两侧时，tf 相加、位置合并后保持升序。
+     */
+    class UnionPostingsCursor final : public PostingsCursor {
+    public:
+        UnionPostingsCursor(std::unique_ptr<PostingsCursor> first, std::unique_ptr<PostingsCursor> second)
+            : first_(std::move(first)), second_(std::move(second)) {}
+
+        Count size() const override { return first_->size() + second_->size(); }
+
+        DocId docId() const override { return std::min(first_->docId(), second_->docId()); }
+
+        void next() override;
+
+        void advance(DocId target) override {
+            first_->advance(target);
+            second_->advance(target);
+        }
+
+        Count tf() const override;
+
+        std::span<const Position> positions() override;
+
+    private:
+        std::unique_ptr<PostingsCursor> first_;
+        std::unique_ptr<PostingsCursor> second_;
+        std::vector<Position> merged_positions_; ///< 两侧位置的归并结果
+    };
+} // namespace wiser
@@ -0,0 +1,138 @@
+#pragma once
+
+/**
+ * @file postings_file.h
+ * @brief 只读的内存映射倒排文件（一个索引段一个文件）。
+ *
+ * 文件格式（所有定宽字段按本机字节序存储）：
+ *   头部（占满第一页）：[magic:uint32 = kPostingsFileMagic][version:uint32][entry_count:uint32][reserved:uint32]
+ *                       [directory_offset:uint64]
+ *   倒排区：各词元的序列化倒排（同 segment_postings.postings 的 BLOB）依次存放，每条按 kPostingsFileAlignment 对齐
+ *   目录：按 token_id 升序的 PostingsFileEntry 数组（偏移表），位于文件末尾
+ *
+ * 打开时整个文件以只读方式映射，目录直接在映射内存上二分查找，倒排以 span 指向映射内存：
+ * 读取不经过 SQL、不拷贝、不加锁，缓存交给操作系统的页缓存。文件写完并落盘后才在数据库中发布，之后不再修改。
+ */
+
+#include "types.h"
+#include "database.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace wiser {
+    constexpr std::uint32_t kPostingsFileMagic = 0x46505357; ///< "WSPF"
+    constexpr std::uint32_t kPostingsFileVersion = 1;
+    constexpr size_t kPostingsFileHeaderSize = 4096; ///< 头部占满一页，倒排区从页边界开始
+    constexpr size_t kPostingsFileAlignment = 8;     ///< 每条倒排的起始偏移对齐到此字节数
+
+    /**
+     * @brief 目录项：一个词元在文件中的倒排
+     */
+    struct PostingsFileEntry {
+        TokenId token_id;
+        Count docs_count;
+        DocId first_doc;
+        DocId last_doc;
+        std::uint64_t offset; ///< 相对文件起点
+        std::uint64_t length;
+    };
+    static_assert(sizeof(PostingsFileEntry) == 32);
+
+    /**
+     * @class PostingsFileWriter
+     * @brief 顺序写出一个倒排文件
+     *
+     * 依次 add（token_id 须严格升序），最后 finish 写出目录与头部并落盘；未 finish 的文件不完整，由调用方删除。
+     */
+    class PostingsFileWriter {
+    public:
+        PostingsFileWriter() = default;
+        ~PostingsFileWriter();
+
+        PostingsFileWriter(const PostingsFileWriter&) = delete;
+        PostingsFileWriter& operator=(const PostingsFileWriter&) = delete;
+
+        /**
+         * @brief 创建（或截断）文件并预留头部
+         * @param path 文件路径
+         * @return 成功返回 true
+         */
+        [[nodiscard]] bool open(const std::string& path);
+
+        /**
+         * @brief 追加一个词元的倒排
+         * @param record 倒排记录（token_id 须大于之前写入的所有记录）
+         * @return 成功返回 true
+         */
+        [[nodiscard]] bool add(const SegmentPostingsRecord& record);
+
+        /**
+         * @brief 写出目录与头部，刷新并落盘后关闭文件
+         * @return 成功返回 true
+         */
+        [[nodiscard]] bool finish();
+
+    private:
+        std::FILE* file_ = nullptr;
+        std::uint64_t offset_ = 0;
+        std::vector<PostingsFileEntry> entries_;
+
+        bool writeBytes(const void* data, size_t size);
+    };
+
+    /**
+     * @class MappedPostingsFile
+     * @brief 以只读方式映射的倒排文件
+     *
+     * 打开后不可变，可被多个线程同时读取；由 shared_ptr 持有，段被合并删除后仍在使用它的查询可以安全读完。
+     */
+    class MappedPostingsFile {
+    public:
+        ~MappedPostingsFile();
+
+        MappedPostingsFile(const MappedPostingsFile&) = delete;
+        MappedPostingsFile& operator=(const MappedPostingsFile&) = delete;
+
+        /**
+         * @brief 映射并校验文件
+         * @param path 文件路径
+         * @return 映射后的文件；文件不存在、不完整或格式不符时返回 nullptr
+         */
+        static std::shared_ptr<const MappedPostingsFile> open(const std::string& path);
+
+        /**
+         * @brief 查找词元的目录项
+         * @param token_id 词元 ID
+         * @return 目录项；文件中没有该词元时返回 nullptr
+         */
+        const PostingsFileEntry* find(TokenId token_id) const;
+
+        /**
+         * @brief 目录项对应的倒排（指向映射内存，在文件对象生命周期内有效）
+         */
+        std::span<const char> postings(const PostingsFileEntry& entry) const {
+            return { data_ + entry.offset, static_cast<size_t>(entry.length) };
+        }
+
+        /**
+         * @brief 全部目录项（按 token_id 升序）
+         */
+        std::span<const PostingsFileEntry> entries() const { return entries_; }
+
+    private:
+        MappedPostingsFile() = default;
+
+        const char* data_ = nullptr;
+        size_t size_ = 0;
+        std::span<const PostingsFileEntry> entries_;
+#ifdef _WIN32
+        void* file_handle_ = nullptr;
+        void* mapping_handle_ = nullptr;
+#endif
+    };
+} // namespace wiser
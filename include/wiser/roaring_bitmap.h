@@ -0,0 +1,142 @@
+#pragma once
+
+/**
+ * @file roaring_bitmap.h
+ * @brief Roaring 风格的压缩位图，用于高文档频率词元的文档集合与求交。
+ *
+ * 32 位值按高 16 位分桶，每桶一个容器，按体积最小原则选择：
+ *  - 数组容器：升序 uint16（不超过 kArrayContainerMax 个）
+ *  - 位图容器：1024 个 64 位字
+ *  - 游程容器：(起点, 长度-1) 的 uint16 对
+ *
+ * 序列化格式（本机字节序）：
+ *   [container_count:uint32]
+ *   每个容器 [key:uint16][type:uint16][n:uint32]（n 为数组元素数 / 位图基数 / 游程数）及其数据
+ */
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace wiser {
+    class RoaringBitmap {
+    public:
+        /**
+         * @brief 数组容器的最大元素数（超过时位图容器更小）
+         */
+        static constexpr size_t kArrayContainerMax = 4096;
+
+        RoaringBitmap() = default;
+
+        /**
+         * @brief 由升序（可含重复）的非负值构造
+         * @param values 升序值
+         * @return 位图
+         */
+        static RoaringBitmap fromSorted(std::span<const std::int32_t> values);
+
+        /**
+         * @brief 追加升序（可含重复）的非负值，须均大于位图中已有的最大值
+         *
+         * 只重建最后一个桶（若新值落在其中）并追加新桶，其余容器不变。
+         * @param values 升序值
+         */
+        void appendSorted(std::span<const std::int32_t> values);
+
+        /**
+         * @brief 从序列化数据构造
+         * @param data 数据起始地址
+         * @param size 数据字节数
+         * @return 数据非法时返回 std::nullopt
+         */
+        static std::optional<RoaringBitmap> deserialize(const char* data, size_t size);
+
+        /**
+         * @brief 序列化并追加到输出
+         * @param out 输出缓冲区
+         */
+        void serialize(std::vector<char>& out) const;
+
+        /**
+         * @brief 与另一位图求交（原地）
+         *
+         * 只处理两侧都存在的桶；两侧均非数组容器时按 64 位字 AND。
+         * @param other 另一位图
+         */
+        void intersectWith(const RoaringBitmap& other);
+
+        bool contains(std::uint32_t value) const;
+
+        /**
+         * @brief 元素个数
+         */
+        std::uint64_t cardinality() const;
+
+        bool empty() const { return containers_.empty(); }
+
+        /**
+         * @brief 按升序遍历所有值
+         * @param fn 回调，参数为值
+         */
+        template<typename Fn>
+        void forEach(Fn&& fn) const {
+            for (const auto& c: containers_) {
+                const std::uint32_t base = static_cast<std::uint32_t>(c.key) << 16;
+                switch (c.type) {
+                    case Type::Array:
+                        for (std::uint16_t v: c.values) {
+                            fn(base | v);
+                        }
+                        break;
+                    case Type::Bitmap:
+                        for (size_t w = 0; w < c.words.size(); ++w) {
+                            for (std::uint64_t bits = c.words[w]; bits != 0; bits &= bits - 1) {
+                                fn(base | static_cast<std::uint32_t>(w * 64 + static_cast<size_t>(std::countr_zero(bits))));
+                            }
+                        }
+                        break;
+                    case Type::Run:
+                        for (size_t i = 0; i + 1 < c.values.size(); i += 2) {
+                            const std::uint32_t start = c.values[i];
+                            for (std::uint32_t v = start; v <= start + c.values[i + 1]; ++v) {
+                                fn(base | v);
+                            }
+                        }
+                        break;
+                }
+            }
+        }
+
+    private:
+        enum class Type : std::uint16_t { Array = 0, Bitmap = 1, Run = 2 };
+
+        struct Container {
+            std::uint16_t key = 0;
+            Type type = Type::Array;
+            std::uint32_t cardinality = 0;
+            std::vector<std::uint16_t> values; ///< 数组：元素；游程：起点/长度-1 交替
+            std::vector<std::uint64_t> words;  ///< 位图：1024 个字
+
+            bool contains(std::uint16_t low) const;
+            std::vector<std::uint64_t> toWords() const;
+            std::vector<std::uint16_t> toLows() const;
+        };
+
+        std::vector<Container> containers_; ///< 按 key 升序
+
+        /**
+         * @brief 由升序不重复的低 16 位值构造容器，选择体积最小的表示
+         */
+        static Container makeContainer(std::uint16_t key, std::span<const std::uint16_t> lows);
+
+        /**
+         * @brief 由位图字构造容器（基数不大于 kArrayContainerMax 时转为数组）
+         */
+        static Container fromWords(std::uint16_t key, std::vector<std::uint64_t> words);
+
+        static Container intersect(const Container& a, const Container& b);
+    };
+} // namespace wiser
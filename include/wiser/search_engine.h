@@ -8,9 +8,11 @@
 #include "types.h"
 #include "database.h"
 #include "postings.h"
+#include "postings_cursor.h"
 #include <string>
 #include <string_view>
 #include <memory>
+#include <span>
 #include <utility>
 #include <vector>
 
@@ -23,9 +25,9 @@ namespace wiser {
      *
      * 典型流程：
      *  - 将查询转成 N-gram TokenId 序列（忽略标点/空白，ASCII 转小写）
-     *  - 读取每个 Token 的持久化倒排 + 内存缓冲倒排，并进行合并
-     *  - 可选：短语匹配（位置相邻校验）
-     *  - 基于简单 TF(1+log tf) * IDF 的评分，降序返回
+     *  - 为每个 Token 打开倒排游标（各索引段的持久化倒排 + 内存缓冲倒排的有序并集）
+     *  - 按文档逐个推进游标求交，当场做可选的短语匹配（位置相邻校验）
+     *    并按 BM25 或 TF(1+log tf) * IDF 打分，降序返回
      *
      * 线程安全：
      *  - SearchEngine 持有的指针指向 WiserEnvironment；对环境/数据库的并发访问需外部保证
@@ -91,13 +93,6 @@ namespace wiser {
          */
         std::vector<TokenId> getTokenIds(std::string_view query) const;
 
-        /**
-         * @brief 求多个文档 ID 列表的交集（结果仍有序）
-         * @param postings_lists 多个倒排列表的文档 ID 集合
-         * @return 交集后的文档 ID 列表
-         */
-        static std::vector<DocId> intersectPostings(const std::vector<std::vector<DocId>>& postings_lists);
-
         /**
          * @brief 打印搜索结果列表
          * @param results (DocId, Score) 列表
@@ -106,18 +101,14 @@ namespace wiser {
 
         // 重构辅助结构与函数
         struct QueryData {
-            std::vector<std::vector<DocId>> token_postings;
-            std::vector<Count> docs_counts;
-            std::vector<std::unordered_map<DocId, Count>> token_tf_maps;
-            std::vector<std::unordered_map<DocId, std::vector<Position>>> token_pos_maps;
+            std::vector<Count> docs_counts;                                ///< 每个词元的文档频率（df，各段之和）
+            std::vector<std::vector<std::span<const char>>> disk_postings; ///< 每个词元在各段中与候选区间相交的持久化倒排原始字节（由分块游标按需解码）
+            PostingsSnapshot snapshot;                                     ///< disk_postings 指向的数据（SQL 记录副本与倒排文件段快照）
+            std::vector<const PostingsList*> mem_postings;                 ///< 内存缓冲区中的倒排（可能为 nullptr）
         };
 
         QueryData fetchPostings(const std::vector<TokenId>& token_ids) const;
-        std::vector<DocId> getCandidateDocs(const QueryData& qd) const;
-        std::vector<DocId> filterByPhrase(
-            const std::vector<DocId>& candidates, const QueryData& qd, const std::vector<TokenId>& token_ids) const;
-
-        std::vector<std::pair<DocId, double>> calculateScores(
-            const std::vector<DocId>& result_docs, const QueryData& qd, const std::vector<TokenId>& token_ids) const;
+        std::vector<std::unique_ptr<PostingsCursor>> openCursors(const QueryData& qd) const;
+        std::vector<std::pair<DocId, double>> evaluateQuery(const QueryData& qd, size_t& candidate_count) const;
     };
 } // namespace wiser
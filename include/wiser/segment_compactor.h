@@ -0,0 +1,106 @@
+#pragma once
+
+/**
+ * @file segment_compactor.h
+ * @brief 索引段的分层合并策略与后台合并线程。
+ *
+ * 每次刷新把内存缓冲区写成一个新的不可变段，刷新开销只与新增数据量有关；段数随之增长，
+ * 查询需要在更多段之间求并。后台线程按分层（size-tiered）策略把体积相近的若干段合并为一个更大的段，
+ * 使段数保持在对数量级，每份数据被重写的次数也只有对数次。
+ *
+ * 合并过程：
+ *  - 新段先以未发布状态分批写入（每批一个短事务，与刷新互斥），查询不可见；
+ *    启用内存映射倒排文件时改为写入 <db_path>.seg<id> 文件（不经过数据库，不持有写锁），写完后落盘；
+ *  - 全部写完后在一个事务内发布新段并删除被合并的段，查询要么看到全部旧段、要么只看到新段；
+ *  - 中途停止或失败时删除未发布的新段，旧段不受影响；进程中断遗留的未发布段在下次启动时清理。
+ */
+
+#include "types.h"
+#include "database.h"
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace wiser {
+    class WiserEnvironment;
+
+    constexpr size_t kCompactionMinSegments = 4;  ///< 同一层至少有这么多段才合并
+    constexpr size_t kCompactionMaxSegments = 10; ///< 一次最多合并的段数
+    constexpr double kCompactionSizeRatio = 4.0;  ///< 同一层内最大段与最小段的体积比上限
+    constexpr std::int64_t kCompactionMinSegmentSize = 256 * 1024; ///< 小于此体积的段视为同一层（刷新产生的小段尽快合并）
+    constexpr size_t kCompactionBatchTokens = 1024; ///< 合并时每批（一个写事务）写入的词元数
+
+    /**
+     * @brief 按分层策略选出一组待合并的段
+     *
+     * 段按体积升序排列后，取第一组体积比不超过 kCompactionSizeRatio、且不少于 kCompactionMinSegments 个的相邻段，
+     * 最多 kCompactionMaxSegments 个；体积小于 kCompactionMinSegmentSize 的段按该值计算。
+     * @param segments 已发布的段
+     * @return 待合并的段 ID；无需合并时为空
+     */
+    std::vector<SegmentId> pickSegmentsToMerge(std::vector<SegmentInfo> segments);
+
+    /**
+     * @class SegmentCompactor
+     * @brief 后台合并索引段
+     *
+     * 由 WiserEnvironment 持有：initialize 后 start，每次刷新后 notify，shutdown/析构时 stop。
+     * 写入新段与发布时持有环境的索引写锁，与 flushIndexBuffer 互斥；读取旧段不加该锁。
+     */
+    class SegmentCompactor {
+    public:
+        /**
+         * @brief 构造合并器
+         * @param env 环境指针（须在生命周期内有效）
+         */
+        explicit SegmentCompactor(WiserEnvironment* env);
+        ~SegmentCompactor();
+
+        // 不可复制，不可移动（持有线程与同步原语）
+        SegmentCompactor(const SegmentCompactor&) = delete;
+        SegmentCompactor& operator=(const SegmentCompactor&) = delete;
+
+        /**
+         * @brief 启动后台线程（已启动时无操作），并立即检查一次是否需要合并
+         */
+        void start();
+
+        /**
+         * @brief 停止后台线程并等待其退出；正在进行的合并在当前批次后放弃
+         */
+        void stop();
+
+        /**
+         * @brief 通知后台线程段集合已变化（刷新产生了新段）
+         */
+        void notify();
+
+    private:
+        WiserEnvironment* env_;
+        std::thread thread_;
+        std::mutex mutex_;
+        std::condition_variable cond_;
+        bool stopping_ = false; ///< 受 mutex_ 保护
+        bool pending_ = false;  ///< 受 mutex_ 保护：有未处理的通知
+
+        void run();
+
+        /**
+         * @brief 按策略执行一轮合并
+         * @return 合并了一组段返回 true；无需合并、被停止或失败返回 false
+         */
+        bool compactOnce();
+
+        /**
+         * @brief 把给定的段合并为一个新段
+         * @param inputs 被合并的段
+         * @return 新段发布成功返回 true
+         */
+        bool mergeSegments(const std::vector<SegmentId>& inputs);
+
+        bool stopRequested();
+    };
+} // namespace wiser
@@ -0,0 +1,189 @@
+#pragma once
+
+/**
+ * @file token_dictionary.h
+ * @brief 进程内词元字典：token(UTF-8) -> TokenId。
+ *
+ * 设计要点：
+ *  - 在 WiserEnvironment::initialize 时从 tokens 表整体预热为只读的前缀压缩有序字典（见 front_coded_dictionary.h），
+ *    并为其构建 Bloom 过滤器：不存在的词元（如查询中未出现过的 n-gram）通常只需查一次过滤器即可返回；
+ *  - 启动后新出现的词元放在开放寻址哈希表中，命中只需一次哈希探测；两部分都不经过 SQL；
+ *  - 新词元在内存中直接分配 ID，并记为“待持久化”，在 flushIndexBuffer 时批量写入数据库；
+ *  - 不超过 kMaxPackedTokenLength 个码点的词元可以用 64 位打包键（见 packToken）查找，
+ *    命中打包键缓存时既不构造 UTF-8 字符串也不分配内存。
+ */
+
+#include "types.h"
+#include "bloom_filter.h"
+#include "front_coded_dictionary.h"
+#include <cstdint>
+#include <optional>
+#include <shared_mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace wiser {
+    constexpr size_t kMaxPackedTokenLength = 3; ///< 可打包为 64 位键的最大码点数
+    constexpr unsigned kPackedCodePointBits = 21;
+
+    /**
+     * @brief 单个码点在打包键中的取值：码点 + 1，超出 Unicode 范围的码点为 0（无字符）
+     */
+    constexpr std::uint64_t packCodePoint(UTF32Char ch) {
+        return ch <= 0x10FFFF ? std::uint64_t{ ch } + 1 : 0;
+    }
+
+    /**
+     * @brief 把已归一化（ASCII 小写化）的码点序列打包为 64 位键
+     *
+     * 每个码点占 21 位、从高位起依次存放，值为码点 + 1（0 表示无字符）；超出 Unicode 范围的码点记为无字符，
+     * 与 Utils::utf32ToUtf8 丢弃无效码点的行为一致。
+     * @param code_points 码点（不超过 kMaxPackedTokenLength 个）
+     * @return 打包键
+     */
+    constexpr std::uint64_t packToken(std::span<const UTF32Char> code_points) {
+        std::uint64_t key = 0;
+        for (size_t i = 0; i < kMaxPackedTokenLength; ++i) {
+            key = (key << kPackedCodePointBits) | (i < code_points.size() ? packCodePoint(code_points[i]) : 0);
+        }
+        return key;
+    }
+
+    /**
+     * @brief 由打包键还原 UTF-8 词元
+     * @param key packToken 生成的键
+     * @return UTF-8 词元（不超过 12 字节）
+     */
+    std::string unpackToken(std::uint64_t key);
+    /**
+     * @brief 词元字典
+     *
+     * 预热的词元保存在前缀压缩字典 base_ 中（构建后只读），base_filter_ 为其 Bloom 过滤器；
+     * 之后分配的词元保存在哈希表中：槽位数组采用线性探测的开放寻址，词元字节统一存放在一块连续的 arena 中，
+     * 槽位只保存 (hash, id, offset, length)，避免每个词元一次堆分配。
+     *
+     * @note 内部使用读写锁保护，查找可并发进行。
+     */
+    class TokenDictionary {
+    public:
+        TokenDictionary();
+        ~TokenDictionary() = default;
+
+        // 不可复制，不可移动（内部持有互斥量）
+        TokenDictionary(const TokenDictionary&) = delete;
+        TokenDictionary& operator=(const TokenDictionary&) = delete;
+
+        /**
+         * @brief 查找词元 ID
+         * @param token 词元（UTF-8）
+         * @return 词元 ID；不存在返回空
+         */
+        [[nodiscard]] std::optional<TokenId> find(std::string_view token) const;
+
+        /**
+         * @brief 查找词元 ID，不存在则分配新 ID 并记为待持久化
+         * @param token 词元（UTF-8）
+         * @return 词元 ID（> 0）
+         */
+        TokenId getOrAssign(std::string_view token);
+
+        /**
+         * @brief 批量查找词元 ID，不存在的分配新 ID 并记为待持久化
+         *
+         * 全部词元先在一次只读加锁中查找，未命中的再在一次写锁中按顺序分配，
+         * 分配结果与逐个调用 getOrAssign 相同。
+         * @param tokens 词元（UTF-8，应互不相同）
+         * @param ids 输出：与 tokens 一一对应的词元 ID（大小须与 tokens 相同）
+         */
+        void getOrAssignAll(std::span<const std::string_view> tokens, std::span<TokenId> ids);
+
+        /**
+         * @brief 以打包键批量查找词元 ID，不存在的分配新 ID 并记为待持久化
+         *
+         * 先查打包键缓存；未命中的键还原为 UTF-8 后按 getOrAssignAll 的规则解析，并把结果写入缓存。
+         * @param keys packToken 生成的键（应互不相同）
+         * @param ids 输出：与 keys 一一对应的词元 ID（大小须与 keys 相同）
+         */
+        void getOrAssignAll(std::span<const std::uint64_t> keys, std::span<TokenId> ids);
+
+        /**
+         * @brief 以全部已持久化的词元重建字典（用于预热）
+         *
+         * 清空已有内容，词元存入前缀压缩字典并构建 Bloom 过滤器。
+         * @param tokens (id, token) 列表（按词元字节序排列时无需再排序）
+         */
+        void load(std::vector<std::pair<TokenId, std::string>> tokens);
+
+        /**
+         * @brief 获取尚未写入数据库的新词元 (id, token) 列表
+         * @return 按分配顺序排列的待持久化词元
+         */
+        [[nodiscard]] std::vector<std::pair<TokenId, std::string>> getPendingTokens() const;
+
+        /**
+         * @brief 是否存在待持久化的词元
+         * @return 存在返回 true
+         */
+        [[nodiscard]] bool hasPendingTokens() const;
+
+        /**
+         * @brief 标记前 count 个待持久化词元已写入数据库
+         *
+         * 只移除调用 getPendingTokens 时已取走的部分，期间新分配的词元仍保留。
+         * @param count 已写入数据库的词元数
+         */
+        void clearPendingTokens(size_t count);
+
+        /**
+         * @brief 清空字典
+         */
+        void clear();
+
+        /**
+         * @brief 获取词元数量
+         * @return 字典中的词元总数
+         */
+        [[nodiscard]] size_t size() const;
+
+        /**
+         * @brief 获取字典占用的字节数（前缀压缩字典、Bloom 过滤器、哈希槽位、arena 与打包键缓存）
+         */
+        [[nodiscard]] size_t memoryUsage() const;
+
+    private:
+        struct PackedSlot {
+            std::uint64_t key = 0;
+            TokenId id = 0; ///< 0 表示空槽
+        };
+
+        struct Slot {
+            std::uint64_t hash = 0;
+            TokenId id = 0;            ///< 0 表示空槽
+            std::uint32_t offset = 0;  ///< 词元在 arena_ 中的起始偏移
+            std::uint32_t length = 0;  ///< 词元字节长度
+        };
+
+        std::vector<Slot> slots_;             ///< 槽位数组（容量为 2 的幂）
+        std::string arena_;                   ///< 词元字节存储区
+        size_t size_ = 0;                     ///< 已占用槽位数
+        TokenId next_id_ = 1;                 ///< 下一个可分配的 ID
+        std::vector<Slot> pending_;           ///< 待持久化词元（arena 偏移稳定，rehash 不影响）
+        FrontCodedDictionary base_;           ///< 预热的词元（只在 load/clear 时改变）
+        BloomFilter base_filter_;             ///< base_ 的 Bloom 过滤器
+        std::vector<PackedSlot> packed_slots_; ///< 打包键 -> ID 缓存（容量为 2 的幂）
+        size_t packed_size_ = 0;              ///< 打包键缓存已占用槽位数
+        mutable std::shared_mutex mutex_;
+
+        static std::uint64_t hashToken(std::string_view token);
+        [[nodiscard]] std::string_view keyOf(const Slot& slot) const;
+        [[nodiscard]] size_t probe(std::string_view token, std::uint64_t hash) const;
+        [[nodiscard]] std::optional<TokenId> findLocked(std::string_view token, std::uint64_t hash) const;
+        size_t emplace(std::string_view token, std::uint64_t hash, TokenId id);
+        void grow();
+        [[nodiscard]] size_t probePacked(std::uint64_t key) const;
+        void emplacePacked(std::uint64_t key, TokenId id);
+    };
+} // namespace wiser
@@ -9,10 +9,14 @@
 
 #include "types.h"
 #include "postings.h"
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <memory>
+#include <span>
 #include <string_view>
+#include <unordered_map>
 
 namespace wiser {
     class WiserEnvironment;
@@ -51,7 +55,8 @@ namespace wiser {
         /**
          * @brief 将 UTF-8 文本转换为倒排列表
          * 
-         * 内部完成 UTF-8 到 UTF-32 的转换，并进行 ASCII 小写化，与查询侧逻辑保持一致。
+         * 直接从 utf8_text 中逐个解码码点，不复制正文、也不生成整篇的 UTF-32 数组；
+         * 并进行 ASCII 小写化，与查询侧逻辑保持一致。
          * @param document_id 文档 ID
          * @param utf8_text UTF-8 文本
          * @param index 输出倒排索引
@@ -80,17 +85,87 @@ namespace wiser {
         void dumpToken(TokenId token_id);
 
     private:
+        /**
+         * @brief 文档内去重表的槽位（stamp 与当前文档的编号不同即视为空槽，换文档时无需清空）
+         */
+        struct LocalSlot {
+            std::uint64_t key = 0;
+            std::uint32_t local = 0;  ///< 文档内词元编号
+            std::uint32_t stamp = 0;
+        };
+
         WiserEnvironment* env_;
 
-        // 辅助函数
+        // 以下为逐文档复用的临时缓冲，稳定状态下分词不再分配内存
+        std::vector<LocalSlot> local_slots_;      ///< 打包键 -> 文档内词元编号（容量为 2 的幂）
+        std::uint32_t local_stamp_ = 0;           ///< 当前文档的编号
+        std::vector<std::uint64_t> packed_keys_;  ///< 文档内互不相同的打包键（按首次出现顺序）
+        std::unordered_map<std::string, std::uint32_t> local_ids_; ///< 长词元（超过 3 个码点）-> 文档内词元编号
+        std::vector<std::string_view> local_tokens_; ///< 文档内互不相同的长词元（指向 local_ids_ 的键）
+        std::vector<UTF32Char> window_;           ///< 通用路径的滑动窗口：当前片段的最后 N 个码点
+        std::vector<UTF32Char> word_;             ///< 混合分析器中正在累积的 ASCII 词
+        std::string token_;                       ///< 构造长词元的缓冲
+        std::vector<std::uint32_t> occurrences_;  ///< 每个位置对应的文档内词元编号
+        std::vector<TokenId> token_ids_;          ///< 文档内词元编号 -> 词元 ID
+        std::vector<std::uint32_t> group_ends_;   ///< 按词元归组后各组的结束偏移
+        std::vector<std::uint32_t> group_cursor_; ///< 归组时各组的写入位置
+        std::vector<Position> grouped_;           ///< 按词元归组的位置
+
         /**
-         * @brief 提取 N-gram 字符串
-         * @param text UTF-32 文本
-         * @param start 起始下标
-         * @param n N 值或长度
-         * @return UTF-8 编码的词元
+         * @brief 分词主流程：逐个读入码点，按分析器（见 analyzer.h）产出词元，批量解析词元 ID 后写入倒排索引
+         * @tparam CodePointSource 提供 std::span<const UTF32Char> nextBlock()（空表示结束）的码点来源（仅在 tokenizer.cpp 中实例化）
+         * @param document_id 文档 ID
+         * @param source 码点来源
+         * @param index 输出倒排索引
+         * @return 生成的 token 数量
+         */
+        template <typename CodePointSource>
+        int tokenize(DocId document_id, CodePointSource& source, InvertedIndex& index);
+
+        /**
+         * @brief N 为编译期常量（1..kMaxPackedTokenLength）的分词内核
+         *
+         * 不保存码点窗口，而是逐码点滚动更新最后 N 个码点的打包键；由 tokenize 按 N 从分派表中选取。
+         * @tparam N N 值
+         * @tparam CodePointSource 码点来源（同 tokenize）
+         * @param source 码点来源
+         */
+        template <size_t N, typename CodePointSource>
+        void collectPackedNGrams(CodePointSource& source);
+
+        /**
+         * @brief 记录一个 N 不超过 kMaxPackedTokenLength 的 N-gram：以 64 位打包键在文档内去重，不构造字符串
+         * @param key N-gram 的打包键（见 packToken）
+         */
+        void addPackedNGram(std::uint64_t key);
+
+        /**
+         * @brief 记录一个通用路径产出的词元：不超过 kMaxPackedTokenLength 个码点的用打包键，其余用字符串
+         * @param term 已小写化的码点
+         */
+        void addTerm(std::span<const UTF32Char> term);
+
+        /**
+         * @brief 记录一个长词元（N-gram 或 ASCII 词）：以 UTF-8 字符串在文档内去重
+         * @param ngram 已小写化的码点
+         */
+        void addNGram(std::span<const UTF32Char> ngram);
+
+        /**
+         * @brief 批量解析文档内全部词元的 ID：打包键与字符串词元各一批，结果依次存入 token_ids_
+         */
+        void resolveTokenIds();
+
+        /**
+         * @brief 文档内去重表装载过半时扩容一倍，并重新插入当前文档的打包键
+         */
+        void growLocalSlots();
+
+        /**
+         * @brief 把 occurrences_ 中的位置按词元归组，每个词元整段写入倒排索引
+         * @param document_id 文档 ID
+         * @param index 输出倒排索引
          */
-        std::string extractNGram(const std::vector<UTF32Char>& text,
-                                 size_t start, std::int32_t n);
+        void appendPostings(DocId document_id, InvertedIndex& index);
     };
 } // namespace wiser
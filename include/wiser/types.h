@@ -27,6 +27,11 @@ namespace wiser {
      */
     using TokenId = std::int32_t;
 
+    /**
+     * @brief 索引段 ID 类型
+     */
+    using SegmentId = std::int64_t;
+
     /**
      * @brief 词在文档中的位置类型（以 n-gram 为单位）
      */
@@ -51,8 +56,12 @@ namespace wiser {
      * @brief 倒排列表压缩方法枚举
      */
     enum class CompressMethod {
-        NONE,  ///< 不压缩
-        GOLOMB ///< 使用 Golomb 编码压缩
+        NONE,            ///< 不压缩
+        GOLOMB,          ///< 使用 Golomb 编码压缩
+        BP128,           ///< 每 128 个整数一组的定宽位打包（SIMD 解码）
+        ELIAS_FANO,      ///< 文档 ID 使用 Elias-Fano 编码（支持 nextGEQ 跳跃），tf/位置同 BP128
+        GOLOMB_ADAPTIVE, ///< Golomb 编码，参数 M 按列表的实际间隔分布选取并写入列表头
+        AUTO             ///< 每个列表分别选择编码器（体积最小，或体积相近时解码更快者），编码器标签写入列表头
     };
 
     // 前向声明
@@ -10,6 +10,8 @@
 #include <string_view>
 
 #include "types.h"
+#include "config.h"
+#include "char_class.h"
 #include <string>
 #include <vector>
 #include <memory>
@@ -119,6 +121,26 @@ namespace wiser {
          */
         static std::vector<UTF32Char> utf8ToUtf32(const std::string& utf8_str);
 
+        /**
+         * @brief 从 UTF-8 字节串中批量解码码点（容错规则与 utf8ToUtf32 一致）
+         *
+         * ASCII 片段以 SIMD 每次处理 16/32 字节（运行时选择 AVX2 或 SSE2，否则为标量实现），
+         * 多字节序列的续字节以 SIMD 位图校验。
+         * @param utf8_str UTF-8 字节串
+         * @param[in,out] pos 当前字节偏移，返回后指向下一个未读字节
+         * @param[out] out 输出码点缓冲
+         * @param max_count out 的容量（码点数）
+         * @return 写出的码点数；返回 0 表示没有更多码点
+         */
+        static size_t decodeUtf8(std::string_view utf8_str, size_t& pos, UTF32Char* out, size_t max_count);
+
+        /**
+         * @brief 将一个码点以 UTF-8 追加到字符串末尾（超出 Unicode 范围的码点被忽略）
+         * @param[in,out] out 输出字符串
+         * @param code_point 码点
+         */
+        static void appendUtf8(std::string& out, UTF32Char code_point);
+
         /**
          * @brief 计算 UTF-32 序列转换为 UTF-8 所需的字节数
          * @param utf32_str UTF-32 字符数组
@@ -138,11 +160,11 @@ namespace wiser {
         /** 
          * @brief 判断是否为应忽略的分隔标点字符（UTF-32）
          * 
-         * 逻辑与分词器中的处理保持一致。
+         * 逻辑与分词器中的处理保持一致（查表实现，见 char_class.h）。
          * @param ch UTF-32 字符
          * @return 如果是应忽略的字符则返回 true，否则返回 false
          */
-        static bool isIgnoredChar(UTF32Char ch);
+        static bool isIgnoredChar(UTF32Char ch) { return isIgnoredCodePoint(ch); }
 
         /** 
          * @brief 将 ASCII 字符转换为小写（就地修改）
@@ -178,13 +200,14 @@ namespace wiser {
          * 用于搜索高亮等场景。处理逻辑包括：
          * - 忽略 Utils::isIgnoredChar 返回 true 的字符
          * - 对 ASCII 范围字符进行小写归一化
-         * - 生成长度为 n 的 n-gram，并按出现顺序去重
+         * - 按分析器切分（见 analyzer.h，应与建索引时一致），并按出现顺序去重
          * 
          * @param q 查询字符串
          * @param n n-gram 的 n 值
+         * @param analyzer 分析器类型
          * @return 分词后的字符串列表
          */
-        static std::vector<std::string> tokenizeQueryTokens(const std::string& q, int n);
+        static std::vector<std::string> tokenizeQueryTokens(const std::string& q, int n, AnalyzerType analyzer);
 
         /**
          * @brief 对字符串进行 JSON 转义
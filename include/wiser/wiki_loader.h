@@ -10,6 +10,8 @@
 #include "types.h"
 #include <string>
 #include <memory>
+#include <span>
+#include <utility>
 
 namespace wiser {
     class WiserEnvironment;
@@ -49,6 +51,13 @@ namespace wiser {
          */
         bool processPage(const std::string& title, const std::string& content);
 
+        /**
+         * @brief 批量处理维基页面（交给 WiserEnvironment::addDocuments 并行分词）
+         * @param pages (标题, 已清理的内容) 列表
+         * @return 加入索引的页面数
+         */
+        size_t processPages(std::span<const std::pair<std::string, std::string>> pages);
+
     private:
         WiserEnvironment* env_;
 
@@ -11,9 +11,22 @@
 // Modern C++ rewrite of the wiser search engine
 
 #include "wiser/types.h"
+#include "wiser/char_class.h"
+#include "wiser/analyzer.h"
 #include "wiser/utils.h"
 #include "wiser/postings.h"
+#include "wiser/postings_block.h"
+#include "wiser/postings_codec.h"
+#include "wiser/postings_cursor.h"
+#include "wiser/postings_file.h"
+#include "wiser/bitpacking.h"
+#include "wiser/bloom_filter.h"
+#include "wiser/elias_fano.h"
+#include "wiser/front_coded_dictionary.h"
+#include "wiser/roaring_bitmap.h"
 #include "wiser/database.h"
+#include "wiser/segment_compactor.h"
+#include "wiser/token_dictionary.h"
 #include "wiser/tokenizer.h"
 #include "wiser/search_engine.h"
 #include "wiser/wiki_loader.h"
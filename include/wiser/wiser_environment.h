@@ -7,10 +7,12 @@
  * 职责：
  *  - 管理运行时配置（N-gram、压缩方式、短语搜索开关、缓冲阈值等）
  *  - 提供统一的组件访问（Database/Tokenizer/SearchEngine/Loaders）
- *  - 管理内存中的倒排缓冲区，并在阈值或显式调用时刷盘合并
+ *  - 管理内存中的倒排缓冲区，在阈值或显式调用时写成新的索引段，并由后台线程合并段
  *
  * 线程模型：
- *  - 本类不内置锁，若在多线程环境下并发写入/查询，需要在更高层进行串行化或加锁保护。
+ *  - 本类不内置锁，若在多线程环境下并发写入/查询，需要在更高层进行串行化或加锁保护；
+ *    仅刷新与后台段合并之间由内部的索引写锁互斥。
+ *  - addDocuments 在内部启动工作线程并行分词，调用返回前全部结束，对调用方而言仍是同步调用。
  */
 
 #include "types.h"
@@ -18,6 +20,8 @@
 #include "postings.h"
 #include "search_engine.h"
 #include "tokenizer.h"
+#include "token_dictionary.h"
+#include "segment_compactor.h"
 #include "wiki_loader.h"
 #include "utils.h"
 #include "config.h" // Include Config
@@ -26,8 +30,14 @@
 #include <cstdint>
 #include <unordered_map>
 #include <shared_mutex>
+#include <mutex>
+#include <span>
+#include <utility>
+#include <vector>
 
 namespace wiser {
+    constexpr size_t kIngestBatchSize = 256; ///< 加载器每批提交给 WiserEnvironment::addDocuments 的文档数
+
     /**
      * @brief Wiser 搜索引擎环境类
      * 
@@ -94,6 +104,52 @@ namespace wiser {
             return database_;
         }
 
+        /**
+         * @brief 获取进程内词元字典
+         *
+         * 字典在 initialize 时由 tokens 表预热；分词时新分配的词元在 flushIndexBuffer 时批量落库。
+         *
+         * @return TokenDictionary reference
+         */
+        TokenDictionary& getTokenDictionary() {
+            return token_dictionary_;
+        }
+
+        /**
+         * @brief 获取进程内词元字典（常量引用）
+         * @return Const TokenDictionary reference
+         */
+        const TokenDictionary& getTokenDictionary() const {
+            return token_dictionary_;
+        }
+
+        /**
+         * @brief 获取索引写锁
+         *
+         * flushIndexBuffer 与后台段合并的写事务共用同一个数据库连接，须持有此锁互斥，避免彼此的语句混入对方的事务。
+         *
+         * @return 索引写锁
+         */
+        std::mutex& getIndexWriteMutex() {
+            return index_write_mutex_;
+        }
+
+        /**
+         * @brief 获取搜索引擎组件
+         * @return SearchEngine reference
+         */
+        SearchEngine& getSearchEngine() {
+            return search_engine_;
+        }
+
+        /**
+         * @brief 获取搜索引擎组件（常量引用）
+         * @return Const SearchEngine reference
+         */
+        const SearchEngine& getSearchEngine() const {
+            return search_engine_;
+        }
+
         /**
          * @brief 获取数据库路径 
          * @return 数据库路径字符串
@@ -110,6 +166,14 @@ namespace wiser {
             return config_.token_len;
         }
 
+        /** 
+         * @brief 获取分析器类型 
+         * @return 分析器枚举值（索引与查询共用）
+         */
+        AnalyzerType getAnalyzer() const {
+            return config_.analyzer;
+        }
+
         /** 
          * @brief 获取压缩方式 
          * @return 压缩方法枚举值
@@ -126,6 +190,14 @@ namespace wiser {
             return config_.enable_phrase_search;
         }
 
+        /** 
+         * @brief 合并产生的段是否写成内存映射倒排文件 
+         * @return 若启用返回 true
+         */
+        bool isMmapPostingsEnabled() const {
+            return config_.mmap_postings;
+        }
+
         /** 
          * @brief 获取缓冲区刷新阈值 
          * @return 缓冲区 token 数量阈值
@@ -150,6 +222,14 @@ namespace wiser {
             return config_.max_index_count;
         }
 
+        /** 
+         * @brief 获取批量导入时并行分词的线程数 
+         * @return 配置值（0 表示按硬件线程数）
+         */
+        std::int32_t getIndexThreads() const {
+            return config_.index_threads;
+        }
+
         /** 
          * @brief 是否已达到本次运行的索引上限 
          * @return 若已达到或超过上限返回 true
@@ -179,6 +259,18 @@ namespace wiser {
             }
         }
 
+        /** 
+         * @brief 设置分析器类型 
+         * 
+         * 必须在索引构建前设置：它决定词元的切分方式，查询侧必须与建索引时一致。
+         * 已初始化且库中已有文档时，与库中不同的分析器会被拒绝（记录警告，保持原设置），
+         * 否则已有倒排与之后的查询切分方式不一致，只能重建索引才能恢复。
+         * 
+         * @param analyzer 分析器枚举值
+         * @return 设置生效返回 true；被拒绝返回 false
+         */
+        bool setAnalyzer(AnalyzerType analyzer);
+
         /** 
          * @brief 设置压缩方式 
          * 
@@ -239,10 +331,33 @@ namespace wiser {
             // Runtime parameter, no need to persist
         }
 
+        /** 
+         * @brief 设置批量导入时并行分词的线程数 (Runtime only)
+         * 
+         * @param threads 线程数（0 表示按硬件线程数，1 表示不启动工作线程）
+         */
+        void setIndexThreads(std::int32_t threads) {
+            config_.index_threads = threads;
+            // Runtime parameter, no need to persist
+        }
+
+        /** 
+         * @brief 启用/禁用内存映射倒排文件 (Runtime only)
+         * 
+         * 启用后后台合并产生的段写成数据库旁的只读倒排文件，查询读取时不经过 SQL。
+         * 应在索引前设置（后台合并线程会读取该值）。
+         * 
+         * @param enabled 是否启用
+         */
+        void setMmapPostingsEnabled(bool enabled) {
+            config_.mmap_postings = enabled;
+            // Runtime parameter, no need to persist
+        }
+
         /**
          * @brief 应用完整的配置对象
          *
-         * 批量更新配置参数。对于需要持久化的参数（如 token_len, compress_method），
+         * 批量更新配置参数。对于需要持久化的参数（如 token_len, analyzer, compress_method），
          * 这里会根据当前状态尝试写入数据库。
          *
          * @param config 新的配置对象
@@ -250,6 +365,7 @@ namespace wiser {
         void applyConfig(const Config& config) {
             // Store old values to check changes
             auto old_token_len = config_.token_len;
+            auto old_analyzer = config_.analyzer;
             auto old_compress_method = config_.compress_method;
 
             // Apply new config
@@ -260,6 +376,9 @@ namespace wiser {
                 if (config_.token_len != old_token_len) {
                     database_.setSetting("token_len", std::to_string(config_.token_len));
                 }
+                if (config_.analyzer != old_analyzer) {
+                    database_.setSetting("analyzer", std::to_string(static_cast<int>(config_.analyzer)));
+                }
                 if (config_.compress_method != old_compress_method) {
                     database_.setSetting("compress_method", std::to_string(static_cast<int>(config_.compress_method)));
                 }
@@ -269,8 +388,8 @@ namespace wiser {
         /**
          * @brief 将内存中的倒排索引缓冲区刷新到磁盘数据库
          *
-         * 此操作会合并内存索引和数据库中的现有倒排列表，并持久化存储。
-         * 通常在缓冲区达到阈值或系统关闭时调用。
+         * 此操作会先批量写入词元字典中新分配的词元，再把缓冲区写成一个新的不可变段（不读取、不重写已有倒排），
+         * 开销只与新增数据量有关；随后通知后台合并线程。通常在缓冲区达到阈值或系统关闭时调用。
          */
         void flushIndexBuffer();
 
@@ -345,18 +464,56 @@ namespace wiser {
          */
         void addDocument(const std::string& title, const std::string& body);
 
+        /**
+         * @brief 批量添加文档，正文由多个线程并行分词
+         *
+         * 过程：
+         *  1. 在调用线程上按顺序写入文档并查回文档 ID（分配顺序与逐个 addDocument 相同，结果确定）；
+         *  2. 把新文档（ID 大于此前分过词的所有文档）按顺序切成连续的若干段（即文档 ID 区间），
+         *     每个工作线程用自己的分词器写入局部倒排索引，词元 ID 由共享的词元字典分配（内部加锁）；
+         *  3. 局部索引按文档 ID 区间依次合并进 index_buffer_（倒排列表整段追加，无需排序）；
+         *     重复或更新已有标题的文档复用较小的 ID，随后在调用线程上按顺序直接写入 index_buffer_；
+         *     再按顺序更新文档长度与计数，最后按阈值判断是否 flush（每批至多一次）。
+         *
+         * 局部索引在每批结束时合并而不是留到 flush，因此未刷盘的文档与 addDocument 一样立即可检索。
+         *
+         * 空标题与空正文的文档被跳过，达到 max_index_count 后其余文档被忽略，与 addDocument 一致。
+         * 并行时新词元的 ID 取决于线程执行次序，但检索结果与逐个添加相同。
+         *
+         * @warning 与 addDocument 相同，不能与其他写入或查询并发调用。
+         *
+         * @throws 工作线程分词时抛出的异常在所有线程结束后于调用线程重新抛出；此时本批文档已写入数据库，
+         *         但不进入倒排缓冲区，也不更新文档长度与计数
+         *
+         * @param documents (title, body) 列表（UTF-8）
+         * @return 加入索引的文档数
+         */
+        size_t addDocuments(std::span<const std::pair<std::string, std::string>> documents);
+
     private:
+        /**
+         * @brief 记录文档的词元数：写入数据库并更新文档长度缓存与总词元数
+         * @param document_id 文档 ID
+         * @param term_count 文档的词元数
+         */
+        void recordDocumentLength(DocId document_id, int term_count);
+
         // 配置
         Config config_;
 
         Count indexed_count_;
+        DocId max_tokenized_doc_id_ = 0; // 已写入倒排缓冲的最大文档 ID（addDocuments 据此区分新文档与复用 ID 的文档）
         bool initialized_ = false; // 初始化后才会将 set* 写入数据库
 
         // 组件
         Database database_;
+        TokenDictionary token_dictionary_;
         SearchEngine search_engine_;
         Tokenizer tokenizer_;
+        std::vector<Tokenizer> ingest_tokenizers_; // addDocuments 工作线程各自的分词器（跨批复用暂存缓冲）
         WikiLoader wiki_loader_;
+        std::mutex index_write_mutex_; // 串行化刷新与段合并的写事务
+        SegmentCompactor compactor_;   // 须在 database_ 与写锁之后声明：先于它们析构（停止后台线程）
 
         // 索引缓冲区
         InvertedIndex index_buffer_;
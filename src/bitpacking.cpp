@@ -0,0 +1,159 @@
+/**
+ * @file bitpacking.cpp
+ * @brief 定宽位打包（BP128）编码/解码实现
+ */
+
+#include "wiser/bitpacking.h"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define WISER_BITPACK_SSE2 1
+#endif
+
+namespace wiser {
+    namespace {
+        constexpr size_t kLanes = 4;
+        constexpr size_t kLaneSize = kBitPackBlockSize / kLanes;
+
+        int maxBitWidth(std::span<const std::uint32_t> values) {
+            std::uint32_t acc = 0;
+            for (std::uint32_t v: values) {
+                acc |= v;
+            }
+            return static_cast<int>(std::bit_width(acc));
+        }
+
+        std::uint32_t lowMask(int b) {
+            return b >= 32 ? 0xFFFFFFFFu : ((std::uint32_t{ 1 } << b) - 1);
+        }
+
+        /**
+         * @brief 将 values[k * stride] (k < n) 以 b 位横向打包到 words[k * ... * stride]
+         *
+         * stride 为 kLanes 时即纵向布局的单路，为 1 时即末尾组的横向布局。
+         */
+        void packLane(const std::uint32_t* values, size_t n, size_t stride, int b, std::uint32_t* words) {
+            for (size_t k = 0; k < n; ++k) {
+                const std::uint32_t v = values[k * stride];
+                const size_t bit = k * static_cast<size_t>(b);
+                const size_t w = bit / 32;
+                const unsigned shift = bit % 32;
+                words[w * stride] |= v << shift;
+                if (shift + static_cast<unsigned>(b) > 32) {
+                    words[(w + 1) * stride] |= v >> (32 - shift);
+                }
+            }
+        }
+
+        void unpackLane(const std::uint32_t* words, size_t n, size_t stride, int b, std::uint32_t* values) {
+            const std::uint32_t mask = lowMask(b);
+            for (size_t k = 0; k < n; ++k) {
+                const size_t bit = k * static_cast<size_t>(b);
+                const size_t w = bit / 32;
+                const unsigned shift = bit % 32;
+                std::uint32_t v = words[w * stride] >> shift;
+                if (shift + static_cast<unsigned>(b) > 32) {
+                    v |= words[(w + 1) * stride] << (32 - shift);
+                }
+                values[k * stride] = v & mask;
+            }
+        }
+
+        /**
+         * @brief 解码一个满组（纵向布局，b 为 1..31）
+         */
+        void unpackVertical(const char* in, int b, std::uint32_t* out) {
+#ifdef WISER_BITPACK_SSE2
+            // 4 路同时处理：每次移位/掩码得到 4 个整数
+            const __m128i mask = _mm_set1_epi32(static_cast<int>(lowMask(b)));
+            const auto* words = reinterpret_cast<const __m128i*>(in);
+            __m128i cur = _mm_loadu_si128(words);
+            size_t w = 0;
+            int shift = 0;
+            for (size_t k = 0; k < kLaneSize; ++k) {
+                __m128i v = _mm_srl_epi32(cur, _mm_cvtsi32_si128(shift));
+                shift += b;
+                if (shift >= 32) {
+                    shift -= 32;
+                    if (++w < static_cast<size_t>(b)) {
+                        cur = _mm_loadu_si128(words + w);
+                        if (shift > 0) {
+                            v = _mm_or_si128(v, _mm_sll_epi32(cur, _mm_cvtsi32_si128(b - shift)));
+                        }
+                    }
+                }
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + k * kLanes), _mm_and_si128(v, mask));
+            }
+#else
+            std::uint32_t words[kLanes * 32];
+            std::memcpy(words, in, static_cast<size_t>(b) * kLanes * sizeof(std::uint32_t));
+            for (size_t lane = 0; lane < kLanes; ++lane) {
+                unpackLane(words + lane, kLaneSize, kLanes, b, out + lane);
+            }
+#endif
+        }
+    } // anonymous namespace
+
+    void bitPackEncode(std::span<const std::uint32_t> values, std::vector<char>& out) {
+        std::uint32_t words[kBitPackBlockSize];
+        for (size_t first = 0; first < values.size(); first += kBitPackBlockSize) {
+            const auto group = values.subspan(first, std::min(kBitPackBlockSize, values.size() - first));
+            const int b = maxBitWidth(group);
+            out.push_back(static_cast<char>(b));
+
+            size_t word_count;
+            std::ranges::fill(words, 0u);
+            if (group.size() == kBitPackBlockSize) {
+                // 纵向布局：words[w * 4 + lane] 为第 lane 路的第 w 个字
+                for (size_t lane = 0; lane < kLanes; ++lane) {
+                    packLane(group.data() + lane, kLaneSize, kLanes, b, words + lane);
+                }
+                word_count = static_cast<size_t>(b) * kLanes;
+            } else {
+                packLane(group.data(), group.size(), 1, b, words);
+                word_count = (group.size() * static_cast<size_t>(b) + 31) / 32;
+            }
+            const char* p = reinterpret_cast<const char*>(words);
+            out.insert(out.end(), p, p + word_count * sizeof(std::uint32_t));
+        }
+    }
+
+    bool bitPackDecode(const char*& p, const char* end, size_t count, std::uint32_t* out) {
+        std::uint32_t words[kBitPackBlockSize];
+        for (size_t first = 0; first < count; first += kBitPackBlockSize) {
+            const size_t n = std::min(kBitPackBlockSize, count - first);
+            if (p >= end) {
+                return false;
+            }
+            const int b = static_cast<unsigned char>(*p++);
+            if (b > 32) {
+                return false;
+            }
+            const size_t word_count = n == kBitPackBlockSize
+                                          ? static_cast<size_t>(b) * kLanes
+                                          : (n * static_cast<size_t>(b) + 31) / 32;
+            const size_t bytes = word_count * sizeof(std::uint32_t);
+            if (static_cast<size_t>(end - p) < bytes) {
+                return false;
+            }
+
+            std::uint32_t* dst = out + first;
+            if (b == 0) {
+                std::fill(dst, dst + n, 0u);
+            } else if (n == kBitPackBlockSize && b < 32) {
+                unpackVertical(p, b, dst);
+            } else if (n == kBitPackBlockSize) {
+                // b == 32：纵向布局即原样的 32 位整数
+                std::memcpy(dst, p, bytes);
+            } else {
+                std::memcpy(words, p, bytes);
+                unpackLane(words, n, 1, b, dst);
+            }
+            p += bytes;
+        }
+        return true;
+    }
+} // namespace wiser
@@ -0,0 +1,57 @@
+/**
+ * @file bloom_filter.cpp
+ * @brief 分块 Bloom 过滤器实现
+ */
+
+#include "wiser/bloom_filter.h"
+#include <algorithm>
+
+namespace wiser {
+    namespace {
+        /**
+         * @brief 块内第 i 个探测位（0..511）
+         *
+         * 只使用哈希的低 32 位（高 32 位用于选块）：以其为起点、以其循环移位（取奇数）为步长做双重散列。
+         */
+        std::uint32_t probeBit(std::uint64_t hash, size_t i) {
+            const auto h1 = static_cast<std::uint32_t>(hash);
+            const std::uint32_t h2 = ((h1 >> 17) | (h1 << 15)) | 1u;
+            return (h1 + static_cast<std::uint32_t>(i) * h2) & 511u;
+        }
+    } // anonymous namespace
+
+    void BloomFilter::reset(size_t expected_keys) {
+        const size_t bits = std::max<size_t>(expected_keys, 1) * kBloomBitsPerKey;
+        blocks_.assign((bits + 511) / 512, Block{});
+    }
+
+    size_t BloomFilter::blockIndex(std::uint64_t hash) const {
+        // 高 32 位与块数相乘取块号（避免取模），与块内探测使用的低位相互独立
+        return static_cast<size_t>(((hash >> 32) * static_cast<std::uint64_t>(blocks_.size())) >> 32);
+    }
+
+    void BloomFilter::add(std::uint64_t hash) {
+        if (blocks_.empty()) {
+            return;
+        }
+        Block& block = blocks_[blockIndex(hash)];
+        for (size_t i = 0; i < kBloomProbes; ++i) {
+            const std::uint32_t bit = probeBit(hash, i);
+            block.words[bit / 64] |= std::uint64_t{ 1 } << (bit % 64);
+        }
+    }
+
+    bool BloomFilter::mayContain(std::uint64_t hash) const {
+        if (blocks_.empty()) {
+            return false;
+        }
+        const Block& block = blocks_[blockIndex(hash)];
+        for (size_t i = 0; i < kBloomProbes; ++i) {
+            const std::uint32_t bit = probeBit(hash, i);
+            if (!(block.words[bit / 64] & (std::uint64_t{ 1 } << (bit % 64)))) {
+                return false;
+            }
+        }
+        return true;
+    }
+} // namespace wiser
@@ -5,7 +5,7 @@
  * 本文件实现 wiser::Database，对 SQLite 进行薄封装，提供：
  * - 文档表、词元表、设置表的创建与访问
  * - 预编译语句的准备/释放，减少重复解析 SQL 的开销
- * - 倒排列表（BLOB）读写接口
+ * - 倒排列表（BLOB）读写接口：每次刷新写入一个不可变段，后台合并（见 SegmentCompactor）
  * - 简单的事务控制接口
  *
  * 线程安全策略：
@@ -14,9 +14,14 @@
 
 #include "wiser/database.h"
 #include "wiser/utils.h"
+#include "wiser/postings_file.h"
 #include <sqlite3.h>
+#include <algorithm>
+#include <charconv>
 #include <stdexcept>
 #include <cstring>
+#include <filesystem>
+#include <format>
 #include <optional>
 #include <string>
 
@@ -30,6 +35,7 @@ namespace wiser {
      * - 文档相关查询语句（ID、标题、正文获取，文档插入更新）
      * - 词项相关查询语句（ID获取、词项获取、词项存储）
      * - 倒排列表相关查询语句（获取、更新）
+     * - 索引段相关语句（创建、写入、发布、删除、列举）
      * - 设置相关查询语句（获取、替换）
      * - 统计相关查询语句（文档计数、总词项计数、文档词项计数）
      * - 事务控制语句（开始、提交、回滚）
@@ -38,8 +44,13 @@ namespace wiser {
     Database::Database()
         : db_(nullptr), get_document_id_stmt_(nullptr), get_document_title_stmt_(nullptr),
           get_document_body_stmt_(nullptr), insert_document_stmt_(nullptr), update_document_stmt_(nullptr),
-          get_token_id_stmt_(nullptr), get_token_stmt_(nullptr), store_token_stmt_(nullptr),
-          get_postings_stmt_(nullptr), update_postings_stmt_(nullptr), get_settings_stmt_(nullptr),
+          get_token_stmt_(nullptr),
+          store_token_with_id_stmt_(nullptr), list_tokens_stmt_(nullptr),
+          get_postings_stmt_(nullptr), get_segment_postings_stmt_(nullptr),
+          get_postings_stats_stmt_(nullptr),
+          create_segment_stmt_(nullptr), insert_segment_postings_stmt_(nullptr), publish_segment_stmt_(nullptr),
+          delete_segment_postings_stmt_(nullptr), delete_segment_stmt_(nullptr), list_segments_stmt_(nullptr),
+          list_segment_tokens_stmt_(nullptr), get_settings_stmt_(nullptr),
           replace_settings_stmt_(nullptr), get_document_count_stmt_(nullptr), get_total_token_count_stmt_(nullptr),
           get_doc_token_count_stmt_(nullptr), update_doc_token_count_stmt_(nullptr), get_all_token_counts_stmt_(nullptr), list_documents_stmt_(nullptr), like_search_stmt_(nullptr),
           begin_stmt_(nullptr), commit_stmt_(nullptr), rollback_stmt_(nullptr) {}
@@ -103,6 +114,7 @@ namespace wiser {
         
         // 将字符串视图转换为 std::string（SQLite API 需要 C 风格字符串）
         std::string path(db_path);
+        db_path_ = path;
         
         // 打开 SQLite 数据库文件
         int rc = sqlite3_open(path.c_str(), &db_);
@@ -127,6 +139,12 @@ namespace wiser {
             close();
             return false;
         }
+
+        // 映射已发布的倒排文件段；文件缺失或损坏时失败，避免查询静默缺少结果
+        if (!loadFileSegments()) {
+            close();
+            return false;
+        }
         
         // 所有初始化步骤成功完成
         return true;
@@ -147,6 +165,7 @@ namespace wiser {
         
         // 最终化所有预处理语句，释放 SQLite 资源
         finalizeStatements();
+        file_segments_.reset();
         
         // 检查数据库连接是否有效，然后关闭连接
         if (db_) {
@@ -393,40 +412,6 @@ namespace wiser {
         return sqlite3_step(update_doc_token_count_stmt_) == SQLITE_DONE;
     }
 
-    std::optional<TokenInfo> Database::getTokenInfo(std::string_view token, bool insert) {
-        std::lock_guard<std::recursive_mutex> lock(stmt_mutex_);
-        if (!get_token_id_stmt_)
-            return std::nullopt;
-        sqlite3_reset(get_token_id_stmt_);
-        sqlite3_bind_text(get_token_id_stmt_, 1, token.data(), static_cast<int>(token.size()), SQLITE_STATIC);
-        int rc = sqlite3_step(get_token_id_stmt_);
-        if (rc == SQLITE_ROW) {
-            TokenInfo info{};
-            info.id = static_cast<TokenId>(sqlite3_column_int(get_token_id_stmt_, 0));
-            info.docs_count = static_cast<Count>(sqlite3_column_int(get_token_id_stmt_, 1));
-            return info;
-        }
-        if (insert && store_token_stmt_) {
-            static const unsigned char empty_blob_marker[] = ""; // 非空指针，长度0
-            sqlite3_reset(store_token_stmt_);
-            sqlite3_bind_text(store_token_stmt_, 1, token.data(), static_cast<int>(token.size()), SQLITE_STATIC);
-            sqlite3_bind_blob(store_token_stmt_, 2, empty_blob_marker, 0, SQLITE_STATIC);
-            rc = sqlite3_step(store_token_stmt_);
-            if (rc == SQLITE_DONE) {
-                sqlite3_reset(get_token_id_stmt_);
-                sqlite3_bind_text(get_token_id_stmt_, 1, token.data(), static_cast<int>(token.size()), SQLITE_STATIC);
-                rc = sqlite3_step(get_token_id_stmt_);
-                if (rc == SQLITE_ROW) {
-                    TokenInfo info{};
-                    info.id = static_cast<TokenId>(sqlite3_column_int(get_token_id_stmt_, 0));
-                    info.docs_count = static_cast<Count>(sqlite3_column_int(get_token_id_stmt_, 1));
-                    return info;
-                }
-            }
-        }
-        return std::nullopt;
-    }
-
     std::string Database::getToken(TokenId token_id) {
         std::lock_guard<std::recursive_mutex> lock(stmt_mutex_);
         if (!get_token_stmt_)
@@ -441,43 +426,463 @@ namespace wiser {
         return "";
     }
 
-    std::optional<PostingsRecord> Database::getPostings(TokenId token_id) {
+    /**
+     * @brief 读取全部词元的 (id, token)
+     *
+     * 用于启动时预热进程内词元字典（TokenDictionary）。
+     *
+     * @return std::vector<std::pair<TokenId, std::string>> 词元 ID 与词元字符串列表
+     */
+    std::vector<std::pair<TokenId, std::string>> Database::getAllTokens() {
+        std::lock_guard<std::recursive_mutex> lock(stmt_mutex_);
+        std::vector<std::pair<TokenId, std::string>> tokens;
+        if (!list_tokens_stmt_)
+            return tokens;
+        // list_tokens_stmt_：SELECT id, token FROM tokens ORDER BY token;
+        // 按 token_index 顺序读取：覆盖索引即可满足查询，无需访问行数据（postings BLOB），且结果已按词元排序
+        sqlite3_reset(list_tokens_stmt_);
+        while (sqlite3_step(list_tokens_stmt_) == SQLITE_ROW) {
+            TokenId id = static_cast<TokenId>(sqlite3_column_int(list_tokens_stmt_, 0));
+            const char* token = reinterpret_cast<const char*>(sqlite3_column_text(list_tokens_stmt_, 1));
+            int token_size = sqlite3_column_bytes(list_tokens_stmt_, 1);
+            tokens.emplace_back(id, token ? std::string(token, static_cast<size_t>(token_size)) : std::string());
+        }
+        return tokens;
+    }
+
+    /**
+     * @brief 批量写入由词元字典分配好 ID 的新词元
+     *
+     * 词元行只用于保留 ID：tokens 表的倒排列表保持空 BLOB、docs_count 保持 0，倒排数据写入本次刷新的新段。
+     *
+     * @param tokens (id, token) 列表
+     * @return bool 全部写入成功返回 true
+     */
+    bool Database::storeTokens(const std::vector<std::pair<TokenId, std::string>>& tokens) {
+        std::lock_guard<std::recursive_mutex> lock(stmt_mutex_);
+        if (!store_token_with_id_stmt_)
+            return false;
+        static const unsigned char empty_blob_marker[] = ""; // 非空指针，长度0
+        for (const auto& [id, token]: tokens) {
+            sqlite3_reset(store_token_with_id_stmt_);
+            sqlite3_bind_int(store_token_with_id_stmt_, 1, static_cast<int>(id));
+            sqlite3_bind_text(store_token_with_id_stmt_, 2, token.data(), static_cast<int>(token.size()),
+                              SQLITE_STATIC);
+            sqlite3_bind_blob(store_token_with_id_stmt_, 3, empty_blob_marker, 0, SQLITE_STATIC);
+            if (sqlite3_step(store_token_with_id_stmt_) != SQLITE_DONE) {
+                spdlog::error("Failed to store token {}: {}", id, sqlite3_errmsg(db_));
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::optional<PostingsStats> Database::getPostingsStats(TokenId token_id) {
+        std::optional<PostingsStats> stats;
+        auto add = [&stats](Count docs_count, DocId first_doc, DocId last_doc) {
+            if (!stats) {
+                stats = PostingsStats{ 0, first_doc, last_doc };
+            }
+            stats->docs_count += docs_count;
+            stats->first_doc = std::min(stats->first_doc, first_doc);
+            stats->last_doc = std::max(stats->last_doc, last_doc);
+        };
+
+        std::shared_ptr<const FileSegments> file_segments;
+        {
+            std::lock_guard<std::recursive_mutex> lock(stmt_mutex_);
+            if (!get_postings_stats_stmt_)
+                return std::nullopt;
+            file_segments = file_segments_;
+            sqlite3_reset(get_postings_stats_stmt_);
+            sqlite3_bind_int(get_postings_stats_stmt_, 1, static_cast<int>(token_id));
+            if (sqlite3_step(get_postings_stats_stmt_) == SQLITE_ROW) {
+                if (sqlite3_column_int(get_postings_stats_stmt_, 1) > 0) {
+                    add(static_cast<Count>(sqlite3_column_int(get_postings_stats_stmt_, 2)),
+                        static_cast<DocId>(sqlite3_column_int(get_postings_stats_stmt_, 3)),
+                        static_cast<DocId>(sqlite3_column_int(get_postings_stats_stmt_, 4)));
+                }
+                if (sqlite3_column_type(get_postings_stats_stmt_, 0) != SQLITE_NULL) {
+                    // 旧版记录没有保存文档区间
+                    add(static_cast<Count>(sqlite3_column_int(get_postings_stats_stmt_, 0)), kMinDocId, kMaxDocId);
+                }
+            }
+            sqlite3_reset(get_postings_stats_stmt_);
+        }
+
+        // 倒排文件段的目录在映射内存中，无需加锁
+        if (file_segments) {
+            for (const auto& segment: *file_segments) {
+                if (const PostingsFileEntry* entry = segment.file->find(token_id)) {
+                    add(entry->docs_count, entry->first_doc, entry->last_doc);
+                }
+            }
+        }
+        return stats;
+    }
+
+    bool Database::visitPostings(TokenId token_id, const PostingsVisitor& visitor, DocId min_doc, DocId max_doc) {
+        bool visited = visitLegacyPostings(token_id, visitor);
+        // 各段的记录（倒排文件段在释放语句锁之后访问）
+        visited |= visitSegmentPostings(token_id, [&visitor](SegmentId, Count docs_count, DocId, DocId,
+                                                             std::span<const char> postings) {
+            visitor(docs_count, postings);
+        }, min_doc, max_doc);
+        return visited;
+    }
+
+    bool Database::collectPostings(TokenId token_id, std::vector<std::span<const char>>& postings,
+                                   PostingsSnapshot& snapshot, DocId min_doc, DocId max_doc) {
+        // SQLite 中的记录：BLOB 只在回调期间有效，复制一次（移动 blobs 中的 vector 不改变其缓冲区地址）
+        auto copy = [&postings, &snapshot](std::span<const char> blob) {
+            postings.push_back(snapshot.blobs.emplace_back(blob.begin(), blob.end()));
+        };
+        bool visited = visitLegacyPostings(token_id, [&copy](Count, std::span<const char> blob) { copy(blob); });
+        auto file_segments = visitStoredSegmentPostings(token_id, [&copy](SegmentId, Count, DocId, DocId,
+                                                                          std::span<const char> blob) {
+            copy(blob);
+        }, min_doc, max_doc, visited);
+
+        // 倒排文件段的记录：只保存指向映射内存的视图，并持有与 SQL 结果同一时刻的快照
+        const bool mapped = visitFileSegmentPostings(file_segments.get(), token_id,
+                                                     [&postings](SegmentId, Count, DocId, DocId,
+                                                                 std::span<const char> blob) {
+                                                         postings.push_back(blob);
+                                                     }, min_doc, max_doc);
+        if (mapped && (snapshot.file_segments.empty() || snapshot.file_segments.back() != file_segments)) {
+            snapshot.file_segments.push_back(std::move(file_segments));
+        }
+        return visited || mapped;
+    }
+
+    bool Database::visitLegacyPostings(TokenId token_id, const PostingsVisitor& visitor) {
         std::lock_guard<std::recursive_mutex> lock(stmt_mutex_);
         if (!get_postings_stmt_)
-            return std::nullopt;
+            return false;
+        bool visited = false;
+        // 旧版库的倒排保存在 tokens.postings；新库中该列始终为空 BLOB
         sqlite3_reset(get_postings_stmt_);
         sqlite3_bind_int(get_postings_stmt_, 1, static_cast<int>(token_id));
-        int rc = sqlite3_step(get_postings_stmt_);
-        if (rc == SQLITE_ROW) {
-            PostingsRecord rec{};
-            rec.docs_count = static_cast<Count>(sqlite3_column_int(get_postings_stmt_, 0));
+        if (sqlite3_step(get_postings_stmt_) == SQLITE_ROW) {
             const void* blob = sqlite3_column_blob(get_postings_stmt_, 1);
-            int blob_size = sqlite3_column_bytes(get_postings_stmt_, 1);
+            const int blob_size = sqlite3_column_bytes(get_postings_stmt_, 1);
             if (blob && blob_size > 0) {
-                const char* data = static_cast<const char*>(blob);
-                rec.postings.assign(data, data + blob_size);
+                visitor(static_cast<Count>(sqlite3_column_int(get_postings_stmt_, 0)),
+                        { static_cast<const char*>(blob), static_cast<size_t>(blob_size) });
+                visited = true;
+            }
+        }
+        // 释放结果行对 BLOB 的引用，避免读事务在语句上悬挂
+        sqlite3_reset(get_postings_stmt_);
+        return visited;
+    }
+
+    bool Database::visitSegmentPostings(TokenId token_id, const SegmentPostingsVisitor& visitor, DocId min_doc,
+                                        DocId max_doc) {
+        bool visited = false;
+        auto file_segments = visitStoredSegmentPostings(token_id, visitor, min_doc, max_doc, visited);
+        visited |= visitFileSegmentPostings(file_segments.get(), token_id, visitor, min_doc, max_doc);
+        return visited;
+    }
+
+    std::shared_ptr<const FileSegments> Database::visitStoredSegmentPostings(TokenId token_id,
+                                                                             const SegmentPostingsVisitor& visitor,
+                                                                             DocId min_doc, DocId max_doc,
+                                                                             bool& visited) {
+        std::shared_ptr<const FileSegments> file_segments;
+        {
+            std::lock_guard<std::recursive_mutex> lock(stmt_mutex_);
+            if (!get_segment_postings_stmt_)
+                return nullptr;
+            // 与 SQL 结果取自同一时刻的段集合（段的替换同样在持有该锁时进行）
+            file_segments = file_segments_;
+            sqlite3_reset(get_segment_postings_stmt_);
+            sqlite3_bind_int(get_segment_postings_stmt_, 1, static_cast<int>(token_id));
+            sqlite3_bind_int(get_segment_postings_stmt_, 2, static_cast<int>(min_doc));
+            sqlite3_bind_int(get_segment_postings_stmt_, 3, static_cast<int>(max_doc));
+            while (sqlite3_step(get_segment_postings_stmt_) == SQLITE_ROW) {
+                const auto segment_id = static_cast<SegmentId>(sqlite3_column_int64(get_segment_postings_stmt_, 0));
+                const auto docs_count = static_cast<Count>(sqlite3_column_int(get_segment_postings_stmt_, 1));
+                const auto first_doc = static_cast<DocId>(sqlite3_column_int(get_segment_postings_stmt_, 2));
+                const auto last_doc = static_cast<DocId>(sqlite3_column_int(get_segment_postings_stmt_, 3));
+                const void* blob = sqlite3_column_blob(get_segment_postings_stmt_, 4);
+                const int blob_size = sqlite3_column_bytes(get_segment_postings_stmt_, 4);
+                std::span<const char> postings;
+                if (blob && blob_size > 0) {
+                    postings = { static_cast<const char*>(blob), static_cast<size_t>(blob_size) };
+                }
+                visitor(segment_id, docs_count, first_doc, last_doc, postings);
+                visited = true;
             }
-            return rec;
+            sqlite3_reset(get_segment_postings_stmt_);
         }
-        return std::nullopt;
+        return file_segments;
     }
 
-    bool Database::updatePostings(TokenId token_id, Count docs_count, const std::vector<char>& postings) {
+    bool Database::visitFileSegmentPostings(const FileSegments* file_segments, TokenId token_id,
+                                            const SegmentPostingsVisitor& visitor, DocId min_doc, DocId max_doc) {
+        // 倒排文件段：不经过 SQL，不加锁，postings 直接指向映射内存
+        if (!file_segments) {
+            return false;
+        }
+        bool visited = false;
+        for (const auto& segment: *file_segments) {
+            const PostingsFileEntry* entry = segment.file->find(token_id);
+            if (!entry || entry->last_doc < min_doc || entry->first_doc > max_doc) {
+                continue;
+            }
+            visitor(segment.id, entry->docs_count, entry->first_doc, entry->last_doc, segment.file->postings(*entry));
+            visited = true;
+        }
+        return visited;
+    }
+
+    std::optional<SegmentId> Database::createSegment() {
         std::lock_guard<std::recursive_mutex> lock(stmt_mutex_);
-        if (!update_postings_stmt_)
+        if (!create_segment_stmt_)
+            return std::nullopt;
+        sqlite3_reset(create_segment_stmt_);
+        if (sqlite3_step(create_segment_stmt_) != SQLITE_DONE) {
+            spdlog::error("Failed to create segment: {}", sqlite3_errmsg(db_));
+            return std::nullopt;
+        }
+        return static_cast<SegmentId>(sqlite3_last_insert_rowid(db_));
+    }
+
+    bool Database::addSegmentPostings(SegmentId segment_id, const SegmentPostingsRecord& record) {
+        std::lock_guard<std::recursive_mutex> lock(stmt_mutex_);
+        if (!insert_segment_postings_stmt_)
             return false;
-        sqlite3_reset(update_postings_stmt_);
-        sqlite3_bind_int(update_postings_stmt_, 1, static_cast<int>(docs_count));
-        if (postings.empty()) {
-            static const unsigned char empty_blob_marker[] = "";
-            sqlite3_bind_blob(update_postings_stmt_, 2, empty_blob_marker, 0, SQLITE_STATIC);
+        static const unsigned char empty_blob_marker[] = "";
+        sqlite3_reset(insert_segment_postings_stmt_);
+        sqlite3_bind_int64(insert_segment_postings_stmt_, 1, segment_id);
+        sqlite3_bind_int(insert_segment_postings_stmt_, 2, static_cast<int>(record.token_id));
+        sqlite3_bind_int(insert_segment_postings_stmt_, 3, static_cast<int>(record.docs_count));
+        sqlite3_bind_int(insert_segment_postings_stmt_, 4, static_cast<int>(record.first_doc));
+        sqlite3_bind_int(insert_segment_postings_stmt_, 5, static_cast<int>(record.last_doc));
+        if (record.postings.empty()) {
+            sqlite3_bind_blob(insert_segment_postings_stmt_, 6, empty_blob_marker, 0, SQLITE_STATIC);
         } else {
-            sqlite3_bind_blob(update_postings_stmt_, 2, postings.data(), static_cast<int>(postings.size()),
-                              SQLITE_STATIC);
+            sqlite3_bind_blob(insert_segment_postings_stmt_, 6, record.postings.data(),
+                              static_cast<int>(record.postings.size()), SQLITE_STATIC);
         }
-        sqlite3_bind_int(update_postings_stmt_, 3, static_cast<int>(token_id));
-        int rc = sqlite3_step(update_postings_stmt_);
-        return rc == SQLITE_DONE;
+        return sqlite3_step(insert_segment_postings_stmt_) == SQLITE_DONE;
+    }
+
+    bool Database::addSegmentPostingsBatch(SegmentId segment_id, const std::vector<SegmentPostingsRecord>& records) {
+        std::lock_guard<std::recursive_mutex> lock(stmt_mutex_);
+        if (!beginTransaction())
+            return false;
+        for (const auto& record: records) {
+            if (!addSegmentPostings(segment_id, record)) {
+                spdlog::error("Failed to write postings of token {} to segment {}: {}", record.token_id, segment_id,
+                              sqlite3_errmsg(db_));
+                rollbackTransaction();
+                return false;
+            }
+        }
+        if (!commitTransaction()) {
+            rollbackTransaction();
+            return false;
+        }
+        return true;
+    }
+
+    bool Database::publishSegment(SegmentId segment_id, std::int64_t size, bool file) {
+        std::lock_guard<std::recursive_mutex> lock(stmt_mutex_);
+        if (!publish_segment_stmt_)
+            return false;
+        sqlite3_reset(publish_segment_stmt_);
+        sqlite3_bind_int64(publish_segment_stmt_, 1, size);
+        sqlite3_bind_int(publish_segment_stmt_, 2, file ? 1 : 0);
+        sqlite3_bind_int64(publish_segment_stmt_, 3, segment_id);
+        return sqlite3_step(publish_segment_stmt_) == SQLITE_DONE;
+    }
+
+    bool Database::replaceSegments(SegmentId segment_id, std::int64_t size, const std::vector<SegmentId>& replaced,
+                                   bool file) {
+        // 先映射新段的文件：映射失败时不发布
+        std::shared_ptr<const MappedPostingsFile> mapped;
+        if (file) {
+            mapped = MappedPostingsFile::open(segmentFilePath(segment_id));
+            if (!mapped) {
+                return false;
+            }
+        }
+
+        std::lock_guard<std::recursive_mutex> lock(stmt_mutex_);
+        if (!beginTransaction())
+            return false;
+        // 被合并的段须仍为已发布状态：若合并读到的段随后消失（如所属刷新事务回滚），
+        // 发布新段会让已撤销的倒排重新出现，而 dropSegmentRows 删除 0 行也会报告成功
+        const auto live = getSegments();
+        for (SegmentId old_id: replaced) {
+            if (std::ranges::find(live, old_id, &SegmentInfo::id) == live.end()) {
+                spdlog::warn("Segment {} no longer exists; discarding merged segment {}.", old_id, segment_id);
+                rollbackTransaction();
+                return false;
+            }
+        }
+        bool ok = publishSegment(segment_id, size, file);
+        for (SegmentId old_id: replaced) {
+            ok = ok && dropSegmentRows(old_id);
+        }
+        if (!ok || !commitTransaction()) {
+            spdlog::error("Failed to publish merged segment {}: {}", segment_id, sqlite3_errmsg(db_));
+            rollbackTransaction();
+            return false;
+        }
+
+        // 与段表同步替换文件段快照；已取得旧快照的查询继续读取旧映射
+        auto segments = std::make_shared<FileSegments>();
+        std::vector<SegmentId> removed_files;
+        if (file_segments_) {
+            for (const auto& segment: *file_segments_) {
+                if (std::ranges::find(replaced, segment.id) == replaced.end()) {
+                    segments->push_back(segment);
+                } else {
+                    removed_files.push_back(segment.id);
+                }
+            }
+        }
+        if (mapped) {
+            segments->push_back(FileSegment{ segment_id, std::move(mapped) });
+            std::ranges::sort(*segments, {}, &FileSegment::id);
+        }
+        file_segments_ = std::move(segments);
+
+        // 映射不依赖文件名，删除文件不影响仍在读取的查询；删除失败的文件在下次启动时清理
+        for (SegmentId old_id: removed_files) {
+            std::error_code ec;
+            std::filesystem::remove(segmentFilePath(old_id), ec);
+        }
+        return true;
+    }
+
+    bool Database::dropSegment(SegmentId segment_id) {
+        std::lock_guard<std::recursive_mutex> lock(stmt_mutex_);
+        std::error_code ec;
+        std::filesystem::remove(segmentFilePath(segment_id), ec);
+        return dropSegmentRows(segment_id);
+    }
+
+    bool Database::dropSegmentRows(SegmentId segment_id) {
+        std::lock_guard<std::recursive_mutex> lock(stmt_mutex_);
+        if (!delete_segment_postings_stmt_ || !delete_segment_stmt_)
+            return false;
+        sqlite3_reset(delete_segment_postings_stmt_);
+        sqlite3_bind_int64(delete_segment_postings_stmt_, 1, segment_id);
+        if (sqlite3_step(delete_segment_postings_stmt_) != SQLITE_DONE)
+            return false;
+        sqlite3_reset(delete_segment_stmt_);
+        sqlite3_bind_int64(delete_segment_stmt_, 1, segment_id);
+        return sqlite3_step(delete_segment_stmt_) == SQLITE_DONE;
+    }
+
+    bool Database::dropUnpublishedSegments() {
+        std::lock_guard<std::recursive_mutex> lock(stmt_mutex_);
+        if (!db_)
+            return false;
+        char* error_msg = nullptr;
+        int rc = sqlite3_exec(db_,
+                              "DELETE FROM segment_postings WHERE segment_id IN (SELECT id FROM segments WHERE live = 0);"
+                              "DELETE FROM segments WHERE live = 0;",
+                              nullptr, nullptr, &error_msg);
+        if (rc != SQLITE_OK) {
+            spdlog::error("Failed to drop unpublished segments: {}", error_msg);
+            sqlite3_free(error_msg);
+            return false;
+        }
+
+        // 不属于已发布文件段的倒排文件：未发布的合并结果，或被合并后未能删除的旧段
+        const std::filesystem::path db_file(db_path_);
+        const std::string prefix = db_file.filename().string() + ".seg";
+        std::error_code ec;
+        std::filesystem::directory_iterator it(db_file.has_parent_path() ? db_file.parent_path() : ".", ec);
+        for (; !ec && it != std::filesystem::directory_iterator(); it.increment(ec)) {
+            const std::string name = it->path().filename().string();
+            if (!name.starts_with(prefix)) {
+                continue;
+            }
+            SegmentId id = 0;
+            const auto [end, parse_ec] = std::from_chars(name.data() + prefix.size(), name.data() + name.size(), id);
+            if (parse_ec != std::errc{} || end != name.data() + name.size()) {
+                continue;
+            }
+            const bool live = file_segments_ && std::ranges::find(*file_segments_, id, &FileSegment::id) !=
+                                                    file_segments_->end();
+            if (!live) {
+                std::error_code remove_ec;
+                std::filesystem::remove(it->path(), remove_ec);
+            }
+        }
+        return true;
+    }
+
+    std::string Database::segmentFilePath(SegmentId segment_id) const {
+        return db_path_ + ".seg" + std::to_string(segment_id);
+    }
+
+    bool Database::loadFileSegments() {
+        std::lock_guard<std::recursive_mutex> lock(stmt_mutex_);
+        auto segments = std::make_shared<FileSegments>();
+        sqlite3_stmt* stmt = nullptr;
+        if (sqlite3_prepare_v2(db_, "SELECT id FROM segments WHERE live = 1 AND file = 1 ORDER BY id;", -1, &stmt,
+                               nullptr) != SQLITE_OK) {
+            spdlog::error("Failed to list postings file segments: {}", sqlite3_errmsg(db_));
+            return false;
+        }
+        bool ok = true;
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            const auto id = static_cast<SegmentId>(sqlite3_column_int64(stmt, 0));
+            auto file = MappedPostingsFile::open(segmentFilePath(id));
+            if (!file) {
+                ok = false;
+                break;
+            }
+            segments->push_back(FileSegment{ id, std::move(file) });
+        }
+        sqlite3_finalize(stmt);
+        file_segments_ = std::move(segments);
+        return ok;
+    }
+
+    std::vector<SegmentInfo> Database::getSegments() {
+        std::lock_guard<std::recursive_mutex> lock(stmt_mutex_);
+        std::vector<SegmentInfo> segments;
+        if (!list_segments_stmt_)
+            return segments;
+        // list_segments_stmt_：SELECT id, size FROM segments WHERE live = 1 ORDER BY id;
+        sqlite3_reset(list_segments_stmt_);
+        while (sqlite3_step(list_segments_stmt_) == SQLITE_ROW) {
+            segments.push_back(SegmentInfo{ static_cast<SegmentId>(sqlite3_column_int64(list_segments_stmt_, 0)),
+                                            sqlite3_column_int64(list_segments_stmt_, 1) });
+        }
+        sqlite3_reset(list_segments_stmt_);
+        return segments;
+    }
+
+    std::vector<TokenId> Database::getSegmentTokens(SegmentId segment_id) {
+        std::lock_guard<std::recursive_mutex> lock(stmt_mutex_);
+        std::vector<TokenId> tokens;
+        if (file_segments_) {
+            auto it = std::ranges::find(*file_segments_, segment_id, &FileSegment::id);
+            if (it != file_segments_->end()) {
+                for (const auto& entry: it->file->entries()) {
+                    tokens.push_back(entry.token_id);
+                }
+                return tokens;
+            }
+        }
+        if (!list_segment_tokens_stmt_)
+            return tokens;
+        sqlite3_reset(list_segment_tokens_stmt_);
+        sqlite3_bind_int64(list_segment_tokens_stmt_, 1, segment_id);
+        while (sqlite3_step(list_segment_tokens_stmt_) == SQLITE_ROW) {
+            tokens.push_back(static_cast<TokenId>(sqlite3_column_int(list_segment_tokens_stmt_, 0)));
+        }
+        sqlite3_reset(list_segment_tokens_stmt_);
+        return tokens;
     }
 
     Config Database::getConfig() {
@@ -488,6 +893,11 @@ namespace wiser {
             try { config.token_len = std::stoi(val); } catch (...) {}
         }
 
+        val = getSetting("analyzer");
+        if (!val.empty()) {
+            try { config.analyzer = static_cast<AnalyzerType>(std::stoi(val)); } catch (...) {}
+        }
+
         val = getSetting("buffer_update_threshold");
         if (!val.empty()) {
             try { config.buffer_update_threshold = std::stoi(val); } catch (...) {}
@@ -597,6 +1007,25 @@ namespace wiser {
                     "  postings   BLOB NOT NULL"
                     ");",
 
+                    // 不可变索引段：live = 0 表示尚未发布（刷新或合并进行中），查询只读取已发布的段
+                    "CREATE TABLE IF NOT EXISTS segments ("
+                    "  id   INTEGER PRIMARY KEY,"
+                    "  size INT NOT NULL,"
+                    "  live INT NOT NULL,"
+                    "  file INT NOT NULL DEFAULT 0"  // 1 = 倒排存放在 <db_path>.seg<id> 文件中，而非 segment_postings
+                    ");",
+
+                    "CREATE TABLE IF NOT EXISTS segment_postings ("
+                    "  segment_id INTEGER NOT NULL,"
+                    "  token_id   INTEGER NOT NULL,"
+                    "  docs_count INT NOT NULL,"
+                    "  first_doc  INT NOT NULL,"   // 区间列放在 BLOB 之前：按区间过滤时不必读取 BLOB 的溢出页
+                    "  last_doc   INT NOT NULL,"
+                    "  postings   BLOB NOT NULL,"
+                    "  PRIMARY KEY (token_id, segment_id)"
+                    ");",
+
+                    "CREATE INDEX IF NOT EXISTS segment_postings_segment ON segment_postings(segment_id);",
                     "CREATE UNIQUE INDEX IF NOT EXISTS token_index ON tokens(token);",
                     "CREATE UNIQUE INDEX IF NOT EXISTS title_index ON documents(title);"
                 };
@@ -611,6 +1040,33 @@ namespace wiser {
                 return false;
             }
         }
+
+        // 早先创建的表缺少的列：segment_postings 已有记录的区间视为不限（查询时不会被跳过），已有段都存放在表中
+        return addColumnIfMissing("segment_postings", "first_doc", std::format("INT NOT NULL DEFAULT {}", kMinDocId)) &&
+               addColumnIfMissing("segment_postings", "last_doc", std::format("INT NOT NULL DEFAULT {}", kMaxDocId)) &&
+               addColumnIfMissing("segments", "file", "INT NOT NULL DEFAULT 0");
+    }
+
+    bool Database::addColumnIfMissing(const char* table, const char* column, const std::string& definition) {
+        sqlite3_stmt* stmt = nullptr;
+        bool exists = false;
+        if (sqlite3_prepare_v2(db_, "SELECT 1 FROM pragma_table_info(?) WHERE name = ?;", -1, &stmt, nullptr) ==
+            SQLITE_OK) {
+            sqlite3_bind_text(stmt, 1, table, -1, SQLITE_STATIC);
+            sqlite3_bind_text(stmt, 2, column, -1, SQLITE_STATIC);
+            exists = sqlite3_step(stmt) == SQLITE_ROW;
+        }
+        sqlite3_finalize(stmt);
+        if (exists) {
+            return true;
+        }
+        const std::string alter = std::format("ALTER TABLE {} ADD COLUMN {} {};", table, column, definition);
+        char* error_msg = nullptr;
+        if (sqlite3_exec(db_, alter.c_str(), nullptr, nullptr, &error_msg) != SQLITE_OK) {
+            spdlog::error("SQL error: {}", error_msg);
+            sqlite3_free(error_msg);
+            return false;
+        }
         return true;
     }
 
@@ -626,12 +1082,32 @@ namespace wiser {
                             { "SELECT body FROM documents WHERE id = ?;", &get_document_body_stmt_ },
                             { "INSERT INTO documents (title, body, token_count) VALUES (?, ?, ?);", &insert_document_stmt_ },
                             { "UPDATE documents SET body = ? WHERE id = ?;", &update_document_stmt_ },
-                            { "SELECT id, docs_count FROM tokens WHERE token = ?;", &get_token_id_stmt_ },
                             { "SELECT token FROM tokens WHERE id = ?;", &get_token_stmt_ },
-                            { "INSERT OR IGNORE INTO tokens (token, docs_count, postings) VALUES (?, 0, ?);",
-                              &store_token_stmt_ },
+                            { "INSERT OR IGNORE INTO tokens (id, token, docs_count, postings) VALUES (?, ?, 0, ?);",
+                              &store_token_with_id_stmt_ },
+                            { "SELECT id, token FROM tokens ORDER BY token;", &list_tokens_stmt_ },
                             { "SELECT docs_count, postings FROM tokens WHERE id = ?;", &get_postings_stmt_ },
-                            { "UPDATE tokens SET docs_count = ?, postings = ? WHERE id = ?;", &update_postings_stmt_ },
+                            { "SELECT p.segment_id, p.docs_count, p.first_doc, p.last_doc, p.postings FROM segment_postings p "
+                              "JOIN segments s ON s.id = p.segment_id "
+                              "WHERE p.token_id = ?1 AND s.live = 1 AND p.last_doc >= ?2 AND p.first_doc <= ?3 "
+                              "ORDER BY p.segment_id;",
+                              &get_segment_postings_stmt_ },
+                            // length() 对 BLOB 只读记录头，不读取内容
+                            { "SELECT (SELECT docs_count FROM tokens WHERE id = ?1 AND length(postings) > 0), "
+                              "COUNT(*), SUM(p.docs_count), MIN(p.first_doc), MAX(p.last_doc) "
+                              "FROM segment_postings p JOIN segments s ON s.id = p.segment_id "
+                              "WHERE p.token_id = ?1 AND s.live = 1;",
+                              &get_postings_stats_stmt_ },
+                            { "INSERT INTO segments (size, live) VALUES (0, 0);", &create_segment_stmt_ },
+                            { "INSERT INTO segment_postings (segment_id, token_id, docs_count, first_doc, last_doc, postings) "
+                              "VALUES (?, ?, ?, ?, ?, ?);",
+                              &insert_segment_postings_stmt_ },
+                            { "UPDATE segments SET size = ?, live = 1, file = ? WHERE id = ?;", &publish_segment_stmt_ },
+                            { "DELETE FROM segment_postings WHERE segment_id = ?;", &delete_segment_postings_stmt_ },
+                            { "DELETE FROM segments WHERE id = ?;", &delete_segment_stmt_ },
+                            { "SELECT id, size FROM segments WHERE live = 1 ORDER BY id;", &list_segments_stmt_ },
+                            { "SELECT token_id FROM segment_postings WHERE segment_id = ? ORDER BY token_id;",
+                              &list_segment_tokens_stmt_ },
                             { "SELECT value FROM settings WHERE key = ?;", &get_settings_stmt_ },
                             { "INSERT OR REPLACE INTO settings (key, value) VALUES (?, ?);", &replace_settings_stmt_ },
                             { "SELECT COUNT(*) FROM documents;", &get_document_count_stmt_ },
@@ -662,8 +1138,12 @@ namespace wiser {
         // 统一 finalize 所有已准备的语句；SQLite 要求每个 stmt* 仅 finalize 一次
         sqlite3_stmt* statements[] = {
                     get_document_id_stmt_, get_document_title_stmt_, get_document_body_stmt_, insert_document_stmt_,
-                    update_document_stmt_, get_token_id_stmt_, get_token_stmt_,
-                    store_token_stmt_, get_postings_stmt_, update_postings_stmt_,
+                    update_document_stmt_, get_token_stmt_,
+                    store_token_with_id_stmt_, list_tokens_stmt_,
+                    get_postings_stmt_,
+                    get_segment_postings_stmt_, get_postings_stats_stmt_, create_segment_stmt_, insert_segment_postings_stmt_,
+                    publish_segment_stmt_, delete_segment_postings_stmt_, delete_segment_stmt_,
+                    list_segments_stmt_, list_segment_tokens_stmt_,
                     get_settings_stmt_, replace_settings_stmt_, get_document_count_stmt_,
                     get_total_token_count_stmt_, get_doc_token_count_stmt_, update_doc_token_count_stmt_,
                     get_all_token_counts_stmt_,
@@ -683,11 +1163,19 @@ namespace wiser {
         get_document_body_stmt_ = nullptr;
         insert_document_stmt_ = nullptr;
         update_document_stmt_ = nullptr;
-        get_token_id_stmt_ = nullptr;
         get_token_stmt_ = nullptr;
-        store_token_stmt_ = nullptr;
+        store_token_with_id_stmt_ = nullptr;
+        list_tokens_stmt_ = nullptr;
         get_postings_stmt_ = nullptr;
-        update_postings_stmt_ = nullptr;
+        get_segment_postings_stmt_ = nullptr;
+        get_postings_stats_stmt_ = nullptr;
+        create_segment_stmt_ = nullptr;
+        insert_segment_postings_stmt_ = nullptr;
+        publish_segment_stmt_ = nullptr;
+        delete_segment_postings_stmt_ = nullptr;
+        delete_segment_stmt_ = nullptr;
+        list_segments_stmt_ = nullptr;
+        list_segment_tokens_stmt_ = nullptr;
         get_settings_stmt_ = nullptr;
         replace_settings_stmt_ = nullptr;
         get_document_count_stmt_ = nullptr;
@@ -705,16 +1193,26 @@ namespace wiser {
     void Database::moveFrom(Database&& other) noexcept {
         // 逐个转移资源所有权：sqlite3* 连接与所有预编译语句指针
         db_ = other.db_;
+        db_path_ = std::move(other.db_path_);
+        file_segments_ = std::move(other.file_segments_);
         get_document_id_stmt_ = other.get_document_id_stmt_;
         get_document_title_stmt_ = other.get_document_title_stmt_;
         get_document_body_stmt_ = other.get_document_body_stmt_;
         insert_document_stmt_ = other.insert_document_stmt_;
         update_document_stmt_ = other.update_document_stmt_;
-        get_token_id_stmt_ = other.get_token_id_stmt_;
         get_token_stmt_ = other.get_token_stmt_;
-        store_token_stmt_ = other.store_token_stmt_;
+        store_token_with_id_stmt_ = other.store_token_with_id_stmt_;
+        list_tokens_stmt_ = other.list_tokens_stmt_;
         get_postings_stmt_ = other.get_postings_stmt_;
-        update_postings_stmt_ = other.update_postings_stmt_;
+        get_segment_postings_stmt_ = other.get_segment_postings_stmt_;
+        get_postings_stats_stmt_ = other.get_postings_stats_stmt_;
+        create_segment_stmt_ = other.create_segment_stmt_;
+        insert_segment_postings_stmt_ = other.insert_segment_postings_stmt_;
+        publish_segment_stmt_ = other.publish_segment_stmt_;
+        delete_segment_postings_stmt_ = other.delete_segment_postings_stmt_;
+        delete_segment_stmt_ = other.delete_segment_stmt_;
+        list_segments_stmt_ = other.list_segments_stmt_;
+        list_segment_tokens_stmt_ = other.list_segment_tokens_stmt_;
         get_settings_stmt_ = other.get_settings_stmt_;
         replace_settings_stmt_ = other.replace_settings_stmt_;
         get_document_count_stmt_ = other.get_document_count_stmt_;
@@ -735,11 +1233,19 @@ namespace wiser {
         other.get_document_body_stmt_ = nullptr;
         other.insert_document_stmt_ = nullptr;
         other.update_document_stmt_ = nullptr;
-        other.get_token_id_stmt_ = nullptr;
         other.get_token_stmt_ = nullptr;
-        other.store_token_stmt_ = nullptr;
+        other.store_token_with_id_stmt_ = nullptr;
+        other.list_tokens_stmt_ = nullptr;
         other.get_postings_stmt_ = nullptr;
-        other.update_postings_stmt_ = nullptr;
+        other.get_segment_postings_stmt_ = nullptr;
+        other.get_postings_stats_stmt_ = nullptr;
+        other.create_segment_stmt_ = nullptr;
+        other.insert_segment_postings_stmt_ = nullptr;
+        other.publish_segment_stmt_ = nullptr;
+        other.delete_segment_postings_stmt_ = nullptr;
+        other.delete_segment_stmt_ = nullptr;
+        other.list_segments_stmt_ = nullptr;
+        other.list_segment_tokens_stmt_ = nullptr;
         other.get_settings_stmt_ = nullptr;
         other.replace_settings_stmt_ = nullptr;
         other.get_document_count_stmt_ = nullptr;
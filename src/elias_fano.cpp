@@ -0,0 +1,181 @@
+/**
+ * @file elias_fano.cpp
+ * @brief Elias-Fano 编码与 nextGEQ 视图实现
+ */
+
+#include "wiser/elias_fano.h"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+namespace wiser {
+    namespace {
+        int lowBitWidth(size_t count, std::uint32_t universe) {
+            if (count == 0 || universe < count) {
+                return 0;
+            }
+            return static_cast<int>(std::bit_width(universe / count)) - 1;
+        }
+
+        size_t wordsFor(size_t bits) {
+            return (bits + 63) / 64;
+        }
+
+        size_t highBits(size_t count, std::uint32_t universe, int l) {
+            return count + (static_cast<size_t>(universe) >> l) + 1;
+        }
+    } // anonymous namespace
+
+    size_t eliasFanoSize(size_t count, std::uint32_t universe) {
+        if (count == 0) {
+            return 0;
+        }
+        const int l = lowBitWidth(count, universe);
+        return (wordsFor(count * static_cast<size_t>(l)) + wordsFor(highBits(count, universe, l))) *
+               sizeof(std::uint64_t);
+    }
+
+    void eliasFanoEncode(std::span<const std::uint32_t> values, std::uint32_t universe, std::vector<char>& out) {
+        const size_t n = values.size();
+        if (n == 0) {
+            return;
+        }
+        const int l = lowBitWidth(n, universe);
+        std::vector<std::uint64_t> low(wordsFor(n * static_cast<size_t>(l)), 0);
+        std::vector<std::uint64_t> high(wordsFor(highBits(n, universe, l)), 0);
+        const std::uint64_t low_mask = (std::uint64_t{ 1 } << l) - 1;
+        for (size_t i = 0; i < n; ++i) {
+            if (l > 0) {
+                const std::uint64_t v = values[i] & low_mask;
+                const size_t bit = i * static_cast<size_t>(l);
+                const unsigned shift = bit % 64;
+                low[bit / 64] |= v << shift;
+                if (shift + static_cast<unsigned>(l) > 64) {
+                    low[bit / 64 + 1] |= v >> (64 - shift);
+                }
+            }
+            const size_t pos = (values[i] >> l) + i;
+            high[pos / 64] |= std::uint64_t{ 1 } << (pos % 64);
+        }
+        const char* p = reinterpret_cast<const char*>(low.data());
+        out.insert(out.end(), p, p + low.size() * sizeof(std::uint64_t));
+        p = reinterpret_cast<const char*>(high.data());
+        out.insert(out.end(), p, p + high.size() * sizeof(std::uint64_t));
+    }
+
+    EliasFanoView::EliasFanoView(const char* data, size_t count, std::uint32_t universe)
+        : count_(count) {
+        if (count == 0) {
+            return;
+        }
+        l_ = lowBitWidth(count, universe);
+        high_bits_ = highBits(count, universe, l_);
+        low_ = data;
+        high_ = data + wordsFor(count * static_cast<size_t>(l_)) * sizeof(std::uint64_t);
+        seekHigh(0);
+    }
+
+    std::uint64_t EliasFanoView::word(const char* base, size_t i) const {
+        std::uint64_t w;
+        std::memcpy(&w, base + i * sizeof(std::uint64_t), sizeof(w));
+        return w;
+    }
+
+    std::uint32_t EliasFanoView::lowBits(size_t i) const {
+        if (l_ == 0) {
+            return 0;
+        }
+        const size_t bit = i * static_cast<size_t>(l_);
+        const unsigned shift = bit % 64;
+        std::uint64_t v = word(low_, bit / 64) >> shift;
+        if (shift + static_cast<unsigned>(l_) > 64) {
+            v |= word(low_, bit / 64 + 1) << (64 - shift);
+        }
+        return static_cast<std::uint32_t>(v & ((std::uint64_t{ 1 } << l_) - 1));
+    }
+
+    void EliasFanoView::seekHigh(size_t pos) {
+        // 按字扫描下一个置位
+        size_t w = pos / 64;
+        std::uint64_t bits = pos % 64 == 0 ? word(high_, w) : word(high_, w) & (~std::uint64_t{ 0 } << (pos % 64));
+        const size_t words = wordsFor(high_bits_);
+        while (bits == 0) {
+            if (++w >= words) {
+                index_ = count_;
+                return;
+            }
+            bits = word(high_, w);
+        }
+        high_pos_ = w * 64 + static_cast<size_t>(std::countr_zero(bits));
+        value_ = static_cast<std::uint32_t>(((high_pos_ - index_) << l_) | lowBits(index_));
+    }
+
+    void EliasFanoView::next() {
+        if (index_ >= count_) {
+            return;
+        }
+        if (++index_ >= count_) {
+            return;
+        }
+        seekHigh(high_pos_ + 1);
+    }
+
+    void EliasFanoView::nextGEQ(std::uint32_t target) {
+        if (index_ >= count_ || value_ >= target) {
+            return;
+        }
+        const size_t target_high = target >> l_;
+        const size_t current_high = high_pos_ - index_;
+        if (target_high > current_high) {
+            // 定位高位区中第 target_high 个 0（select0）之后的位置：其后的元素高位均不小于 target_high。
+            // 从当前位置起按字统计 0 的个数，整字跳过
+            size_t zeros_needed = target_high - current_high; // 还需跨过的 0 的个数
+            size_t pos = high_pos_ + 1;
+            if (pos >= high_bits_) {
+                index_ = count_;
+                return;
+            }
+            size_t ones_skipped = 0;
+            const size_t words = wordsFor(high_bits_);
+            size_t w = pos / 64;
+            std::uint64_t bits = word(high_, w) >> (pos % 64);
+            size_t bits_left = 64 - pos % 64;
+            while (true) {
+                const size_t valid = std::min(bits_left, high_bits_ - std::min(high_bits_, w * 64 + (64 - bits_left)));
+                const std::uint64_t valid_mask = valid >= 64 ? ~std::uint64_t{ 0 } : ((std::uint64_t{ 1 } << valid) - 1);
+                const size_t ones = static_cast<size_t>(std::popcount(bits & valid_mask));
+                const size_t zeros = valid - ones;
+                if (zeros >= zeros_needed) {
+                    // 目标 0 落在本字内：逐位定位
+                    for (size_t k = 0; k < valid; ++k) {
+                        if ((bits >> k) & 1u) {
+                            ++ones_skipped;
+                        } else if (--zeros_needed == 0) {
+                            pos = w * 64 + (64 - bits_left) + k + 1;
+                            break;
+                        }
+                    }
+                    break;
+                }
+                zeros_needed -= zeros;
+                ones_skipped += ones;
+                if (++w >= words) {
+                    index_ = count_;
+                    return;
+                }
+                bits = word(high_, w);
+                bits_left = 64;
+            }
+            index_ += 1 + ones_skipped;
+            if (index_ >= count_) {
+                index_ = count_;
+                return;
+            }
+            seekHigh(pos);
+        }
+        // 同一高位桶内顺序比较（桶内元素个数平均不超过 2）
+        while (index_ < count_ && value_ < target) {
+            next();
+        }
+    }
+} // namespace wiser
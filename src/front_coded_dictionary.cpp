@@ -0,0 +1,125 @@
+/**
+ * @file front_coded_dictionary.cpp
+ * @brief 前缀压缩有序词元字典实现
+ */
+
+#include "wiser/front_coded_dictionary.h"
+#include <algorithm>
+
+namespace wiser {
+    namespace {
+        void appendVarint(std::string& out, size_t value) {
+            while (value >= 0x80) {
+                out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+                value >>= 7;
+            }
+            out.push_back(static_cast<char>(value));
+        }
+
+        size_t readVarint(const char*& p) {
+            size_t value = 0;
+            int shift = 0;
+            while (true) {
+                const auto byte = static_cast<unsigned char>(*p++);
+                value |= static_cast<size_t>(byte & 0x7F) << shift;
+                if (!(byte & 0x80)) {
+                    return value;
+                }
+                shift += 7;
+            }
+        }
+    } // anonymous namespace
+
+    void FrontCodedDictionary::build(std::vector<std::pair<TokenId, std::string>> tokens) {
+        clear();
+        // 通常已按词元排序（Database::getAllTokens 按 token_index 顺序返回）
+        if (!std::ranges::is_sorted(tokens, {}, &std::pair<TokenId, std::string>::second)) {
+            std::ranges::stable_sort(tokens, {}, &std::pair<TokenId, std::string>::second);
+        }
+
+        ids_.reserve(tokens.size());
+        std::string_view previous;
+        for (const auto& [id, token]: tokens) {
+            if (!ids_.empty() && token == previous) {
+                continue;
+            }
+            if (ids_.size() % kFrontCodingBlockSize == 0) {
+                // 块首项保存完整词元，作为二分查找的键
+                block_offsets_.push_back(data_.size());
+                appendVarint(data_, token.size());
+                data_.append(token);
+            } else {
+                const auto mismatch = std::ranges::mismatch(previous, token);
+                const auto shared = static_cast<size_t>(mismatch.in2 - token.begin());
+                appendVarint(data_, shared);
+                appendVarint(data_, token.size() - shared);
+                data_.append(token, shared);
+            }
+            ids_.push_back(id);
+            max_id_ = std::max(max_id_, id);
+            previous = token;
+        }
+        data_.shrink_to_fit();
+        block_offsets_.shrink_to_fit();
+    }
+
+    std::string_view FrontCodedDictionary::firstKey(size_t block) const {
+        const char* p = data_.data() + block_offsets_[block];
+        const size_t length = readVarint(p);
+        return { p, length };
+    }
+
+    std::optional<TokenId> FrontCodedDictionary::find(std::string_view token) const {
+        if (block_offsets_.empty()) {
+            return std::nullopt;
+        }
+        // 最后一个块首项 <= token 的块
+        size_t lo = 0, hi = block_offsets_.size();
+        while (hi - lo > 1) {
+            const size_t mid = lo + (hi - lo) / 2;
+            if (firstKey(mid) <= token) {
+                lo = mid;
+            } else {
+                hi = mid;
+            }
+        }
+
+        const size_t first = lo * kFrontCodingBlockSize;
+        const size_t last = std::min(first + kFrontCodingBlockSize, ids_.size());
+        const char* p = data_.data() + block_offsets_[lo];
+        const char* end = lo + 1 < block_offsets_.size() ? data_.data() + block_offsets_[lo + 1]
+                                                          : data_.data() + data_.size();
+        std::string key;
+        for (size_t i = first; i < last && p < end; ++i) {
+            if (i == first) {
+                const size_t length = readVarint(p);
+                key.assign(p, length);
+                p += length;
+            } else {
+                const size_t shared = readVarint(p);
+                const size_t suffix = readVarint(p);
+                key.resize(shared);
+                key.append(p, suffix);
+                p += suffix;
+            }
+            if (key == token) {
+                return ids_[i];
+            }
+            if (token < key) {
+                break; // 块内升序，之后的项更大
+            }
+        }
+        return std::nullopt;
+    }
+
+    void FrontCodedDictionary::clear() {
+        data_.clear();
+        block_offsets_.clear();
+        ids_.clear();
+        max_id_ = 0;
+    }
+
+    size_t FrontCodedDictionary::memoryUsage() const {
+        return data_.capacity() + block_offsets_.capacity() * sizeof(size_t) + ids_.capacity() * sizeof(TokenId);
+    }
+} // namespace wiser
@@ -20,6 +20,8 @@
 #include <string_view>
 #include <cctype>
 #include <iostream>
+#include <utility>
+#include <vector>
 
 namespace wiser {
     // 去掉字符串视图左侧空白，便于判断首字符（如 '{' 或 '['）
@@ -159,6 +161,14 @@ namespace wiser {
         };
 
         std::uint64_t processed = 0, ok = 0;
+        // 按批提交，正文由环境并行分词
+        std::vector<std::pair<std::string, std::string>> batch;
+        batch.reserve(kIngestBatchSize);
+        auto submit_batch = [&]() {
+            ok += env_->addDocuments(batch);
+            batch.clear();
+            print_progress(ok, total_for_progress);
+        };
         while (std::getline(ifs, line)) {
             // 跳过空行
             std::string_view sv(line);
@@ -171,18 +181,22 @@ namespace wiser {
             std::string title, body;
             if (parseObjectToTitleBody(std::string(sv), title, body)) {
                 // 达到上限时停止写入（由环境统一控制索引条目数量）
-                if (!title.empty() && !body.empty() && !env_->hasReachedIndexLimit()) {
-                    env_->addDocument(title, body);
-                    ++ok;
-                    print_progress(ok, total_for_progress);
-                    if (env_->hasReachedIndexLimit()) {
-                        std::cerr << std::endl;
-                        break;
+                if (!title.empty() && !body.empty()) {
+                    batch.emplace_back(std::move(title), std::move(body));
+                    if (batch.size() >= kIngestBatchSize) {
+                        submit_batch();
+                        if (env_->hasReachedIndexLimit()) {
+                            std::cerr << std::endl;
+                            break;
+                        }
                     }
                 }
             }
             ++processed;
         }
+        if (!batch.empty()) {
+            submit_batch();
+        }
         if (ok > 0) {
             print_progress(ok, total_for_progress);
             std::cerr << std::endl;
@@ -280,6 +294,13 @@ namespace wiser {
 
         // 朴素解析：遍历顶层数组，提取每个对象的文本。需要区分字符串内的字符与对象括号平衡。
         std::uint64_t ok = 0;
+        std::vector<std::pair<std::string, std::string>> batch;
+        batch.reserve(kIngestBatchSize);
+        auto submit_batch = [&]() {
+            ok += env_->addDocuments(batch);
+            batch.clear();
+            print_progress(ok, total_for_progress);
+        };
         std::size_t i = 0, n = data.size();
         // 跳过空白
         while (i < n && std::isspace(static_cast<unsigned char>(data[i])))
@@ -341,17 +362,21 @@ namespace wiser {
 
             std::string title, body;
             if (parseObjectToTitleBody(obj, title, body)) {
-                if (!title.empty() && !body.empty() && !env_->hasReachedIndexLimit()) {
-                    env_->addDocument(title, body);
-                    ++ok;
-                    print_progress(ok, total_for_progress);
-                    if (env_->hasReachedIndexLimit()) {
-                        std::cerr << std::endl;
-                        break;
+                if (!title.empty() && !body.empty()) {
+                    batch.emplace_back(std::move(title), std::move(body));
+                    if (batch.size() >= kIngestBatchSize) {
+                        submit_batch();
+                        if (env_->hasReachedIndexLimit()) {
+                            std::cerr << std::endl;
+                            break;
+                        }
                     }
                 }
             }
         }
+        if (!batch.empty()) {
+            submit_batch();
+        }
 
         if (ok > 0) {
             print_progress(ok, total_for_progress);
@@ -25,6 +25,26 @@ static const char* compressMethodToString(wiser::CompressMethod m) {
             return "none";
         case wiser::CompressMethod::GOLOMB:
             return "golomb";
+        case wiser::CompressMethod::BP128:
+            return "bp128";
+        case wiser::CompressMethod::ELIAS_FANO:
+            return "eliasfano";
+        case wiser::CompressMethod::GOLOMB_ADAPTIVE:
+            return "golomb-adaptive";
+        case wiser::CompressMethod::AUTO:
+            return "auto";
+        default:
+            return "unknown";
+    }
+}
+
+static const char* analyzerToString(wiser::AnalyzerType a) {
+    // 将分析器枚举映射为可读字符串，用于日志输出
+    switch (a) {
+        case wiser::AnalyzerType::NGRAM:
+            return "ngram";
+        case wiser::AnalyzerType::HYBRID:
+            return "hybrid";
         default:
             return "unknown";
     }
@@ -48,7 +68,7 @@ void printUsage(const char* program_name) {
     std::cout << std::format("usage: {} [options] db_file\n", program_name);
     std::cout << std::format("\n");
     std::cout << std::format("modes:");
-    std::cout << std::format("  Indexing : -x <data_file> [-m N] [-t N] [-c METHOD]\n");
+    std::cout << std::format("  Indexing : -x <data_file> [-m N] [-t N] [-c METHOD] [-a ANALYZER] [-j N] [-M]\n");
     std::cout << std::format("              data_file supports: .xml (Wikipedia XML), .tsv, .json, .jsonl, .ndjson\n");
     std::cout << std::format("  Searching: -q <query> [-s]\n");
     std::cout << std::format("  You can provide both -x and -q to index then search in one run.\n");
@@ -56,7 +76,10 @@ void printUsage(const char* program_name) {
     std::cout << std::format("options:\n");
     std::cout << std::format("  -h, --help                   : show this help and exit\n");
     std::cout << std::format("  -c <compress_method>         : postings list compression [default: none]\n");
-    std::cout << std::format("                                 values: none | golomb\n");
+    std::cout << std::format("                                 values: none | golomb | golomb-adaptive | bp128 | eliasfano | auto\n");
+    std::cout << std::format("  -a <analyzer>                : how text is split into tokens [default: ngram]\n");
+    std::cout <<
+            std::format("                                 ngram: N-grams everywhere; hybrid: whole words for ASCII letters/digits, N-grams for CJK\n");
     std::cout <<
             std::format("  -x <data_file>               : path to data file for indexing; loader is chosen by extension\n");
     std::cout <<
@@ -65,13 +88,18 @@ void printUsage(const char* program_name) {
     std::cout << std::format("  -m <max_index_count>         : max docs to index [-1 = no limit, default: -1]\n");
     std::cout <<
             std::format("  -t <buffer_threshold>        : inverted index buffer merge threshold [default: 2048]\n");
+    std::cout <<
+            std::format("  -j <index_threads>           : threads that tokenize documents in parallel [0 = all cores, default: 0]\n");
     std::cout << std::format("  -s                           : enable phrase search (by default it's disabled)\n");
+    std::cout <<
+            std::format("  -M                           : write merged index segments as memory-mapped postings files\n");
     std::cout << std::format("\n");
     std::cout << std::format("examples:\n");
     std::cout << std::format("  {} -x enwiki-latest-pages-articles.xml -m 10000 -c golomb data/wiser.db\n",
                              program_name);
     std::cout << std::format("  {} -x sample_dataset.tsv data/wiser.db\n", program_name);
     std::cout << std::format("  {} -x sample.jsonl data/wiser.db\n", program_name);
+    std::cout << std::format("  {} -x sample.jsonl -a hybrid data/wiser.db\n", program_name);
     std::cout << std::format("  {} -q \"information retrieval\" data/wiser.db\n", program_name);
 }
 
@@ -81,12 +109,32 @@ wiser::CompressMethod parseCompressMethod(const std::string& method_str) {
         return wiser::CompressMethod::NONE;
     } else if (method_str == "golomb") {
         return wiser::CompressMethod::GOLOMB;
+    } else if (method_str == "bp128") {
+        return wiser::CompressMethod::BP128;
+    } else if (method_str == "eliasfano") {
+        return wiser::CompressMethod::ELIAS_FANO;
+    } else if (method_str == "golomb-adaptive") {
+        return wiser::CompressMethod::GOLOMB_ADAPTIVE;
+    } else if (method_str == "auto") {
+        return wiser::CompressMethod::AUTO;
     } else {
         spdlog::error("Invalid compress method({}). Using none instead.", method_str);
         return wiser::CompressMethod::NONE;
     }
 }
 
+wiser::AnalyzerType parseAnalyzer(const std::string& analyzer_str) {
+    // 将字符串解析为分析器；未知值会退回 NGRAM 并记录错误
+    if (analyzer_str.empty() || analyzer_str == "ngram") {
+        return wiser::AnalyzerType::NGRAM;
+    } else if (analyzer_str == "hybrid") {
+        return wiser::AnalyzerType::HYBRID;
+    } else {
+        spdlog::error("Invalid analyzer({}). Using ngram instead.", analyzer_str);
+        return wiser::AnalyzerType::NGRAM;
+    }
+}
+
 int main(int argc, char* argv[]) {
     // 初始化spdlog
     spdlog::set_level(spdlog::level::info);
@@ -94,6 +142,7 @@ int main(int argc, char* argv[]) {
 
     // 解析参数所需的临时变量
     std::string compress_method_str;
+    std::string analyzer_str;
     std::string data_file; // 支持 .xml/.tsv/.json/.jsonl/.ndjson
     std::string query;
     bool show_help = false;
@@ -110,6 +159,8 @@ int main(int argc, char* argv[]) {
             show_help = true;
         } else if (arg == "-c" && i + 1 < argc - 1) {
             compress_method_str = toLower(argv[++i]);
+        } else if (arg == "-a" && i + 1 < argc - 1) {
+            analyzer_str = toLower(argv[++i]);
         } else if (arg == "-x" && i + 1 < argc - 1) {
             data_file = argv[++i];
         } else if (arg == "-q" && i + 1 < argc - 1) {
@@ -128,8 +179,17 @@ int main(int argc, char* argv[]) {
                 spdlog::error("Invalid value for -t: {}", argv[i]);
                 return 1;
             }
+        } else if (arg == "-j" && i + 1 < argc - 1) {
+            try {
+                config.index_threads = std::stoi(argv[++i]);
+            } catch (const std::exception&) {
+                spdlog::error("Invalid value for -j: {}", argv[i]);
+                return 1;
+            }
         } else if (arg == "-s") {
             config.enable_phrase_search = true;
+        } else if (arg == "-M") {
+            config.mmap_postings = true;
         } else {
             spdlog::error("Unknown option: {}. Use -h for help.", argv[i]);
             printUsage(argv[0]);
@@ -160,15 +220,25 @@ int main(int argc, char* argv[]) {
         }
 
         // 设置配置 - 使用 Config 对象统一设置
-        auto cm = parseCompressMethod(compress_method_str);
-        env.setCompressMethod(cm);
+        // 仅在显式指定 -c 时覆盖；否则沿用库中记录的压缩方式，保证已有倒排列表能正确解码
+        if (!compress_method_str.empty()) {
+            env.setCompressMethod(parseCompressMethod(compress_method_str));
+        }
+        // 分析器同理：仅在显式指定 -a 时覆盖，查询沿用建索引时的切分方式；
+        // 库中已有文档时不同的分析器会被忽略（见 setAnalyzer），沿用库中的设置
+        if (!analyzer_str.empty()) {
+            env.setAnalyzer(parseAnalyzer(analyzer_str));
+        }
         env.setBufferUpdateThreshold(config.buffer_update_threshold);
         env.setPhraseSearchEnabled(config.enable_phrase_search);
+        env.setMmapPostingsEnabled(config.mmap_postings);
+        env.setIndexThreads(config.index_threads);
         // 让 -m 生效：设置本次运行的索引上限
         env.setMaxIndexCount(config.max_index_count);
 
         // 打印最终生效的关键参数（包含压缩方式字符串）
-        spdlog::info("Compress method: {}", compressMethodToString(cm));
+        spdlog::info("Compress method: {}, Analyzer: {}", compressMethodToString(env.getCompressMethod()),
+                     analyzerToString(env.getAnalyzer()));
         spdlog::info("Phrase search: {}, Buffer threshold: {}, Token length: {}",
                      config.enable_phrase_search ? "enabled" : "disabled",
                      config.buffer_update_threshold,
@@ -3,197 +3,197 @@
  * @brief 倒排列表与内存倒排索引实现
  *
  * 结构说明：
- * - PostingsItem：单个文档在某个词元下的命中信息（doc_id + positions）
- * - PostingsList：某个词元对应的倒排列表（多个 PostingsItem）
+ * - PostingsList：某个词元对应的倒排列表，列式存储（doc_id 数组 + 位置结束偏移数组 + 共享位置池）
  * - InvertedIndex：内存中的 token_id -> PostingsList 映射（索引构建阶段使用）
  *
  * 序列化说明：
- * - PostingsList::serialize 使用固定宽度的简单格式，便于直接落库为 BLOB
- * - 反序列化时做边界检查，避免读取越界
+ * - PostingsList::serialize 写出分块格式（见 postings_block.h），块内按 CompressMethod 编码
+ * - 反序列化同时支持分块格式与旧的整体格式，并做边界检查，避免读取越界
  */
 
 #include "wiser/postings.h"
+#include "wiser/postings_block.h"
 #include "wiser/compression_utils.h"
 #include <algorithm>
 #include <cstring>
+#include <iterator>
 #include <spdlog/spdlog.h>
 
 namespace wiser {
-    // PostingsItem 实现：记录某个文档在该词元下出现的位置列表
-    PostingsItem::PostingsItem(DocId doc_id, std::vector<Position> positions)
-        : document_id_(doc_id), positions_(std::move(positions)) {}
-
-    void PostingsItem::addPosition(Position position) {
-        // 追加一个位置（由分词器按 token 序号递增提供）
-        positions_.push_back(position);
-    }
-
     // PostingsList 实现：维护同一 token_id 对应的所有文档命中
     void PostingsList::addPosting(DocId document_id, Position position) {
-        // 找到对应文档的 item（不存在则创建），再追加位置
-        auto* item = findOrCreateItem(document_id);
-        item->addPosition(position);
-    }
-
-    void PostingsList::merge(PostingsList&& other) {
-        // 将 other 的所有 (doc_id, positions) 合并到当前列表
-        for (auto& item: other.items_) {
-            auto existing_item = findOrCreateItem(item->getDocumentId());
-            for (Position position: item->getPositions()) {
-                existing_item->addPosition(position);
-            }
+        if (!doc_ids_.empty() && doc_ids_.back() == document_id) {
+            // 同一文档的后续位置：直接追加到位置池尾部
+            positions_.push_back(position);
+            ++position_ends_.back();
+            return;
         }
-        other.items_.clear();
+        if (doc_ids_.empty() || doc_ids_.back() < document_id) {
+            // 新文档且 ID 递增：O(1) 追加
+            doc_ids_.push_back(document_id);
+            positions_.push_back(position);
+            position_ends_.push_back(static_cast<std::uint32_t>(positions_.size()));
+            return;
+        }
+        insertPosting(document_id, position);
     }
 
-    PostingsItem* PostingsList::findOrCreateItem(DocId document_id) {
-        // 查找现有项
-        for (auto& item: items_) {
-            if (item->getDocumentId() == document_id) {
-                return item.get();
-            }
+    void PostingsList::insertPosting(DocId document_id, Position position) {
+        auto it = std::ranges::lower_bound(doc_ids_, document_id);
+        const size_t i = static_cast<size_t>(it - doc_ids_.begin());
+        std::uint32_t insert_at;
+        if (it != doc_ids_.end() && *it == document_id) {
+            // 已有文档：位置追加到该文档段末尾
+            insert_at = position_ends_[i];
+        } else {
+            // 新文档：在第 i 个位置插入一个空段
+            insert_at = positionsBegin(i);
+            doc_ids_.insert(it, document_id);
+            position_ends_.insert(position_ends_.begin() + static_cast<std::ptrdiff_t>(i), insert_at);
         }
+        positions_.insert(positions_.begin() + insert_at, position);
+        for (size_t j = i; j < position_ends_.size(); ++j) {
+            ++position_ends_[j];
+        }
+    }
 
-        // 创建新项
-        auto new_item = std::make_unique<PostingsItem>(document_id, std::vector<Position>{});
-        auto* ptr = new_item.get();
-        items_.push_back(std::move(new_item));
-
-        // 保持按文档ID排序
-        std::ranges::sort(items_,
-                          [](const auto& a, const auto& b) {
-                              return a->getDocumentId() < b->getDocumentId();
-                          });
-
-        return ptr;
+    void PostingsList::appendDocument(DocId document_id, std::span<const Position> positions) {
+        doc_ids_.push_back(document_id);
+        positions_.insert(positions_.end(), positions.begin(), positions.end());
+        position_ends_.push_back(static_cast<std::uint32_t>(positions_.size()));
     }
 
-    std::vector<char> PostingsList::serialize(CompressMethod method) const {
-        // 使用 BitWriter 写出 Golomb 编码
-        if (method == CompressMethod::GOLOMB) {
-            std::vector<char> result;
-            Count items_count = static_cast<Count>(items_.size());
-            result.insert(result.end(), reinterpret_cast<const char*>(&items_count),
-                          reinterpret_cast<const char*>(&items_count) + sizeof(items_count));
-
-            // Golomb 写入
-            BitWriter writer;
-            
-            // 使用固定的 M 参数（实际应用中可能需要更复杂的选择策略）
-            const int M_DOC = 128; // 用于 DocID delta
-            const int M_POS = 16;  // 用于 Position delta
+    void PostingsList::merge(PostingsList&& other) {
+        if (other.empty()) {
+            return;
+        }
+        if (empty()) {
+            *this = std::move(other);
+            other.clear();
+            return;
+        }
 
-            DocId prev_doc_id = 0;
-            for (const auto& item : items_) {
-                DocId doc_id = item->getDocumentId();
-                DocId delta_doc = doc_id - prev_doc_id;
-                GolombEncoder::encode(delta_doc, M_DOC, writer);
-                prev_doc_id = doc_id;
-
-                Count positions_count = static_cast<Count>(item->getPositions().size());
-                // 这里简单假设 positions_count 不需要 Golomb，因为通常比较小，但统一用也行。
-                // 也可以用 Gamma 编码，或者简单地写出来。这里为了统一，用 Golomb，参数选小一点。
-                // 或者直接用 raw binary 或者 varint。为了简化，我们仅对 delta 序列使用 Golomb。
-                // positions_count 暂时用 Golomb 存, M=2
-                GolombEncoder::encode(positions_count, 8, writer);
-
-                Position prev_pos = 0;
-                for (Position pos : item->getPositions()) {
-                    Position delta_pos = pos - prev_pos;
-                     GolombEncoder::encode(delta_pos, M_POS, writer);
-                    prev_pos = pos;
-                }
+        if (doc_ids_.back() < other.doc_ids_.front()) {
+            // 快路径：other 整体位于当前列表之后，直接拼接三个数组
+            const auto base = static_cast<std::uint32_t>(positions_.size());
+            doc_ids_.insert(doc_ids_.end(), other.doc_ids_.begin(), other.doc_ids_.end());
+            positions_.insert(positions_.end(), other.positions_.begin(), other.positions_.end());
+            position_ends_.reserve(position_ends_.size() + other.position_ends_.size());
+            for (std::uint32_t end: other.position_ends_) {
+                position_ends_.push_back(base + end);
             }
-
-            auto bits_data = writer.getData();
-            result.insert(result.end(), bits_data.begin(), bits_data.end());
-            return result;
+            other.clear();
+            return;
         }
 
-        // 默认: NONE (Raw binary)
-        std::vector<char> result;
-
-        // 简单序列化格式（固定宽度）：
-        // [items_count:Count]
-        //   循环 items_count 次：
-        //   [doc_id:DocId][positions_count:Count][position:Position] * positions_count
-
-        Count items_count = static_cast<Count>(items_.size());
-        result.insert(result.end(), reinterpret_cast<const char*>(&items_count),
-                      reinterpret_cast<const char*>(&items_count) + sizeof(items_count));
-
-        for (const auto& item: items_) {
-            DocId doc_id = item->getDocumentId();
-            result.insert(result.end(), reinterpret_cast<const char*>(&doc_id),
-                          reinterpret_cast<const char*>(&doc_id) + sizeof(doc_id));
-
-            Count positions_count = static_cast<Count>(item->getPositions().size());
-            result.insert(result.end(), reinterpret_cast<const char*>(&positions_count),
-                          reinterpret_cast<const char*>(&positions_count) + sizeof(positions_count));
-
-            for (Position position: item->getPositions()) {
-                result.insert(result.end(), reinterpret_cast<const char*>(&position),
-                              reinterpret_cast<const char*>(&position) + sizeof(position));
+        // 一般情况：双指针归并，同一 doc_id 的位置归并为升序
+        PostingsList merged;
+        merged.doc_ids_.reserve(doc_ids_.size() + other.doc_ids_.size());
+        merged.position_ends_.reserve(doc_ids_.size() + other.doc_ids_.size());
+        merged.positions_.reserve(positions_.size() + other.positions_.size());
+
+        size_t a = 0, b = 0;
+        while (a < doc_ids_.size() || b < other.doc_ids_.size()) {
+            if (b == other.doc_ids_.size() || (a < doc_ids_.size() && doc_ids_[a] < other.doc_ids_[b])) {
+                merged.appendDocument(doc_ids_[a], getPositions(a));
+                ++a;
+            } else if (a == doc_ids_.size() || other.doc_ids_[b] < doc_ids_[a]) {
+                merged.appendDocument(other.doc_ids_[b], other.getPositions(b));
+                ++b;
+            } else {
+                // 同一文档（如重复添加同标题文档）：两段位置按升序归并，保证差分编码不出现负值
+                auto mine = getPositions(a);
+                auto extra = other.getPositions(b);
+                merged.doc_ids_.push_back(doc_ids_[a]);
+                std::ranges::merge(mine, extra, std::back_inserter(merged.positions_));
+                merged.position_ends_.push_back(static_cast<std::uint32_t>(merged.positions_.size()));
+                ++a;
+                ++b;
             }
         }
+        *this = std::move(merged);
+        other.clear();
+    }
 
-        return result;
+    void PostingsList::clear() {
+        doc_ids_.clear();
+        position_ends_.clear();
+        positions_.clear();
+    }
+
+    std::vector<char> PostingsList::serialize(CompressMethod method, bool doc_bitmap) const {
+        return encodeBlockedPostings(*this, method, doc_bitmap);
     }
 
     void PostingsList::deserialize(const std::vector<char>& data, CompressMethod method) {
-        items_.clear();
-        if (data.empty())
+        deserialize(data.data(), data.size(), method);
+    }
+
+    void PostingsList::deserialize(const char* data, size_t size, CompressMethod method) {
+        clear();
+        if (size == 0)
             return;
 
-        const char* ptr = data.data();
-        const char* end = ptr + data.size();
+        if (isBlockedPostings(data, size)) {
+            decodeBlockedPostings(data, size, *this);
+            return;
+        }
+
+        // 旧格式（整体编码）：
+        // [items_count:Count]
+        //   NONE：循环 items_count 次 [doc_id:DocId][positions_count:Count][position:Position] * positions_count
+        //   GOLOMB：其后为整体位流（doc_id 差分、positions_count、position 差分）
+        const char* ptr = data;
+        const char* end = ptr + size;
 
         // 读取 items_count（做边界检查，避免越界）
         if (ptr + sizeof(Count) > end)
             return;
-        Count items_count = *reinterpret_cast<const Count*>(ptr);
+        Count items_count;
+        std::memcpy(&items_count, ptr, sizeof(Count));
         ptr += sizeof(Count);
+        if (items_count < 0) {
+            spdlog::error("Unknown postings format marker: {}", items_count);
+            return;
+        }
+        if (items_count == 0)
+            return;
+
+        doc_ids_.reserve(static_cast<size_t>(items_count));
+        position_ends_.reserve(static_cast<size_t>(items_count));
 
         if (method == CompressMethod::GOLOMB) {
             // Golomb 解码
-            // 将剩下的数据构造为 BitReader
-            // 注意：BitReader 接受 const std::vector<char>&，我们需要构造这样一个 vector 或修改 BitReader 适配指针
-            // 为了简单，尽量复用现有 vector，或者如果 BitReader 只能用 vector，我们得拷贝剩下的数据
-            // BitReader 定义是 const std::vector<char>& data_，所以我们需要一个新的 vector
-            std::vector<char> bit_data(ptr, end);
-            BitReader reader(bit_data);
-
-            const int M_DOC = 128;
-            const int M_POS = 16;
-            
+            // BitReader 直接读取头部之后的字节，无需拷贝
+            BitReader reader(ptr, static_cast<size_t>(end - ptr));
+
             DocId prev_doc_id = 0;
 
             try {
                 for (Count i = 0; i < items_count; ++i) {
                     if (reader.eof()) break;
 
-                    DocId delta_doc = GolombDecoder::decode(M_DOC, reader);
+                    DocId delta_doc = GolombDecoder::decode(kGolombDocParams, reader);
                     DocId doc_id = prev_doc_id + delta_doc;
                     prev_doc_id = doc_id;
 
-                    Count positions_count = GolombDecoder::decode(8, reader); // M=8 for count
-                    
-                    std::vector<Position> positions;
-                    positions.reserve(positions_count);
+                    Count positions_count = GolombDecoder::decode(kGolombCountParams, reader);
 
                     Position prev_pos = 0;
                     for (Count j = 0; j < positions_count; ++j) {
-                        Position delta_pos = GolombDecoder::decode(M_POS, reader);
+                        Position delta_pos = GolombDecoder::decode(kGolombPosParams, reader);
                         Position pos = prev_pos + delta_pos;
-                        positions.push_back(pos);
+                        positions_.push_back(pos);
                         prev_pos = pos;
                     }
 
-                    items_.push_back(std::make_unique<PostingsItem>(doc_id, std::move(positions)));
+                    doc_ids_.push_back(doc_id);
+                    position_ends_.push_back(static_cast<std::uint32_t>(positions_.size()));
                 }
             } catch (const std::exception& e) {
                 spdlog::error("Error decoding Golomb stream: {}", e.what());
-                // 出错时保留已解码的部分
+                // 出错时保留已完整解码的文档，丢弃最后一个不完整文档的位置
+                positions_.resize(position_ends_.empty() ? 0 : position_ends_.back());
             }
             return;
         }
@@ -202,24 +202,26 @@ namespace wiser {
         for (Count i = 0; i < items_count && ptr < end; ++i) {
             if (ptr + sizeof(DocId) > end)
                 break;
-            DocId doc_id = *reinterpret_cast<const DocId*>(ptr);
+            DocId doc_id;
+            std::memcpy(&doc_id, ptr, sizeof(DocId));
             ptr += sizeof(DocId);
 
             if (ptr + sizeof(Count) > end)
                 break;
-            Count positions_count = *reinterpret_cast<const Count*>(ptr);
+            Count positions_count;
+            std::memcpy(&positions_count, ptr, sizeof(Count));
             ptr += sizeof(Count);
 
-            std::vector<Position> positions;
-            positions.reserve(positions_count);
-
-            for (Count j = 0; j < positions_count && ptr + sizeof(Position) <= end; ++j) {
-                Position position = *reinterpret_cast<const Position*>(ptr);
-                ptr += sizeof(Position);
-                positions.push_back(position);
-            }
+            // 截断数据只保留完整的位置
+            size_t available = static_cast<size_t>(end - ptr) / sizeof(Position);
+            size_t n = std::min(static_cast<size_t>(std::max<Count>(0, positions_count)), available);
+            const size_t old_size = positions_.size();
+            positions_.resize(old_size + n);
+            std::memcpy(positions_.data() + old_size, ptr, n * sizeof(Position));
+            ptr += n * sizeof(Position);
 
-            items_.push_back(std::make_unique<PostingsItem>(doc_id, std::move(positions)));
+            doc_ids_.push_back(doc_id);
+            position_ends_.push_back(static_cast<std::uint32_t>(positions_.size()));
         }
     }
 
@@ -235,6 +237,32 @@ namespace wiser {
         }
     }
 
+    void InvertedIndex::addDocument(TokenId token_id, DocId document_id, std::span<const Position> positions) {
+        auto& list = index_[token_id];
+        if (!list) {
+            list = std::make_unique<PostingsList>();
+        }
+        if (list->empty() || list->getDocumentIds().back() < document_id) {
+            list->appendDocument(document_id, positions);
+            return;
+        }
+        for (Position position: positions) {
+            list->addPosting(document_id, position);
+        }
+    }
+
+    void InvertedIndex::merge(InvertedIndex&& other) {
+        for (auto& [token_id, list]: other.index_) {
+            auto& mine = index_[token_id];
+            if (!mine) {
+                mine = std::move(list);
+            } else {
+                mine->merge(std::move(*list));
+            }
+        }
+        other.index_.clear();
+    }
+
     PostingsList* InvertedIndex::getPostingsList(TokenId token_id) {
         auto it = index_.find(token_id);
         return (it != index_.end()) ? it->second.get() : nullptr;
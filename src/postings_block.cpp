@@ -0,0 +1,603 @@
+/**
+ * @file postings_block.cpp
+ * @brief 分块倒排格式的编码/解码与按块跳跃的游标实现
+ *
+ * 说明：
+ * - 跳表紧随头部，每块一项 (last_doc, doc_offset, pos_offset, max_tf)，游标直接在原始字节上二分，不做预解析；
+ * - 块之间互不依赖（文档 ID 的基准取自上一块跳表项的 last_doc），因此任意块可单独解码；
+ * - 块内编码交给头部标签对应的 PostingsCodec，本文件只负责头部、跳表、分区与位图；
+ * - 文档区与位置区分开，游标换块时只解码 (doc_id, tf)，位置按需解码；
+ * - 数据损坏时记录错误日志，保留已完整解码的文档。
+ */
+
+#include "wiser/postings_block.h"
+#include <algorithm>
+#include <cstring>
+#include <spdlog/spdlog.h>
+
+namespace wiser {
+    namespace {
+        // 头部：[marker][docs_count][docs_section_size][codec:uint8][flags:uint8][reserved:uint16]，带位图时追加 [bitmap_size]
+        constexpr size_t kHeaderSize = sizeof(std::int32_t) + sizeof(Count) + sizeof(std::uint32_t) +
+                                       2 * sizeof(std::uint8_t) + sizeof(std::uint16_t);
+        // 头部各字段的字节偏移
+        constexpr size_t kDocsCountField = sizeof(std::int32_t);
+        constexpr size_t kDocsSizeField = kDocsCountField + sizeof(Count);
+        constexpr size_t kCodecField = kDocsSizeField + sizeof(std::uint32_t);
+        constexpr size_t kFlagsField = kCodecField + sizeof(std::uint8_t);
+        constexpr size_t kSkipEntrySize = sizeof(DocId) + 2 * sizeof(std::uint32_t) + sizeof(Count);
+        // 跳表项内各字段的字节偏移
+        constexpr size_t kDocOffsetField = sizeof(DocId);
+        constexpr size_t kPosOffsetField = kDocOffsetField + sizeof(std::uint32_t);
+        constexpr size_t kMaxTfField = kPosOffsetField + sizeof(std::uint32_t);
+
+        template<typename T>
+        void appendRaw(std::vector<char>& out, T value) {
+            const char* p = reinterpret_cast<const char*>(&value);
+            out.insert(out.end(), p, p + sizeof(T));
+        }
+
+        template<typename T>
+        T readRaw(const char* p) {
+            T value;
+            std::memcpy(&value, p, sizeof(T));
+            return value;
+        }
+
+        /**
+         * @brief 分块格式头部解析结果
+         */
+        struct BlockedLayout {
+            CompressMethod method = CompressMethod::NONE; ///< 标签记录的编码方法
+            Count docs_count = 0;
+            size_t block_count = 0;
+            const char* skip_table = nullptr;
+            const char* docs_begin = nullptr;
+            size_t docs_size = 0;      ///< 文档区字节数
+            const char* positions_begin = nullptr;
+            size_t positions_size = 0; ///< 位置区字节数
+            const char* bitmap_begin = nullptr;
+            size_t bitmap_size = 0;    ///< 文档位图字节数（无位图时为 0）
+        };
+
+        bool parseLayout(const char* data, size_t size, BlockedLayout& layout) {
+            if (!isBlockedPostings(data, size) || size < kHeaderSize) {
+                return false;
+            }
+            size_t header_size = kHeaderSize;
+            layout.method = static_cast<CompressMethod>(readRaw<std::uint8_t>(data + kCodecField));
+            size_t bitmap_size = 0;
+            if ((readRaw<std::uint8_t>(data + kFlagsField) & kPostingsFlagDocBitmap) != 0) {
+                if (size < header_size + sizeof(std::uint32_t)) {
+                    return false;
+                }
+                bitmap_size = readRaw<std::uint32_t>(data + header_size);
+                header_size += sizeof(std::uint32_t);
+            }
+            layout.docs_count = readRaw<Count>(data + kDocsCountField);
+            if (layout.docs_count < 0) {
+                return false;
+            }
+            const auto docs_size = readRaw<std::uint32_t>(data + kDocsSizeField);
+            layout.block_count = (static_cast<size_t>(layout.docs_count) + kPostingsBlockSize - 1) / kPostingsBlockSize;
+            const size_t table_size = layout.block_count * kSkipEntrySize;
+            if (size - header_size < bitmap_size || size - header_size - bitmap_size < table_size ||
+                size - header_size - bitmap_size - table_size < docs_size) {
+                return false;
+            }
+            layout.skip_table = data + header_size;
+            layout.docs_begin = layout.skip_table + table_size;
+            layout.docs_size = docs_size;
+            layout.positions_begin = layout.docs_begin + docs_size;
+            layout.positions_size = size - header_size - bitmap_size - table_size - docs_size;
+            layout.bitmap_begin = layout.positions_begin + layout.positions_size;
+            layout.bitmap_size = bitmap_size;
+            return true;
+        }
+
+        /**
+         * @brief 解析头部，按标签确定列表的编解码器并读取列表参数
+         * @return 编解码器；头部非法、编码器未注册或参数非法时返回 nullptr
+         */
+        const PostingsCodec* openLayout(const char* data, size_t size, BlockedLayout& layout,
+                                        PostingsCodecParams& params) {
+            if (!parseLayout(data, size, layout)) {
+                spdlog::error("Invalid blocked postings header ({} bytes).", size);
+                return nullptr;
+            }
+            const PostingsCodec* codec = PostingsCodecRegistry::instance().find(layout.method);
+            if (codec == nullptr) {
+                spdlog::error("No postings codec registered for method {}.", static_cast<int>(layout.method));
+                return nullptr;
+            }
+            params = PostingsCodecParams{};
+            if (layout.docs_count > 0 && !codec->decodePrologue(layout.docs_begin, layout.docs_size, params)) {
+                spdlog::error("Invalid {} parameters in postings header.", codec->name());
+                return nullptr;
+            }
+            return codec;
+        }
+
+        template<typename T>
+        T skipField(const char* skip_table, size_t block, size_t field) {
+            return readRaw<T>(skip_table + block * kSkipEntrySize + field);
+        }
+
+        /**
+         * @brief 求第 block 块在某个区（文档区或位置区）中的字节区间
+         * @param field 跳表项中该区偏移字段的位置（kDocOffsetField / kPosOffsetField）
+         * @param section_size 该区字节数
+         * @return 区间合法返回 true
+         */
+        bool blockRange(const char* skip_table, size_t block_count, size_t field, size_t section_size, size_t block,
+                        size_t& begin, size_t& end) {
+            begin = skipField<std::uint32_t>(skip_table, block, field);
+            end = block + 1 < block_count ? skipField<std::uint32_t>(skip_table, block + 1, field) : section_size;
+            return begin <= end && end <= section_size;
+        }
+
+        /**
+         * @brief 将列表按块编码：跳表项写入 out 中 skip_pos 起的预留区域，块数据追加到 out（文档区）与 positions
+         * @param prev_last_doc 列表之前最后一个文档 ID（从头编码时为 0）
+         * @param skip_pos 第一个跳表项在 out 中的字节位置
+         * @param docs_pos 文档区在 out 中的起始位置（块偏移相对于此）
+         * @param positions 位置区缓冲区（块偏移相对于其起点）
+         */
+        void encodeBlocks(const PostingsList& list, const PostingsCodec& codec, const PostingsCodecParams& params,
+                          DocId prev_last_doc, size_t skip_pos, size_t docs_pos, std::vector<char>& out,
+                          std::vector<char>& positions) {
+            const size_t docs_count = static_cast<size_t>(list.getDocumentsCount());
+            const size_t block_count = (docs_count + kPostingsBlockSize - 1) / kPostingsBlockSize;
+            for (size_t block = 0; block < block_count; ++block) {
+                const size_t first = block * kPostingsBlockSize;
+                const size_t last = std::min(first + kPostingsBlockSize, docs_count);
+                const auto doc_offset = static_cast<std::uint32_t>(out.size() - docs_pos);
+                const auto pos_offset = static_cast<std::uint32_t>(positions.size());
+                Count max_tf = 0;
+                for (size_t i = first; i < last; ++i) {
+                    max_tf = std::max(max_tf, list.getPositionsCount(i));
+                }
+
+                codec.encodeDocs(list, first, last, prev_last_doc, params, out);
+                codec.encodePositions(list, first, last, params, positions);
+
+                prev_last_doc = list.getDocumentId(last - 1);
+                char* entry = out.data() + skip_pos + block * kSkipEntrySize;
+                std::memcpy(entry, &prev_last_doc, sizeof(DocId));
+                std::memcpy(entry + kDocOffsetField, &doc_offset, sizeof(doc_offset));
+                std::memcpy(entry + kPosOffsetField, &pos_offset, sizeof(pos_offset));
+                std::memcpy(entry + kMaxTfField, &max_tf, sizeof(Count));
+            }
+        }
+
+        /**
+         * @brief 用指定编解码器编码列表（不含文档位图数据，位图由调用方追加在末尾）
+         * @param bitmap_size 位图字节数；不附带位图时为 std::nullopt
+         */
+        std::vector<char> encodeWithCodec(const PostingsList& list, const PostingsCodec& codec,
+                                          std::optional<std::uint32_t> bitmap_size) {
+            const size_t docs_count = static_cast<size_t>(list.getDocumentsCount());
+            const size_t block_count = (docs_count + kPostingsBlockSize - 1) / kPostingsBlockSize;
+
+            std::vector<char> result;
+            appendRaw(result, kTaggedPostingsMarker);
+            appendRaw(result, static_cast<Count>(docs_count));
+            // 文档区大小与跳表先占位，全部块写完后回填
+            appendRaw(result, std::uint32_t{ 0 });
+            appendRaw(result, static_cast<std::uint8_t>(codec.method()));
+            appendRaw(result, bitmap_size ? kPostingsFlagDocBitmap : std::uint8_t{ 0 });
+            appendRaw(result, std::uint16_t{ 0 });
+            if (bitmap_size) {
+                appendRaw(result, *bitmap_size);
+            }
+            const size_t skip_table_pos = result.size();
+            result.resize(skip_table_pos + block_count * kSkipEntrySize);
+            const size_t docs_pos = result.size();
+
+            PostingsCodecParams params;
+            if (docs_count > 0) {
+                codec.encodePrologue(list, params, result);
+            }
+
+            std::vector<char> positions_section;
+            encodeBlocks(list, codec, params, 0, skip_table_pos, docs_pos, result, positions_section);
+
+            const auto docs_size = static_cast<std::uint32_t>(result.size() - docs_pos);
+            std::memcpy(result.data() + kDocsSizeField, &docs_size, sizeof(docs_size));
+            result.insert(result.end(), positions_section.begin(), positions_section.end());
+            return result;
+        }
+    } // anonymous namespace
+
+    bool isBlockedPostings(const char* data, size_t size) {
+        if (size < sizeof(std::int32_t)) {
+            return false;
+        }
+        return readRaw<std::int32_t>(data) == kTaggedPostingsMarker;
+    }
+
+    bool useDocBitmap(Count docs_count, Count total_docs) {
+        return docs_count >= static_cast<Count>(kDocBitmapMinDocs) &&
+               static_cast<double>(docs_count) >= kDocBitmapMinDfRatio * static_cast<double>(total_docs);
+    }
+
+    std::vector<char> encodeBlockedPostings(const PostingsList& list, CompressMethod method, bool doc_bitmap) {
+        std::vector<char> bitmap;
+        std::optional<std::uint32_t> bitmap_size;
+        if (doc_bitmap) {
+            RoaringBitmap::fromSorted(list.getDocumentIds()).serialize(bitmap);
+            bitmap_size = static_cast<std::uint32_t>(bitmap.size());
+        }
+
+        std::vector<char> result;
+        if (method == CompressMethod::AUTO) {
+            // 逐个编码器试编码：取体积最小者；解码较快的编码器体积相近时优先
+            std::vector<char> fast;
+            for (const PostingsCodec* codec: PostingsCodecRegistry::instance().codecs()) {
+                std::vector<char> encoded = encodeWithCodec(list, *codec, bitmap_size);
+                if (result.empty() || encoded.size() < result.size()) {
+                    result = encoded;
+                }
+                if (codec->fastDecode() && (fast.empty() || encoded.size() < fast.size())) {
+                    fast = std::move(encoded);
+                }
+            }
+            if (!fast.empty() &&
+                static_cast<double>(fast.size()) <= kAutoFastDecodeSlack * static_cast<double>(result.size())) {
+                result = std::move(fast);
+            }
+        } else {
+            const PostingsCodec* codec = PostingsCodecRegistry::instance().find(method);
+            if (codec == nullptr) {
+                spdlog::error("No postings codec registered for method {}, falling back to none.",
+                              static_cast<int>(method));
+                codec = PostingsCodecRegistry::instance().find(CompressMethod::NONE);
+            }
+            result = encodeWithCodec(list, *codec, bitmap_size);
+        }
+        result.insert(result.end(), bitmap.begin(), bitmap.end());
+        return result;
+    }
+
+    std::optional<std::vector<char>> appendBlockedPostings(const char* data, size_t size, const PostingsList& tail,
+                                                           CompressMethod method, bool doc_bitmap) {
+        BlockedLayout layout;
+        if (tail.empty() || !parseLayout(data, size, layout) || layout.docs_count == 0 ||
+            (layout.bitmap_size > 0) != doc_bitmap) {
+            return std::nullopt;
+        }
+        // 配置的方法与列表编码不一致时走完整重编码，使列表迁移到新方法（AUTO 沿用列表原有编码）
+        if (method != CompressMethod::AUTO && method != layout.method) {
+            return std::nullopt;
+        }
+        const PostingsCodec* codec = PostingsCodecRegistry::instance().find(layout.method);
+        PostingsCodecParams params;
+        if (codec == nullptr || !codec->decodePrologue(layout.docs_begin, layout.docs_size, params)) {
+            return std::nullopt;
+        }
+        const size_t last_block = layout.block_count - 1;
+        if (tail.getDocumentId(0) <= skipField<DocId>(layout.skip_table, last_block, 0)) {
+            return std::nullopt;
+        }
+
+        // 最后一块未满时解码它，与新文档一起重新编码；之前的块原样保留
+        const size_t last_docs = static_cast<size_t>(layout.docs_count) - last_block * kPostingsBlockSize;
+        const size_t kept_blocks = last_docs < kPostingsBlockSize ? last_block : layout.block_count;
+        PostingsList carry;
+        if (kept_blocks < layout.block_count) {
+            size_t doc_begin = 0, doc_end = 0, pos_begin = 0, pos_end = 0;
+            std::vector<DocId> doc_ids;
+            std::vector<std::uint32_t> pos_ends;
+            std::vector<Position> positions;
+            const DocId prev_doc = last_block == 0 ? 0 : skipField<DocId>(layout.skip_table, last_block - 1, 0);
+            if (!blockRange(layout.skip_table, layout.block_count, kDocOffsetField, layout.docs_size, last_block,
+                            doc_begin, doc_end) ||
+                !blockRange(layout.skip_table, layout.block_count, kPosOffsetField, layout.positions_size, last_block,
+                            pos_begin, pos_end) ||
+                !codec->decodeDocs(layout.docs_begin + doc_begin, doc_end - doc_begin, params, prev_doc,
+                                   skipField<DocId>(layout.skip_table, last_block, 0), last_docs, doc_ids, pos_ends) ||
+                !codec->decodePositions(layout.positions_begin + pos_begin, pos_end - pos_begin, params, pos_ends,
+                                        positions)) {
+                return std::nullopt;
+            }
+            for (size_t i = 0; i < doc_ids.size(); ++i) {
+                const size_t begin = i == 0 ? 0 : pos_ends[i - 1];
+                carry.appendDocument(doc_ids[i], std::span<const Position>(positions.data() + begin, pos_ends[i] - begin));
+            }
+            for (size_t i = 0; i < static_cast<size_t>(tail.getDocumentsCount()); ++i) {
+                carry.appendDocument(tail.getDocumentId(i), tail.getPositions(i));
+            }
+        }
+        const PostingsList& rest = kept_blocks < layout.block_count ? carry : tail;
+
+        // 保留部分：跳表前 kept_blocks 项、文档区与位置区中这些块之前的字节（含编码器前言）
+        const size_t kept_docs_size = kept_blocks < layout.block_count
+                                          ? skipField<std::uint32_t>(layout.skip_table, kept_blocks, kDocOffsetField)
+                                          : layout.docs_size;
+        const size_t kept_pos_size = kept_blocks < layout.block_count
+                                         ? skipField<std::uint32_t>(layout.skip_table, kept_blocks, kPosOffsetField)
+                                         : layout.positions_size;
+        const size_t rest_docs = static_cast<size_t>(rest.getDocumentsCount());
+        const size_t block_count = kept_blocks + (rest_docs + kPostingsBlockSize - 1) / kPostingsBlockSize;
+        const size_t header_size = static_cast<size_t>(layout.skip_table - data);
+
+        std::vector<char> result(data, layout.skip_table);
+        const auto docs_count = static_cast<Count>(kept_blocks * kPostingsBlockSize + rest_docs);
+        std::memcpy(result.data() + kDocsCountField, &docs_count, sizeof(docs_count));
+        const size_t skip_table_pos = result.size();
+        result.resize(skip_table_pos + block_count * kSkipEntrySize);
+        std::memcpy(result.data() + skip_table_pos, layout.skip_table, kept_blocks * kSkipEntrySize);
+        const size_t docs_pos = result.size();
+        result.insert(result.end(), layout.docs_begin, layout.docs_begin + kept_docs_size);
+
+        std::vector<char> positions_section(layout.positions_begin, layout.positions_begin + kept_pos_size);
+        const DocId prev_last_doc = kept_blocks == 0 ? 0 : skipField<DocId>(layout.skip_table, kept_blocks - 1, 0);
+        encodeBlocks(rest, *codec, params, prev_last_doc, skip_table_pos + kept_blocks * kSkipEntrySize, docs_pos,
+                     result, positions_section);
+
+        const auto docs_size = static_cast<std::uint32_t>(result.size() - docs_pos);
+        std::memcpy(result.data() + kDocsSizeField, &docs_size, sizeof(docs_size));
+        result.insert(result.end(), positions_section.begin(), positions_section.end());
+
+        if (doc_bitmap) {
+            auto bitmap = RoaringBitmap::deserialize(layout.bitmap_begin, layout.bitmap_size);
+            if (!bitmap) {
+                return std::nullopt;
+            }
+            bitmap->appendSorted(tail.getDocumentIds());
+            std::vector<char> bitmap_bytes;
+            bitmap->serialize(bitmap_bytes);
+            const auto bitmap_size = static_cast<std::uint32_t>(bitmap_bytes.size());
+            std::memcpy(result.data() + header_size - sizeof(std::uint32_t), &bitmap_size, sizeof(bitmap_size));
+            result.insert(result.end(), bitmap_bytes.begin(), bitmap_bytes.end());
+        }
+        return result;
+    }
+
+    std::optional<RoaringBitmap> readDocBitmap(std::span<const char> data) {
+        BlockedLayout layout;
+        if (!parseLayout(data.data(), data.size(), layout) || layout.bitmap_size == 0) {
+            return std::nullopt;
+        }
+        auto bitmap = RoaringBitmap::deserialize(layout.bitmap_begin, layout.bitmap_size);
+        if (!bitmap) {
+            spdlog::error("Invalid document bitmap in postings ({} bytes).", layout.bitmap_size);
+        }
+        return bitmap;
+    }
+
+    bool decodeBlockedPostings(const char* data, size_t size, PostingsList& out) {
+        BlockedLayout layout;
+        PostingsCodecParams params;
+        const PostingsCodec* codec = openLayout(data, size, layout, params);
+        if (codec == nullptr) {
+            return false;
+        }
+        std::vector<DocId> doc_ids;
+        std::vector<std::uint32_t> pos_ends;
+        std::vector<Position> positions;
+        for (size_t block = 0; block < layout.block_count; ++block) {
+            size_t doc_begin = 0, doc_end = 0, pos_begin = 0, pos_end = 0;
+            if (!blockRange(layout.skip_table, layout.block_count, kDocOffsetField, layout.docs_size, block,
+                            doc_begin, doc_end) ||
+                !blockRange(layout.skip_table, layout.block_count, kPosOffsetField, layout.positions_size, block,
+                            pos_begin, pos_end)) {
+                spdlog::error("Invalid offset for postings block {}.", block);
+                return false;
+            }
+            const size_t docs = std::min(kPostingsBlockSize,
+                                         static_cast<size_t>(layout.docs_count) - block * kPostingsBlockSize);
+            const DocId prev_doc = block == 0 ? 0 : skipField<DocId>(layout.skip_table, block - 1, 0);
+
+            doc_ids.clear();
+            pos_ends.clear();
+            const bool docs_ok = codec->decodeDocs(layout.docs_begin + doc_begin, doc_end - doc_begin, params,
+                                                   prev_doc, skipField<DocId>(layout.skip_table, block, 0), docs,
+                                                   doc_ids, pos_ends);
+            const bool positions_ok = codec->decodePositions(layout.positions_begin + pos_begin, pos_end - pos_begin,
+                                                             params, pos_ends, positions);
+            for (size_t i = 0; i < doc_ids.size(); ++i) {
+                const size_t begin = i == 0 ? 0 : pos_ends[i - 1];
+                if (pos_ends[i] > positions.size()) {
+                    break;
+                }
+                out.appendDocument(doc_ids[i], std::span<const Position>(positions.data() + begin, pos_ends[i] - begin));
+            }
+            if (!docs_ok || !positions_ok) {
+                spdlog::error("Truncated postings block {}.", block);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // BlockPostingsCursor 实现
+    BlockPostingsCursor::BlockPostingsCursor(const char* data, size_t size, CompressMethod method) {
+        if (size == 0) {
+            return;
+        }
+        if (!isBlockedPostings(data, size)) {
+            // 旧格式没有跳表：整体解码为唯一的块
+            legacy_ = true;
+            PostingsList list;
+            list.deserialize(data, size, method);
+            block_docs_ = list.getDocumentIds();
+            block_pos_ends_.reserve(block_docs_.size());
+            for (size_t i = 0; i < block_docs_.size(); ++i) {
+                auto positions = list.getPositions(i);
+                block_positions_.insert(block_positions_.end(), positions.begin(), positions.end());
+                block_pos_ends_.push_back(static_cast<std::uint32_t>(block_positions_.size()));
+            }
+            block_positions_ready_ = true;
+            docs_count_ = static_cast<Count>(block_docs_.size());
+            block_size_ = block_docs_.size();
+            block_count_ = block_docs_.empty() ? 0 : 1;
+            syncDocId();
+            return;
+        }
+        BlockedLayout layout;
+        codec_ = openLayout(data, size, layout, params_);
+        if (codec_ == nullptr) {
+            return;
+        }
+        docs_count_ = layout.docs_count;
+        block_count_ = layout.block_count;
+        skip_table_ = layout.skip_table;
+        docs_begin_ = layout.docs_begin;
+        docs_size_ = layout.docs_size;
+        positions_begin_ = layout.positions_begin;
+        positions_size_ = layout.positions_size;
+        ef_docs_ = codec_->hasDocsView();
+        loadBlock(0);
+    }
+
+    DocId BlockPostingsCursor::lastDocOf(size_t block) const {
+        return skipField<DocId>(skip_table_, block, 0);
+    }
+
+    void BlockPostingsCursor::syncDocId() {
+        if (block_index_ >= block_count_) {
+            cur_doc_ = kEndDocId;
+        } else if (ef_docs_) {
+            cur_doc_ = block_base_ + static_cast<DocId>(block_ef_.value());
+        } else {
+            cur_doc_ = block_docs_[index_];
+        }
+    }
+
+    void BlockPostingsCursor::loadBlock(size_t block) {
+        index_ = 0;
+        block_index_ = block;
+        if (block >= block_count_) {
+            block_index_ = block_count_;
+            syncDocId();
+            return;
+        }
+
+        block_docs_.clear();
+        block_pos_ends_.clear();
+        block_positions_ready_ = false;
+        size_t begin = 0, end = 0;
+        if (!blockRange(skip_table_, block_count_, kDocOffsetField, docs_size_, block, begin, end)) {
+            spdlog::error("Invalid offset for postings block {}.", block);
+            block_index_ = block_count_;
+            syncDocId();
+            return;
+        }
+        const size_t docs = std::min(kPostingsBlockSize, static_cast<size_t>(docs_count_) - block * kPostingsBlockSize);
+        const DocId prev_doc = block == 0 ? 0 : lastDocOf(block - 1);
+        const char* p = docs_begin_ + begin;
+        if (ef_docs_) {
+            // 文档 ID 不解码，只建立 Elias-Fano 视图；tf 仍整块解码
+            if (!codec_->openDocsView(p, end - begin, prev_doc, lastDocOf(block), docs, block_ef_, block_pos_ends_)) {
+                spdlog::error("Truncated postings block {}.", block);
+                block_pos_ends_.clear();
+            } else {
+                block_base_ = prev_doc;
+            }
+            block_size_ = block_pos_ends_.size();
+        } else {
+            if (!codec_->decodeDocs(p, end - begin, params_, prev_doc, lastDocOf(block), docs, block_docs_,
+                                    block_pos_ends_)) {
+                spdlog::error("Truncated postings block {}.", block);
+            }
+            block_size_ = block_docs_.size();
+        }
+        if (block_size_ == 0) {
+            block_index_ = block_count_;
+        }
+        syncDocId();
+    }
+
+    std::span<const Position> BlockPostingsCursor::positions() {
+        const size_t begin = positionsBegin(index_);
+        const size_t count = block_pos_ends_[index_] - begin;
+        if (!block_positions_ready_) {
+            size_t block_begin = 0, block_end = 0;
+            if (!blockRange(skip_table_, block_count_, kPosOffsetField, positions_size_, block_index_,
+                            block_begin, block_end)) {
+                spdlog::error("Invalid positions offset for postings block {}.", block_index_);
+                return {};
+            }
+            if (codec_->fixedWidthPositions()) {
+                // 定宽存储：直接按 tf 前缀和定位本文档，不解码块内其他文档
+                const size_t byte_begin = block_begin + begin * sizeof(Position);
+                if (byte_begin + count * sizeof(Position) > block_end) {
+                    spdlog::error("Truncated positions in postings block {}.", block_index_);
+                    return {};
+                }
+                doc_positions_.resize(count);
+                std::memcpy(doc_positions_.data(), positions_begin_ + byte_begin, count * sizeof(Position));
+                return doc_positions_;
+            }
+            if (!codec_->decodePositions(positions_begin_ + block_begin, block_end - block_begin, params_,
+                                         block_pos_ends_, block_positions_)) {
+                spdlog::error("Truncated positions in postings block {}.", block_index_);
+            }
+            block_positions_ready_ = true;
+        }
+        if (begin + count > block_positions_.size()) {
+            return {};
+        }
+        return { block_positions_.data() + begin, count };
+    }
+
+    void BlockPostingsCursor::next() {
+        if (block_index_ >= block_count_) {
+            return;
+        }
+        if (++index_ < block_size_) {
+            if (ef_docs_) {
+                block_ef_.next();
+            }
+            syncDocId();
+            return;
+        }
+        if (legacy_) {
+            block_index_ = block_count_;
+            syncDocId();
+        } else {
+            loadBlock(block_index_ + 1);
+        }
+    }
+
+    void BlockPostingsCursor::advance(DocId target) {
+        while (block_index_ < block_count_ && docId() < target) {
+            if (!legacy_ && lastDocOf(block_index_) < target) {
+                // 在跳表上二分查找第一个 last_doc >= target 的块，中间的块不解码
+                size_t lo = block_index_ + 1, hi = block_count_;
+                while (lo < hi) {
+                    const size_t mid = lo + (hi - lo) / 2;
+                    if (lastDocOf(mid) < target) {
+                        lo = mid + 1;
+                    } else {
+                        hi = mid;
+                    }
+                }
+                loadBlock(lo);
+                continue;
+            }
+            if (ef_docs_) {
+                // 目标在当前块内：在 Elias-Fano 高位区上直接定位
+                block_ef_.nextGEQ(static_cast<std::uint32_t>(target - block_base_));
+                index_ = block_ef_.index();
+            } else {
+                // 目标在当前块内：块内二分
+                auto it = std::lower_bound(block_docs_.begin() + static_cast<std::ptrdiff_t>(index_),
+                                           block_docs_.end(), target);
+                index_ = static_cast<size_t>(it - block_docs_.begin());
+            }
+            if (index_ >= block_size_) {
+                // 仅在数据损坏（块内文档不足）时发生，继续下一块
+                if (legacy_) {
+                    block_index_ = block_count_;
+                    syncDocId();
+                } else {
+                    loadBlock(block_index_ + 1);
+                }
+                continue;
+            }
+            syncDocId();
+        }
+    }
+} // namespace wiser
@@ -0,0 +1,483 @@
+/**
+ * @file postings_codec.cpp
+ * @brief 内置倒排编解码器（NONE/GOLOMB/GOLOMB_ADAPTIVE/BP128/ELIAS_FANO）与注册表实现
+ *
+ * 各编码器的块内布局见 postings_block.h 文件说明。
+ */
+
+#include "wiser/postings_codec.h"
+#include "wiser/bitpacking.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <spdlog/spdlog.h>
+
+namespace wiser {
+    namespace {
+        // 每块最多文档数（与 kPostingsBlockSize 相同，解码暂存用）
+        constexpr size_t kMaxBlockDocs = 128;
+        constexpr size_t kGolombParamsSize = 3 * sizeof(std::uint32_t);
+        constexpr std::uint32_t kMaxGolombM = 1u << 30;
+
+        template<typename T>
+        void appendRaw(std::vector<char>& out, T value) {
+            const char* p = reinterpret_cast<const char*>(&value);
+            out.insert(out.end(), p, p + sizeof(T));
+        }
+
+        template<typename T>
+        T readRaw(const char* p) {
+            T value;
+            std::memcpy(&value, p, sizeof(T));
+            return value;
+        }
+
+        /**
+         * @brief 由平均间隔估计 Golomb 最优参数：M ≈ ln2 × 平均值（几何分布近似）
+         */
+        GolombParams estimateGolombParams(std::uint64_t sum, std::uint64_t count) {
+            if (count == 0) {
+                return GolombParams(1);
+            }
+            const double m = 0.69 * static_cast<double>(sum) / static_cast<double>(count);
+            return GolombParams(static_cast<std::uint32_t>(std::clamp(std::llround(m), 1LL,
+                                                                      static_cast<long long>(kMaxGolombM))));
+        }
+
+        /**
+         * @brief 解码位打包的 tf 并追加其块内前缀和
+         * @param p 输入位置，成功时前移
+         * @param end 输入末尾
+         * @param docs 本块文档数
+         * @param pos_ends 输出块内 tf 前缀和（追加）
+         * @return 数据完整返回 true
+         */
+        bool decodePackedTfs(const char*& p, const char* end, size_t docs, std::vector<std::uint32_t>& pos_ends) {
+            std::uint32_t values[kMaxBlockDocs];
+            if (docs > kMaxBlockDocs || !bitPackDecode(p, end, docs, values)) {
+                return false;
+            }
+            std::uint32_t pos_end = 0;
+            for (size_t i = 0; i < docs; ++i) {
+                pos_end += values[i];
+                pos_ends.push_back(pos_end);
+            }
+            return true;
+        }
+
+        void encodePackedTfs(const PostingsList& list, size_t first, size_t last, std::vector<char>& out) {
+            std::uint32_t values[kMaxBlockDocs];
+            for (size_t i = first; i < last; ++i) {
+                values[i - first] = static_cast<std::uint32_t>(list.getPositionsCount(i));
+            }
+            bitPackEncode(std::span<const std::uint32_t>(values, last - first), out);
+        }
+
+        /**
+         * @brief 位置按文档内差分后整块位打包（BP128 与 ELIAS_FANO 共用）
+         */
+        void encodePackedPositions(const PostingsList& list, size_t first, size_t last, std::vector<char>& out) {
+            std::vector<std::uint32_t> values;
+            for (size_t i = first; i < last; ++i) {
+                Position prev_pos = 0;
+                for (Position pos: list.getPositions(i)) {
+                    values.push_back(static_cast<std::uint32_t>(pos - prev_pos));
+                    prev_pos = pos;
+                }
+            }
+            bitPackEncode(values, out);
+        }
+
+        bool decodePackedPositions(const char* p, size_t size, const std::vector<std::uint32_t>& pos_ends,
+                                   std::vector<Position>& positions) {
+            const size_t total = pos_ends.empty() ? 0 : pos_ends.back();
+            positions.resize(total);
+            // 整块位置差分一次解码（Position 与 uint32 同宽，直接解码到输出），再逐文档求前缀和
+            auto* values = reinterpret_cast<std::uint32_t*>(positions.data());
+            if (!bitPackDecode(p, p + size, total, values)) {
+                positions.clear();
+                return false;
+            }
+            size_t begin = 0;
+            for (std::uint32_t end: pos_ends) {
+                Position prev_pos = 0;
+                for (size_t j = begin; j < end; ++j) {
+                    prev_pos += positions[j];
+                    positions[j] = prev_pos;
+                }
+                begin = end;
+            }
+            return true;
+        }
+
+        /**
+         * @brief NONE：文档区逐文档 [doc_id][tf]，位置区逐文档 [position * tf]
+         */
+        class NoneCodec : public PostingsCodec {
+        public:
+            CompressMethod method() const override { return CompressMethod::NONE; }
+            std::string_view name() const override { return "none"; }
+            bool fastDecode() const override { return true; }
+            bool fixedWidthPositions() const override { return true; }
+
+            void encodeDocs(const PostingsList& list, size_t first, size_t last, DocId,
+                            const PostingsCodecParams&, std::vector<char>& out) const override {
+                for (size_t i = first; i < last; ++i) {
+                    appendRaw(out, list.getDocumentId(i));
+                    appendRaw(out, list.getPositionsCount(i));
+                }
+            }
+
+            void encodePositions(const PostingsList& list, size_t first, size_t last,
+                                 const PostingsCodecParams&, std::vector<char>& out) const override {
+                for (size_t i = first; i < last; ++i) {
+                    auto positions = list.getPositions(i);
+                    const char* p = reinterpret_cast<const char*>(positions.data());
+                    out.insert(out.end(), p, p + positions.size_bytes());
+                }
+            }
+
+            bool decodeDocs(const char* p, size_t size, const PostingsCodecParams&, DocId, DocId, size_t docs,
+                            std::vector<DocId>& doc_ids, std::vector<std::uint32_t>& pos_ends) const override {
+                if (size < docs * (sizeof(DocId) + sizeof(Count))) {
+                    return false;
+                }
+                std::uint32_t pos_end = 0;
+                for (size_t i = 0; i < docs; ++i) {
+                    doc_ids.push_back(readRaw<DocId>(p));
+                    pos_end += static_cast<std::uint32_t>(std::max<Count>(0, readRaw<Count>(p + sizeof(DocId))));
+                    pos_ends.push_back(pos_end);
+                    p += sizeof(DocId) + sizeof(Count);
+                }
+                return true;
+            }
+
+            bool decodePositions(const char* p, size_t size, const PostingsCodecParams&,
+                                 const std::vector<std::uint32_t>& pos_ends,
+                                 std::vector<Position>& positions) const override {
+                // 位置连续存放，整块一次拷贝
+                const size_t total = pos_ends.empty() ? 0 : pos_ends.back();
+                if (size < total * sizeof(Position)) {
+                    positions.clear();
+                    return false;
+                }
+                positions.resize(total);
+                std::memcpy(positions.data(), p, total * sizeof(Position));
+                return true;
+            }
+        };
+
+        /**
+         * @brief GOLOMB / GOLOMB_ADAPTIVE：文档区与位置区各为块内独立位流（字节对齐）
+         *
+         * GOLOMB_ADAPTIVE 的参数按列表估计，以 [m_doc][m_tf][m_pos] 写在文档区起始处。
+         */
+        class GolombCodec : public PostingsCodec {
+        public:
+            explicit GolombCodec(bool adaptive) : adaptive_(adaptive) {}
+
+            CompressMethod method() const override {
+                return adaptive_ ? CompressMethod::GOLOMB_ADAPTIVE : CompressMethod::GOLOMB;
+            }
+
+            std::string_view name() const override { return adaptive_ ? "golomb-adaptive" : "golomb"; }
+
+            void encodePrologue(const PostingsList& list, PostingsCodecParams& params,
+                                std::vector<char>& out) const override {
+                if (!adaptive_) {
+                    return;
+                }
+                params.golomb = chooseGolombParams(list);
+                appendRaw(out, params.golomb.doc.M);
+                appendRaw(out, params.golomb.count.M);
+                appendRaw(out, params.golomb.pos.M);
+            }
+
+            bool decodePrologue(const char* data, size_t size, PostingsCodecParams& params) const override {
+                if (!adaptive_) {
+                    return true;
+                }
+                if (size < kGolombParamsSize) {
+                    return false;
+                }
+                std::uint32_t m[3];
+                std::memcpy(m, data, kGolombParamsSize);
+                for (std::uint32_t v: m) {
+                    if (v == 0 || v > kMaxGolombM) {
+                        return false;
+                    }
+                }
+                params.golomb.doc = GolombParams(m[0]);
+                params.golomb.count = GolombParams(m[1]);
+                params.golomb.pos = GolombParams(m[2]);
+                return true;
+            }
+
+            void encodeDocs(const PostingsList& list, size_t first, size_t last, DocId prev_doc,
+                            const PostingsCodecParams& params, std::vector<char>& out) const override {
+                BitWriter writer;
+                for (size_t i = first; i < last; ++i) {
+                    const DocId doc_id = list.getDocumentId(i);
+                    GolombEncoder::encode(static_cast<uint32_t>(doc_id - prev_doc), params.golomb.doc, writer);
+                    GolombEncoder::encode(static_cast<uint32_t>(list.getPositionsCount(i)), params.golomb.count, writer);
+                    prev_doc = doc_id;
+                }
+                auto bits = writer.getData();
+                out.insert(out.end(), bits.begin(), bits.end());
+            }
+
+            void encodePositions(const PostingsList& list, size_t first, size_t last,
+                                 const PostingsCodecParams& params, std::vector<char>& out) const override {
+                BitWriter writer;
+                for (size_t i = first; i < last; ++i) {
+                    Position prev_pos = 0;
+                    for (Position pos: list.getPositions(i)) {
+                        GolombEncoder::encode(static_cast<uint32_t>(pos - prev_pos), params.golomb.pos, writer);
+                        prev_pos = pos;
+                    }
+                }
+                auto bits = writer.getData();
+                out.insert(out.end(), bits.begin(), bits.end());
+            }
+
+            bool decodeDocs(const char* p, size_t size, const PostingsCodecParams& params, DocId prev_doc, DocId,
+                            size_t docs, std::vector<DocId>& doc_ids,
+                            std::vector<std::uint32_t>& pos_ends) const override {
+                BitReader reader(p, size);
+                std::uint32_t pos_end = 0;
+                try {
+                    for (size_t i = 0; i < docs; ++i) {
+                        const DocId doc_id = prev_doc +
+                                             static_cast<DocId>(GolombDecoder::decode(params.golomb.doc, reader));
+                        prev_doc = doc_id;
+                        pos_end += GolombDecoder::decode(params.golomb.count, reader);
+                        doc_ids.push_back(doc_id);
+                        pos_ends.push_back(pos_end);
+                    }
+                } catch (const std::exception& e) {
+                    spdlog::error("Error decoding Golomb postings block: {}", e.what());
+                    return false;
+                }
+                return true;
+            }
+
+            bool decodePositions(const char* p, size_t size, const PostingsCodecParams& params,
+                                 const std::vector<std::uint32_t>& pos_ends,
+                                 std::vector<Position>& positions) const override {
+                positions.resize(pos_ends.empty() ? 0 : pos_ends.back());
+                BitReader reader(p, size);
+                size_t begin = 0;
+                try {
+                    for (std::uint32_t end: pos_ends) {
+                        Position prev_pos = 0;
+                        for (size_t j = begin; j < end; ++j) {
+                            prev_pos += static_cast<Position>(GolombDecoder::decode(params.golomb.pos, reader));
+                            positions[j] = prev_pos;
+                        }
+                        begin = end;
+                    }
+                } catch (const std::exception& e) {
+                    spdlog::error("Error decoding Golomb positions block: {}", e.what());
+                    positions.resize(begin);
+                    return false;
+                }
+                return true;
+            }
+
+        private:
+            bool adaptive_;
+        };
+
+        /**
+         * @brief BP128：文档区为 doc_id 差分与 tf 两组位打包数据，位置区为整块位置差分的位打包数据
+         */
+        class Bp128Codec : public PostingsCodec {
+        public:
+            CompressMethod method() const override { return CompressMethod::BP128; }
+            std::string_view name() const override { return "bp128"; }
+            bool fastDecode() const override { return true; }
+
+            void encodeDocs(const PostingsList& list, size_t first, size_t last, DocId prev_doc,
+                            const PostingsCodecParams&, std::vector<char>& out) const override {
+                std::uint32_t values[kMaxBlockDocs];
+                for (size_t i = first; i < last; ++i) {
+                    values[i - first] = static_cast<std::uint32_t>(list.getDocumentId(i) - prev_doc);
+                    prev_doc = list.getDocumentId(i);
+                }
+                bitPackEncode(std::span<const std::uint32_t>(values, last - first), out);
+                encodePackedTfs(list, first, last, out);
+            }
+
+            void encodePositions(const PostingsList& list, size_t first, size_t last,
+                                 const PostingsCodecParams&, std::vector<char>& out) const override {
+                encodePackedPositions(list, first, last, out);
+            }
+
+            bool decodeDocs(const char* p, size_t size, const PostingsCodecParams&, DocId prev_doc, DocId,
+                            size_t docs, std::vector<DocId>& doc_ids,
+                            std::vector<std::uint32_t>& pos_ends) const override {
+                std::uint32_t values[kMaxBlockDocs];
+                const char* end = p + size;
+                if (docs > kMaxBlockDocs || !bitPackDecode(p, end, docs, values)) {
+                    return false;
+                }
+                for (size_t i = 0; i < docs; ++i) {
+                    prev_doc += static_cast<DocId>(values[i]);
+                    doc_ids.push_back(prev_doc);
+                }
+                if (!decodePackedTfs(p, end, docs, pos_ends)) {
+                    doc_ids.resize(doc_ids.size() - docs);
+                    return false;
+                }
+                return true;
+            }
+
+            bool decodePositions(const char* p, size_t size, const PostingsCodecParams&,
+                                 const std::vector<std::uint32_t>& pos_ends,
+                                 std::vector<Position>& positions) const override {
+                return decodePackedPositions(p, size, pos_ends, positions);
+            }
+        };
+
+        /**
+         * @brief ELIAS_FANO：文档区为 doc_id（相对上一块末尾文档，上界取本块 last_doc）的 Elias-Fano 序列
+         *        与位打包 tf；位置区同 BP128
+         */
+        class EliasFanoCodec : public PostingsCodec {
+        public:
+            CompressMethod method() const override { return CompressMethod::ELIAS_FANO; }
+            std::string_view name() const override { return "eliasfano"; }
+            bool fastDecode() const override { return true; }
+            bool hasDocsView() const override { return true; }
+
+            void encodeDocs(const PostingsList& list, size_t first, size_t last, DocId prev_doc,
+                            const PostingsCodecParams&, std::vector<char>& out) const override {
+                std::uint32_t values[kMaxBlockDocs];
+                for (size_t i = first; i < last; ++i) {
+                    values[i - first] = static_cast<std::uint32_t>(list.getDocumentId(i) - prev_doc);
+                }
+                eliasFanoEncode(std::span<const std::uint32_t>(values, last - first),
+                                universe(prev_doc, list.getDocumentId(last - 1)), out);
+                encodePackedTfs(list, first, last, out);
+            }
+
+            void encodePositions(const PostingsList& list, size_t first, size_t last,
+                                 const PostingsCodecParams&, std::vector<char>& out) const override {
+                encodePackedPositions(list, first, last, out);
+            }
+
+            bool decodeDocs(const char* p, size_t size, const PostingsCodecParams&, DocId prev_doc, DocId last_doc,
+                            size_t docs, std::vector<DocId>& doc_ids,
+                            std::vector<std::uint32_t>& pos_ends) const override {
+                EliasFanoView view;
+                if (!openDocsView(p, size, prev_doc, last_doc, docs, view, pos_ends)) {
+                    return false;
+                }
+                for (; view.index() < docs; view.next()) {
+                    doc_ids.push_back(prev_doc + static_cast<DocId>(view.value()));
+                }
+                return true;
+            }
+
+            bool decodePositions(const char* p, size_t size, const PostingsCodecParams&,
+                                 const std::vector<std::uint32_t>& pos_ends,
+                                 std::vector<Position>& positions) const override {
+                return decodePackedPositions(p, size, pos_ends, positions);
+            }
+
+            bool openDocsView(const char* p, size_t size, DocId prev_doc, DocId last_doc, size_t docs,
+                              EliasFanoView& view, std::vector<std::uint32_t>& pos_ends) const override {
+                const std::uint32_t u = universe(prev_doc, last_doc);
+                const size_t ef_size = eliasFanoSize(docs, u);
+                if (size < ef_size) {
+                    return false;
+                }
+                const char* tfs = p + ef_size;
+                if (!decodePackedTfs(tfs, p + size, docs, pos_ends)) {
+                    return false;
+                }
+                view = EliasFanoView(p, docs, u);
+                return true;
+            }
+
+        private:
+            static std::uint32_t universe(DocId prev_doc, DocId last_doc) {
+                return static_cast<std::uint32_t>(last_doc - prev_doc);
+            }
+        };
+    } // anonymous namespace
+
+    GolombListParams chooseGolombParams(const PostingsList& list) {
+        const auto n = static_cast<size_t>(list.getDocumentsCount());
+        GolombListParams params;
+        if (n == 0) {
+            return params;
+        }
+        // 各差分序列之和可直接由首尾值求得（差分求和即末值）
+        std::uint64_t pos_sum = 0;
+        std::uint64_t pos_count = 0;
+        for (size_t i = 0; i < n; ++i) {
+            auto positions = list.getPositions(i);
+            if (!positions.empty()) {
+                pos_sum += static_cast<std::uint64_t>(positions.back());
+                pos_count += positions.size();
+            }
+        }
+        params.doc = estimateGolombParams(static_cast<std::uint64_t>(list.getDocumentId(n - 1)), n);
+        params.count = estimateGolombParams(pos_count, n);
+        params.pos = estimateGolombParams(pos_sum, pos_count);
+        return params;
+    }
+
+    // PostingsCodecRegistry 实现
+    PostingsCodecRegistry::PostingsCodecRegistry() {
+        add(std::make_unique<NoneCodec>());
+        add(std::make_unique<GolombCodec>(false));
+        add(std::make_unique<Bp128Codec>());
+        add(std::make_unique<EliasFanoCodec>());
+        add(std::make_unique<GolombCodec>(true));
+    }
+
+    PostingsCodecRegistry& PostingsCodecRegistry::instance() {
+        static PostingsCodecRegistry registry;
+        return registry;
+    }
+
+    void PostingsCodecRegistry::add(std::unique_ptr<PostingsCodec> codec) {
+        for (auto& existing: codecs_) {
+            if (existing->method() == codec->method()) {
+                existing = std::move(codec);
+                return;
+            }
+        }
+        codecs_.push_back(std::move(codec));
+    }
+
+    const PostingsCodec* PostingsCodecRegistry::find(CompressMethod method) const {
+        for (const auto& codec: codecs_) {
+            if (codec->method() == method) {
+                return codec.get();
+            }
+        }
+        return nullptr;
+    }
+
+    const PostingsCodec* PostingsCodecRegistry::find(std::string_view name) const {
+        for (const auto& codec: codecs_) {
+            if (codec->name() == name) {
+                return codec.get();
+            }
+        }
+        return nullptr;
+    }
+
+    std::vector<const PostingsCodec*> PostingsCodecRegistry::codecs() const {
+        std::vector<const PostingsCodec*> result;
+        result.reserve(codecs_.size());
+        for (const auto& codec: codecs_) {
+            result.push_back(codec.get());
+        }
+        return result;
+    }
+} // namespace wiser
@@ -0,0 +1,60 @@
+/**
+ * @file postings_cursor.cpp
+ * @brief 内存倒排游标与并集游标实现
+ */
+
+#include "wiser/postings_cursor.h"
+#include <algorithm>
+#include <iterator>
+
+namespace wiser {
+    // MemoryPostingsCursor 实现
+    void MemoryPostingsCursor::advance(DocId target) {
+        const auto& ids = list_.getDocumentIds();
+        if (index_ >= ids.size() || ids[index_] >= target) {
+            return;
+        }
+        auto it = std::lower_bound(ids.begin() + static_cast<std::ptrdiff_t>(index_), ids.end(), target);
+        index_ = static_cast<size_t>(it - ids.begin());
+    }
+
+    // UnionPostingsCursor 实现
+    void UnionPostingsCursor::next() {
+        const DocId doc_id = docId();
+        if (first_->docId() == doc_id) {
+            first_->next();
+        }
+        if (second_->docId() == doc_id) {
+            second_->next();
+        }
+    }
+
+    Count UnionPostingsCursor::tf() const {
+        const DocId doc_id = docId();
+        Count tf = 0;
+        if (first_->docId() == doc_id) {
+            tf += first_->tf();
+        }
+        if (second_->docId() == doc_id) {
+            tf += second_->tf();
+        }
+        return tf;
+    }
+
+    std::span<const Position> UnionPostingsCursor::positions() {
+        const DocId doc_id = docId();
+        const bool in_first = first_->docId() == doc_id;
+        const bool in_second = second_->docId() == doc_id;
+        if (!in_second) {
+            return first_->positions();
+        }
+        if (!in_first) {
+            return second_->positions();
+        }
+        auto a = first_->positions();
+        auto b = second_->positions();
+        merged_positions_.clear();
+        std::ranges::merge(a, b, std::back_inserter(merged_positions_));
+        return merged_positions_;
+    }
+} // namespace wiser
@@ -0,0 +1,195 @@
+/**
+ * @file postings_file.cpp
+ * @brief 内存映射倒排文件的写出与读取
+ */
+
+#include "wiser/postings_file.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <spdlog/spdlog.h>
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace wiser {
+    namespace {
+        /**
+         * @brief 文件头部的定宽字段（其余部分以零填充到 kPostingsFileHeaderSize）
+         */
+        struct PostingsFileHeader {
+            std::uint32_t magic;
+            std::uint32_t version;
+            std::uint32_t entry_count;
+            std::uint32_t reserved;
+            std::uint64_t directory_offset;
+        };
+        static_assert(sizeof(PostingsFileHeader) <= kPostingsFileHeaderSize);
+
+        bool syncFile(std::FILE* file) {
+#ifdef _WIN32
+            return _commit(_fileno(file)) == 0;
+#else
+            return ::fsync(fileno(file)) == 0;
+#endif
+        }
+    } // anonymous namespace
+
+    PostingsFileWriter::~PostingsFileWriter() {
+        if (file_) {
+            std::fclose(file_);
+        }
+    }
+
+    bool PostingsFileWriter::open(const std::string& path) {
+        file_ = std::fopen(path.c_str(), "wb");
+        if (!file_) {
+            spdlog::error("Cannot create postings file: {}", path);
+            return false;
+        }
+        // 头部在 finish 时回填
+        static const std::array<char, kPostingsFileHeaderSize> zeros{};
+        offset_ = 0;
+        entries_.clear();
+        return writeBytes(zeros.data(), zeros.size());
+    }
+
+    bool PostingsFileWriter::add(const SegmentPostingsRecord& record) {
+        if (!file_ || (!entries_.empty() && record.token_id <= entries_.back().token_id)) {
+            return false;
+        }
+        entries_.push_back(PostingsFileEntry{ record.token_id, record.docs_count, record.first_doc, record.last_doc,
+                                              offset_, record.postings.size() });
+        if (!writeBytes(record.postings.data(), record.postings.size())) {
+            return false;
+        }
+        static const std::array<char, kPostingsFileAlignment> zeros{};
+        const size_t padding = (kPostingsFileAlignment - offset_ % kPostingsFileAlignment) % kPostingsFileAlignment;
+        return writeBytes(zeros.data(), padding);
+    }
+
+    bool PostingsFileWriter::finish() {
+        if (!file_) {
+            return false;
+        }
+        const PostingsFileHeader header{ kPostingsFileMagic, kPostingsFileVersion,
+                                         static_cast<std::uint32_t>(entries_.size()), 0, offset_ };
+        bool ok = writeBytes(entries_.data(), entries_.size() * sizeof(PostingsFileEntry)) &&
+                  std::fseek(file_, 0, SEEK_SET) == 0 &&
+                  std::fwrite(&header, sizeof(header), 1, file_) == 1 &&
+                  std::fflush(file_) == 0 && syncFile(file_);
+        ok = std::fclose(file_) == 0 && ok;
+        file_ = nullptr;
+        return ok;
+    }
+
+    bool PostingsFileWriter::writeBytes(const void* data, size_t size) {
+        if (size > 0 && std::fwrite(data, 1, size, file_) != size) {
+            return false;
+        }
+        offset_ += size;
+        return true;
+    }
+
+    MappedPostingsFile::~MappedPostingsFile() {
+#ifdef _WIN32
+        if (data_) {
+            UnmapViewOfFile(data_);
+        }
+        if (mapping_handle_) {
+            CloseHandle(mapping_handle_);
+        }
+        if (file_handle_) {
+            CloseHandle(file_handle_);
+        }
+#else
+        if (data_) {
+            ::munmap(const_cast<char*>(data_), size_);
+        }
+#endif
+    }
+
+    std::shared_ptr<const MappedPostingsFile> MappedPostingsFile::open(const std::string& path) {
+        std::shared_ptr<MappedPostingsFile> file(new MappedPostingsFile());
+#ifdef _WIN32
+        HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+                                    OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (handle == INVALID_HANDLE_VALUE) {
+            spdlog::error("Cannot open postings file: {}", path);
+            return nullptr;
+        }
+        file->file_handle_ = handle;
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(handle, &size) || size.QuadPart < static_cast<LONGLONG>(kPostingsFileHeaderSize)) {
+            spdlog::error("Postings file is truncated: {}", path);
+            return nullptr;
+        }
+        file->size_ = static_cast<size_t>(size.QuadPart);
+        file->mapping_handle_ = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!file->mapping_handle_) {
+            spdlog::error("Cannot map postings file: {}", path);
+            return nullptr;
+        }
+        file->data_ = static_cast<const char*>(MapViewOfFile(file->mapping_handle_, FILE_MAP_READ, 0, 0, 0));
+        if (!file->data_) {
+            spdlog::error("Cannot map postings file: {}", path);
+            return nullptr;
+        }
+#else
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            spdlog::error("Cannot open postings file: {}", path);
+            return nullptr;
+        }
+        struct stat st {};
+        if (::fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(kPostingsFileHeaderSize)) {
+            ::close(fd);
+            spdlog::error("Postings file is truncated: {}", path);
+            return nullptr;
+        }
+        file->size_ = static_cast<size_t>(st.st_size);
+        void* data = ::mmap(nullptr, file->size_, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd); // 映射建立后不再需要文件描述符
+        if (data == MAP_FAILED) {
+            spdlog::error("Cannot map postings file: {}", path);
+            return nullptr;
+        }
+        file->data_ = static_cast<const char*>(data);
+#endif
+
+        PostingsFileHeader header;
+        std::memcpy(&header, file->data_, sizeof(header));
+        if (header.magic != kPostingsFileMagic || header.version != kPostingsFileVersion) {
+            spdlog::error("Not a postings file (or unsupported version): {}", path);
+            return nullptr;
+        }
+        const std::uint64_t directory_size = std::uint64_t{ header.entry_count } * sizeof(PostingsFileEntry);
+        if (header.directory_offset < kPostingsFileHeaderSize ||
+            header.directory_offset % alignof(PostingsFileEntry) != 0 ||
+            header.directory_offset + directory_size != file->size_) {
+            spdlog::error("Postings file directory is corrupt: {}", path);
+            return nullptr;
+        }
+        // 倒排区从页边界开始且按 8 字节对齐，目录可以直接当作数组读取
+        file->entries_ = { reinterpret_cast<const PostingsFileEntry*>(file->data_ + header.directory_offset),
+                           header.entry_count };
+        for (const auto& entry: file->entries_) {
+            if (entry.offset < kPostingsFileHeaderSize || entry.offset + entry.length > header.directory_offset) {
+                spdlog::error("Postings file entry of token {} is out of range: {}", entry.token_id, path);
+                return nullptr;
+            }
+        }
+        return file;
+    }
+
+    const PostingsFileEntry* MappedPostingsFile::find(TokenId token_id) const {
+        auto it = std::ranges::lower_bound(entries_, token_id, {}, &PostingsFileEntry::token_id);
+        return it != entries_.end() && it->token_id == token_id ? &*it : nullptr;
+    }
+} // namespace wiser
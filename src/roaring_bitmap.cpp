@@ -0,0 +1,354 @@
+/**
+ * @file roaring_bitmap.cpp
+ * @brief Roaring 风格压缩位图实现
+ */
+
+#include "wiser/roaring_bitmap.h"
+#include <algorithm>
+#include <cstring>
+
+namespace wiser {
+    namespace {
+        constexpr size_t kBitmapWords = 65536 / 64;
+
+        template<typename T>
+        void appendRaw(std::vector<char>& out, T value) {
+            const char* p = reinterpret_cast<const char*>(&value);
+            out.insert(out.end(), p, p + sizeof(T));
+        }
+
+        template<typename T>
+        void appendArray(std::vector<char>& out, const std::vector<T>& values) {
+            const char* p = reinterpret_cast<const char*>(values.data());
+            out.insert(out.end(), p, p + values.size() * sizeof(T));
+        }
+
+        template<typename T>
+        T readRaw(const char* p) {
+            T value;
+            std::memcpy(&value, p, sizeof(T));
+            return value;
+        }
+    } // anonymous namespace
+
+    bool RoaringBitmap::Container::contains(std::uint16_t low) const {
+        switch (type) {
+            case Type::Array:
+                return std::binary_search(values.begin(), values.end(), low);
+            case Type::Bitmap:
+                return (words[low / 64] >> (low % 64)) & 1u;
+            case Type::Run: {
+                // 找到最后一个起点 <= low 的游程
+                size_t lo = 0, hi = values.size() / 2;
+                while (lo < hi) {
+                    const size_t mid = lo + (hi - lo) / 2;
+                    if (values[mid * 2] <= low) {
+                        lo = mid + 1;
+                    } else {
+                        hi = mid;
+                    }
+                }
+                if (lo == 0) {
+                    return false;
+                }
+                const size_t run = lo - 1;
+                return low - values[run * 2] <= values[run * 2 + 1];
+            }
+        }
+        return false;
+    }
+
+    std::vector<std::uint64_t> RoaringBitmap::Container::toWords() const {
+        if (type == Type::Bitmap) {
+            return words;
+        }
+        std::vector<std::uint64_t> result(kBitmapWords, 0);
+        if (type == Type::Array) {
+            for (std::uint16_t v: values) {
+                result[v / 64] |= std::uint64_t{ 1 } << (v % 64);
+            }
+            return result;
+        }
+        for (size_t i = 0; i + 1 < values.size(); i += 2) {
+            const std::uint32_t start = values[i];
+            const std::uint32_t end = start + values[i + 1]; // 含
+            for (std::uint32_t v = start; v <= end; ++v) {
+                result[v / 64] |= std::uint64_t{ 1 } << (v % 64);
+            }
+        }
+        return result;
+    }
+
+    std::vector<std::uint16_t> RoaringBitmap::Container::toLows() const {
+        if (type == Type::Array) {
+            return values;
+        }
+        std::vector<std::uint16_t> result;
+        result.reserve(cardinality);
+        if (type == Type::Bitmap) {
+            for (size_t w = 0; w < words.size(); ++w) {
+                for (std::uint64_t bits = words[w]; bits != 0; bits &= bits - 1) {
+                    result.push_back(static_cast<std::uint16_t>(w * 64 + static_cast<size_t>(std::countr_zero(bits))));
+                }
+            }
+            return result;
+        }
+        for (size_t i = 0; i + 1 < values.size(); i += 2) {
+            const std::uint32_t start = values[i];
+            for (std::uint32_t v = start; v <= start + values[i + 1]; ++v) {
+                result.push_back(static_cast<std::uint16_t>(v));
+            }
+        }
+        return result;
+    }
+
+    RoaringBitmap::Container RoaringBitmap::makeContainer(std::uint16_t key, std::span<const std::uint16_t> lows) {
+        Container c;
+        c.key = key;
+        c.cardinality = static_cast<std::uint32_t>(lows.size());
+
+        size_t runs = 0;
+        for (size_t i = 0; i < lows.size(); ++i) {
+            if (i == 0 || lows[i] != lows[i - 1] + 1) {
+                ++runs;
+            }
+        }
+        const size_t array_bytes = lows.size() <= kArrayContainerMax ? lows.size() * 2 : SIZE_MAX;
+        const size_t bitmap_bytes = kBitmapWords * sizeof(std::uint64_t);
+        const size_t run_bytes = runs * 4;
+
+        if (run_bytes < array_bytes && run_bytes < bitmap_bytes) {
+            c.type = Type::Run;
+            c.values.reserve(runs * 2);
+            for (size_t i = 0; i < lows.size(); ++i) {
+                if (i == 0 || lows[i] != lows[i - 1] + 1) {
+                    c.values.push_back(lows[i]);
+                    c.values.push_back(0);
+                } else {
+                    ++c.values.back();
+                }
+            }
+        } else if (array_bytes <= bitmap_bytes) {
+            c.type = Type::Array;
+            c.values.assign(lows.begin(), lows.end());
+        } else {
+            c.type = Type::Bitmap;
+            c.words.assign(kBitmapWords, 0);
+            for (std::uint16_t v: lows) {
+                c.words[v / 64] |= std::uint64_t{ 1 } << (v % 64);
+            }
+        }
+        return c;
+    }
+
+    RoaringBitmap::Container RoaringBitmap::fromWords(std::uint16_t key, std::vector<std::uint64_t> words) {
+        Container c;
+        c.key = key;
+        for (std::uint64_t w: words) {
+            c.cardinality += static_cast<std::uint32_t>(std::popcount(w));
+        }
+        if (c.cardinality > kArrayContainerMax) {
+            c.type = Type::Bitmap;
+            c.words = std::move(words);
+            return c;
+        }
+        c.type = Type::Array;
+        c.values.reserve(c.cardinality);
+        for (size_t w = 0; w < words.size(); ++w) {
+            for (std::uint64_t bits = words[w]; bits != 0; bits &= bits - 1) {
+                c.values.push_back(static_cast<std::uint16_t>(w * 64 + static_cast<size_t>(std::countr_zero(bits))));
+            }
+        }
+        return c;
+    }
+
+    RoaringBitmap::Container RoaringBitmap::intersect(const Container& a, const Container& b) {
+        if (a.type == Type::Array || b.type == Type::Array) {
+            // 数组容器较小：逐个探测另一侧
+            const Container& small = a.type == Type::Array ? a : b;
+            const Container& other = a.type == Type::Array ? b : a;
+            Container c;
+            c.key = a.key;
+            c.type = Type::Array;
+            for (std::uint16_t v: small.values) {
+                if (other.contains(v)) {
+                    c.values.push_back(v);
+                }
+            }
+            c.cardinality = static_cast<std::uint32_t>(c.values.size());
+            return c;
+        }
+        // 位图/游程：展开为位图后按 64 位字 AND
+        std::vector<std::uint64_t> words = a.toWords();
+        if (b.type == Type::Bitmap) {
+            for (size_t w = 0; w < kBitmapWords; ++w) {
+                words[w] &= b.words[w];
+            }
+        } else {
+            const std::vector<std::uint64_t> other = b.toWords();
+            for (size_t w = 0; w < kBitmapWords; ++w) {
+                words[w] &= other[w];
+            }
+        }
+        return fromWords(a.key, std::move(words));
+    }
+
+    RoaringBitmap RoaringBitmap::fromSorted(std::span<const std::int32_t> values) {
+        RoaringBitmap bitmap;
+        std::vector<std::uint16_t> lows;
+        size_t i = 0;
+        while (i < values.size()) {
+            const auto key = static_cast<std::uint16_t>(static_cast<std::uint32_t>(values[i]) >> 16);
+            lows.clear();
+            for (; i < values.size() && static_cast<std::uint32_t>(values[i]) >> 16 == key; ++i) {
+                const auto low = static_cast<std::uint16_t>(values[i]);
+                if (lows.empty() || lows.back() != low) {
+                    lows.push_back(low);
+                }
+            }
+            bitmap.containers_.push_back(makeContainer(key, lows));
+        }
+        return bitmap;
+    }
+
+    void RoaringBitmap::appendSorted(std::span<const std::int32_t> values) {
+        std::vector<std::uint16_t> lows;
+        size_t i = 0;
+        while (i < values.size()) {
+            const auto key = static_cast<std::uint16_t>(static_cast<std::uint32_t>(values[i]) >> 16);
+            const bool same_key = !containers_.empty() && containers_.back().key == key;
+            // 新值与最后一个桶同键时，在其原有元素之后继续追加
+            lows = same_key ? containers_.back().toLows() : std::vector<std::uint16_t>{};
+            for (; i < values.size() && static_cast<std::uint32_t>(values[i]) >> 16 == key; ++i) {
+                const auto low = static_cast<std::uint16_t>(values[i]);
+                if (lows.empty() || lows.back() < low) {
+                    lows.push_back(low);
+                }
+            }
+            if (same_key) {
+                containers_.back() = makeContainer(key, lows);
+            } else {
+                containers_.push_back(makeContainer(key, lows));
+            }
+        }
+    }
+
+    void RoaringBitmap::intersectWith(const RoaringBitmap& other) {
+        std::vector<Container> result;
+        size_t j = 0;
+        for (const auto& c: containers_) {
+            while (j < other.containers_.size() && other.containers_[j].key < c.key) {
+                ++j;
+            }
+            if (j == other.containers_.size()) {
+                break;
+            }
+            if (other.containers_[j].key == c.key) {
+                Container merged = intersect(c, other.containers_[j]);
+                if (merged.cardinality > 0) {
+                    result.push_back(std::move(merged));
+                }
+            }
+        }
+        containers_ = std::move(result);
+    }
+
+    bool RoaringBitmap::contains(std::uint32_t value) const {
+        const auto key = static_cast<std::uint16_t>(value >> 16);
+        auto it = std::lower_bound(containers_.begin(), containers_.end(), key,
+                                   [](const Container& c, std::uint16_t k) { return c.key < k; });
+        return it != containers_.end() && it->key == key && it->contains(static_cast<std::uint16_t>(value));
+    }
+
+    std::uint64_t RoaringBitmap::cardinality() const {
+        std::uint64_t total = 0;
+        for (const auto& c: containers_) {
+            total += c.cardinality;
+        }
+        return total;
+    }
+
+    void RoaringBitmap::serialize(std::vector<char>& out) const {
+        appendRaw(out, static_cast<std::uint32_t>(containers_.size()));
+        for (const auto& c: containers_) {
+            appendRaw(out, c.key);
+            appendRaw(out, static_cast<std::uint16_t>(c.type));
+            switch (c.type) {
+                case Type::Array:
+                    appendRaw(out, static_cast<std::uint32_t>(c.values.size()));
+                    appendArray(out, c.values);
+                    break;
+                case Type::Bitmap:
+                    appendRaw(out, c.cardinality);
+                    appendArray(out, c.words);
+                    break;
+                case Type::Run:
+                    appendRaw(out, static_cast<std::uint32_t>(c.values.size() / 2));
+                    appendArray(out, c.values);
+                    break;
+            }
+        }
+    }
+
+    std::optional<RoaringBitmap> RoaringBitmap::deserialize(const char* data, size_t size) {
+        const char* p = data;
+        const char* end = data + size;
+        if (size < sizeof(std::uint32_t)) {
+            return std::nullopt;
+        }
+        const auto count = readRaw<std::uint32_t>(p);
+        p += sizeof(std::uint32_t);
+
+        RoaringBitmap bitmap;
+        bitmap.containers_.reserve(count);
+        constexpr size_t kContainerHeader = 2 * sizeof(std::uint16_t) + sizeof(std::uint32_t);
+        for (std::uint32_t i = 0; i < count; ++i) {
+            if (static_cast<size_t>(end - p) < kContainerHeader) {
+                return std::nullopt;
+            }
+            Container c;
+            c.key = readRaw<std::uint16_t>(p);
+            const auto type = readRaw<std::uint16_t>(p + sizeof(std::uint16_t));
+            const auto n = readRaw<std::uint32_t>(p + 2 * sizeof(std::uint16_t));
+            p += kContainerHeader;
+
+            size_t bytes = 0;
+            switch (type) {
+                case static_cast<std::uint16_t>(Type::Array):
+                    c.type = Type::Array;
+                    c.cardinality = n;
+                    bytes = static_cast<size_t>(n) * sizeof(std::uint16_t);
+                    break;
+                case static_cast<std::uint16_t>(Type::Bitmap):
+                    c.type = Type::Bitmap;
+                    c.cardinality = n;
+                    bytes = kBitmapWords * sizeof(std::uint64_t);
+                    break;
+                case static_cast<std::uint16_t>(Type::Run):
+                    c.type = Type::Run;
+                    bytes = static_cast<size_t>(n) * 2 * sizeof(std::uint16_t);
+                    break;
+                default:
+                    return std::nullopt;
+            }
+            if (static_cast<size_t>(end - p) < bytes) {
+                return std::nullopt;
+            }
+            if (c.type == Type::Bitmap) {
+                c.words.resize(kBitmapWords);
+                std::memcpy(c.words.data(), p, bytes);
+            } else {
+                c.values.resize(bytes / sizeof(std::uint16_t));
+                std::memcpy(c.values.data(), p, bytes);
+                if (c.type == Type::Run) {
+                    for (size_t k = 1; k < c.values.size(); k += 2) {
+                        c.cardinality += static_cast<std::uint32_t>(c.values[k]) + 1;
+                    }
+                }
+            }
+            p += bytes;
+            bitmap.containers_.push_back(std::move(c));
+        }
+        return bitmap;
+    }
+} // namespace wiser
@@ -10,11 +10,14 @@
  */
 
 #include "wiser/search_engine.h"
+#include "wiser/analyzer.h"
+#include "wiser/postings_block.h"
 #include "wiser/wiser_environment.h"
 #include "wiser/tokenizer.h"
 #include "wiser/utils.h"
 #include <algorithm>
 #include <cmath>
+#include <optional>
 #include <unordered_map>
 #include <iostream>
 #include <set>
@@ -56,299 +59,379 @@ namespace wiser {
     SearchEngine::SearchEngine(WiserEnvironment* env)
         : env_(env) {}
 
-    /**
-     * @brief 获取倒排索引数据
-     * 
-     * 根据token ID列表从数据库和内存缓冲区获取倒排索引数据
-     * 包括文档列表、词频映射和位置映射
-     * 
-     * @param token_ids token ID列表
-     * @return QueryData 查询数据结构，包含所有token的倒排信息
-     */
-    SearchEngine::QueryData SearchEngine::fetchPostings(const std::vector<TokenId>& token_ids) const {
-        QueryData qd;
-        // 预分配空间以提高性能
-        qd.token_postings.reserve(token_ids.size());
-        qd.docs_counts.reserve(token_ids.size());
-        qd.token_tf_maps.reserve(token_ids.size());
-        qd.token_pos_maps.reserve(token_ids.size());
+    namespace {
+        using CursorList = std::vector<std::unique_ptr<PostingsCursor>>;
 
-        // 遍历所有token ID
-        for (TokenId token_id: token_ids) {
-            // 从数据库获取持久化的倒排索引记录
-            auto rec = env_->getDatabase().getPostings(token_id);
-            // 从内存缓冲区获取未持久化的倒排索引记录
-            auto mem_postings_list = env_->getIndexBuffer().getPostingsList(token_id);
-            
-            // 如果数据库中有该token的记录
-            if (rec.has_value()) {
-                // 反序列化倒排列表
-                PostingsList postings_list;
-                // 使用环境配置的压缩方式
-                postings_list.deserialize(rec->postings, env_->getConfig().compress_method);
-
-                // 提取文档ID列表与TF/位置映射（过滤无效ID）
-                std::vector<DocId> doc_ids;
-                std::unordered_map<DocId, Count> tf_map;
-                std::unordered_map<DocId, std::vector<Position>> pos_map;
-
-                // 先处理持久化的倒排索引
-                for (const auto& item: postings_list.getItems()) {
-                    DocId did = item->getDocumentId();
-                    if (did <= 0) {
-                        continue;  // 跳过无效文档ID
+        /**
+         * @brief 打分器：查询开始时计算各词元的 IDF，之后按游标当前位置逐文档打分
+         *
+         * 评分方法为模板参数，TF-IDF 与 BM25 各实例化一份，逐文档、逐词元的打分循环中没有方法判断。
+         * @tparam Method 评分方法
+         */
+        template <ScoringMethod Method>
+        class Scorer {
+        public:
+            Scorer(WiserEnvironment* env, const std::vector<Count>& docs_counts)
+                : env_(env) {
+                // 获取文档集合统计信息
+                const Count total_docs = env_->getDatabase().getDocumentCount();  // 总文档数
+                const long long total_tokens = env_->getTotalTokenCount();        // 总token数
+                avgdl_ = total_docs > 0 ? static_cast<double>(total_tokens) / static_cast<double>(total_docs) : 0.0;
+
+                // BM25算法的可调参数
+                k1_ = env_->getConfig().bm25_k1;  // BM25 k1参数，控制词频饱和度
+                b_ = env_->getConfig().bm25_b;    // BM25 b参数，控制文档长度归一化
+
+                // 计算每个查询词的IDF（逆文档频率）
+                idfs_.reserve(docs_counts.size());
+                for (auto df: docs_counts) {
+                    double idf = 0.0;
+                    if constexpr (Method == ScoringMethod::BM25) {
+                        // BM25 IDF公式: log( (N - df + 0.5) / (df + 0.5) + 1 )
+                        double numerator = static_cast<double>(total_docs) - static_cast<double>(df) + 0.5;
+                        double denominator = static_cast<double>(df) + 0.5;
+                        idf = std::log(numerator / denominator + 1.0);
+                    } else {
+                        // TF-IDF IDF公式 (标准): log( (N + 1) / (df + 1) ) + 1
+                        idf = std::log((1.0 + static_cast<double>(total_docs)) / (
+                                              1.0 + static_cast<double>(std::max<Count>(0, df)))) + 1.0;
                     }
-                    const auto& positions = item->getPositions();
-                    doc_ids.push_back(did);
-                    tf_map[did] = static_cast<Count>(positions.size());  // 记录词频
-                    pos_map[did] = positions; // 假定为升序
+                    // 确保IDF值为非负且有限
+                    if (idf < 0) idf = 0;
+                    if (!std::isfinite(idf)) idf = 0.0;
+                    idfs_.push_back(idf);
                 }
+            }
 
-                // 再合并内存缓冲区的倒排索引（若有）
-                if (mem_postings_list) {
-                    for (const auto& item: mem_postings_list->getItems()) {
-                        DocId did = item->getDocumentId();
-                        if (did <= 0) {
-                            continue;  // 跳过无效文档ID
-                        }
-                        const auto& positions = item->getPositions();
-                        if (!tf_map.contains(did)) {
-                            // 新文档 - 内存缓冲区中有但数据库中还没有
-                            doc_ids.push_back(did);
-                            tf_map[did] = static_cast<Count>(positions.size());
-                            pos_map[did] = positions; // 假定为升序
-                        } else {
-                            // 已有文档，合并词频和位置信息
-                            tf_map[did] += static_cast<Count>(positions.size());
-                            auto& existing_positions = pos_map[did];
-                            existing_positions.insert(existing_positions.end(), positions.begin(), positions.end());
-                            std::ranges::sort(existing_positions); // 保持升序
-                        }
+            /**
+             * @brief 计算文档得分（所有游标须位于 doc_id）
+             */
+            double score(DocId doc_id, const CursorList& cursors) const {
+                // 如果是BM25算法，需要获取文档长度
+                [[maybe_unused]] const int doc_len =
+                        Method == ScoringMethod::BM25 ? env_->getDocumentTokenCount(doc_id) : 0;
+                double score = 0.0;
+
+                // 遍历所有查询词，累加每个词的贡献分数
+                for (size_t i = 0; i < cursors.size(); ++i) {
+                    // 获取原始词频并确保非负
+                    const Count raw_tf = std::max<Count>(0, cursors[i]->tf());
+                    if (raw_tf == 0)
+                        continue;  // 词频为0，跳过
+
+                    if constexpr (Method == ScoringMethod::BM25) {
+                        // BM25算法：tf * (k1 + 1) / (tf + k1 * (1 - b + b * (doc_len / avgdl))) * idf
+                        double tf = static_cast<double>(raw_tf);
+                        double numerator = tf * (k1_ + 1.0);
+                        double denominator = tf + k1_ * (1.0 - b_ + b_ * (static_cast<double>(doc_len) / avgdl_));
+                        score += idfs_[i] * (numerator / denominator);
+                    } else {
+                        // TF-IDF算法：tf(1 + log(tf)) * idf
+                        double tf = 1.0 + std::log(static_cast<double>(raw_tf));
+                        score += tf * idfs_[i];
                     }
                 }
-                std::ranges::sort(doc_ids); // 显式排序，保证交集稳定
-
-                // 将处理好的数据添加到查询数据结构中
-                qd.token_postings.push_back(std::move(doc_ids));
-                qd.docs_counts.push_back(rec->docs_count);
-                qd.token_tf_maps.push_back(std::move(tf_map));
-                qd.token_pos_maps.push_back(std::move(pos_map));
-            } else {
-                // 数据库中没有该token的记录，添加空数据
-                qd.token_postings.emplace_back();
-                qd.docs_counts.push_back(0);
-                qd.token_tf_maps.emplace_back();
-                qd.token_pos_maps.emplace_back();
+                return score;
             }
-        }
-        return qd;
-    }
 
-    /**
-     * @brief 获取候选文档列表
-     * 
-     * 通过倒排列表交集运算获取包含所有查询词的候选文档
-     * 并过滤掉无效的文档ID
-     * 
-     * @param qd 查询数据结构，包含所有token的倒排信息
-     * @return std::vector<DocId> 候选文档ID列表
-     */
-    std::vector<DocId> SearchEngine::getCandidateDocs(const QueryData& qd) const {
-        // 对多个token的倒排列表进行交集运算，获取同时包含所有查询词的文档
-        std::vector<DocId> candidate_docs = intersectPostings(qd.token_postings);
-        
-        // 过滤掉无效的文档ID（小于等于0的ID）
-        candidate_docs.erase(std::ranges::remove_if(candidate_docs, [](DocId d) {
-                                 return d <= 0;  // 过滤无效文档ID
-                             }).begin(),
-                             candidate_docs.end());
-        
-        return candidate_docs;
-    }
+        private:
+            WiserEnvironment* env_;
+            double k1_ = 0.0;
+            double b_ = 0.0;
+            double avgdl_ = 0.0;
+            std::vector<double> idfs_;
+        };
 
-    /**
-     * @brief 通过短语匹配过滤候选文档
-     * 
-     * 对候选文档进行短语匹配过滤，只保留满足短语顺序要求的文档
-     * 使用双指针算法进行位置序列匹配
-     * 
-     * @param candidates 候选文档ID列表
-     * @param qd 查询数据结构，包含位置映射信息
-     * @param token_ids token ID列表
-     * @return std::vector<DocId> 通过短语匹配过滤后的文档ID列表
-     */
-    std::vector<DocId> SearchEngine::filterByPhrase(const std::vector<DocId>& candidates, const QueryData& qd, const std::vector<TokenId>& token_ids) const {
-        std::vector<DocId> result_docs;
-        const bool phrase_enabled = env_->isPhraseSearchEnabled();
-        
-        // 只有在启用短语搜索且查询词数量大于1时才进行短语匹配
-        if (phrase_enabled && token_ids.size() > 1) {
-            result_docs.reserve(candidates.size());
-            
-            // 遍历所有候选文档
-            for (DocId doc_id: candidates) {
-                bool ok = true;  // 标记当前文档是否满足短语匹配
-                
-                // 初始为第一个词的位置集合
-                std::vector<Position> current_positions; {
-                    auto it0 = qd.token_pos_maps[0].find(doc_id);
-                    if (it0 == qd.token_pos_maps[0].end()) {
-                        ok = false;  // 第一个词在文档中不存在
+        /**
+         * @brief 短语校验：各词元在当前文档中的位置须依次相邻（pos_{i+1} = pos_i + 1）
+         *
+         * 位置直接取自游标（按需解码），current/advanced 为调用方复用的暂存数组。
+         * @param cursors 各词元游标（按查询顺序，均位于同一文档）
+         * @return 存在完整的相邻位置链返回 true
+         */
+        bool matchPhrase(const CursorList& cursors, std::vector<Position>& current, std::vector<Position>& advanced) {
+            // 初始为第一个词的位置集合
+            auto first = cursors[0]->positions();
+            current.assign(first.begin(), first.end());
+
+            // 逐词推进：保留满足 pos_{i+1} = pos_i + 1 的位置链
+            for (size_t i = 1; i < cursors.size(); ++i) {
+                auto next_positions = cursors[i]->positions(); // 升序
+                advanced.clear();
+
+                // 双指针匹配算法：寻找满足 pos_{i+1} = pos_i + 1 的位置对
+                size_t p = 0, q = 0;
+                while (p < current.size() && q < next_positions.size()) {
+                    Position need = static_cast<Position>(current[p] + 1);  // 需要的位置 = 当前位置 + 1
+                    Position got = next_positions[q];  // 实际存在的位置
+
+                    if (got == need) {
+                        advanced.push_back(need);
+                        ++p;
+                        ++q;
+                    } else if (got < need) {
+                        ++q;
                     } else {
-                        current_positions = it0->second;  // 获取第一个词的所有位置
+                        ++p;
                     }
                 }
-                
-                // 逐词推进：保留满足 pos_{i+1} = pos_i + 1 的位置链
-                for (size_t i = 1; ok && i < token_ids.size(); ++i) {
-                    auto iti = qd.token_pos_maps[i].find(doc_id);
-                    if (iti == qd.token_pos_maps[i].end()) {
-                        ok = false;  // 当前词在文档中不存在
-                        break;
+
+                if (advanced.empty()) {
+                    // 没有找到任何匹配的位置对
+                    return false;
+                }
+                current.swap(advanced);  // 更新当前位置链
+            }
+            return true;
+        }
+
+        /**
+         * @brief 查询求值的游标与候选过滤条件（由 evaluateQuery 准备）
+         */
+        struct CandidatePlan {
+            CursorList& cursors;                         ///< 与查询词元一一对应的游标
+            std::optional<RoaringBitmap>& doc_filter;    ///< 位图词元的求交结果（无位图词元时为空）
+            const std::vector<size_t>& order;            ///< 参与游标求交的词元（按文档数升序）
+            bool phrase;                                 ///< 是否做短语校验
+        };
+
+        /**
+         * @brief 求交、短语校验与打分的内核（见 SearchEngine::evaluateQuery）
+         * @tparam Method 评分方法
+         * @param env 环境
+         * @param docs_counts 各词元的文档频率（用于 IDF）
+         * @param plan 游标与候选过滤条件
+         * @param candidate_count 输出包含所有查询词的文档数（短语校验前）
+         * @return 未排序的打分结果
+         */
+        template <ScoringMethod Method>
+        std::vector<SearchResultImpl> scoreCandidates(WiserEnvironment* env, const std::vector<Count>& docs_counts,
+                                                      CandidatePlan& plan, size_t& candidate_count) {
+            const Scorer<Method> scorer(env, docs_counts);
+            std::vector<SearchResultImpl> scored;
+            std::vector<Position> current, advanced; // 短语校验暂存
+            auto accept = [&](DocId target) {
+                // 过滤掉无效的文档ID（小于等于0的ID）
+                if (target <= 0) {
+                    return;
+                }
+                ++candidate_count;
+                for (auto& cursor: plan.cursors) {
+                    cursor->advance(target); // 位图词元的游标在此才定位；其余游标已位于 target
+                }
+                if (plan.phrase && !matchPhrase(plan.cursors, current, advanced)) {
+                    return;
+                }
+                scored.emplace_back(target, scorer.score(target, plan.cursors));
+            };
+
+            if (plan.order.empty()) {
+                // 全部为位图词元：求交结果即候选文档
+                plan.doc_filter->forEach([&](std::uint32_t doc_id) { accept(static_cast<DocId>(doc_id)); });
+            } else {
+                PostingsCursor& lead = *plan.cursors[plan.order[0]];
+                DocId target = lead.docId();
+                while (target != PostingsCursor::kEndDocId) {
+                    bool matched = true;
+                    for (size_t k = 1; k < plan.order.size(); ++k) {
+                        PostingsCursor& cursor = *plan.cursors[plan.order[k]];
+                        cursor.advance(target);
+                        if (cursor.docId() != target) {
+                            // 其他词元不含 target：驱动游标直接跳到该词元的下一个文档
+                            target = cursor.docId();
+                            matched = false;
+                            break;
+                        }
                     }
-                    const auto& next_positions_vec = iti->second; // 升序排列的位置向量
-
-                    std::vector<Position> advanced;
-                    advanced.reserve(current_positions.size());
-
-                    // 双指针匹配算法：寻找满足 pos_{i+1} = pos_i + 1 的位置对
-                    size_t p = 0, q = 0;
-                    while (p < current_positions.size() && q < next_positions_vec.size()) {
-                        Position need = static_cast<Position>(current_positions[p] + 1);  // 需要的位置 = 当前位置 + 1
-                        Position got = next_positions_vec[q];  // 实际存在的位置
-                        
-                        if (got == need) {
-                            // 找到匹配的位置对
-                            advanced.push_back(need);
-                            ++p;
-                            ++q;
-                        } else if (got < need) {
-                            // 实际位置小于需要的位置，移动右指针
-                            ++q;
-                        } else {
-                            // 实际位置大于需要的位置，移动左指针
-                            ++p;
+                    if (!matched) {
+                        if (target == PostingsCursor::kEndDocId) {
+                            break;
                         }
+                        lead.advance(target);
+                        target = lead.docId();
+                        continue;
                     }
 
-                    if (advanced.empty()) {
-                        // 没有找到任何匹配的位置对
-                        ok = false;
-                        break;
+                    if (!plan.doc_filter || plan.doc_filter->contains(static_cast<std::uint32_t>(target))) {
+                        accept(target);
                     }
-                    current_positions = std::move(advanced);  // 更新当前位置链
-                }
-                if (ok) {
-                    // 文档满足所有短语匹配条件
-                    result_docs.push_back(doc_id);
+                    lead.next();
+                    target = lead.docId();
                 }
             }
-        } else {
-            // 未启用短语搜索或查询词数量不足，返回所有候选文档
-            result_docs = candidates;
+
+            return scored;
         }
-        return result_docs;
-    }
+    } // anonymous namespace
 
     /**
-     * @brief 计算搜索结果评分
+     * @brief 获取倒排索引数据
      * 
-     * 根据BM25或TF-IDF算法计算搜索结果的评分
+     * 根据token ID列表从数据库（各索引段）和内存缓冲区获取倒排索引数据。
+     * 先只读取各词元倒排记录的汇总信息（文档数与文档 ID 区间），求出所有词元区间的交集作为候选区间：
+     * 结果文档必须同时出现在每个词元的倒排中，区间之外的段记录不会命中，不读取其 BLOB。
+     * 持久化倒排经 Database::collectPostings 取得原始字节的视图，不在此处解码，由 evaluateQuery 中的分块游标按需解码：
+     * 倒排文件段的记录直接指向映射内存（QueryData 持有文件段快照，查询期间段被合并删除也能读完），
+     * 只有 SQLite 中的记录被复制一次。
      * 
-     * @param result_docs 结果文档ID列表
-     * @param qd 查询数据结构
      * @param token_ids token ID列表
-     * @return std::vector<std::pair<DocId, double>> 文档ID和评分对的列表
+     * @return QueryData 查询数据结构，包含所有token的倒排来源
      */
-    std::vector<std::pair<DocId, double>> SearchEngine::calculateScores(const std::vector<DocId>& result_docs, const QueryData& qd, const std::vector<TokenId>& token_ids) const {
-
-        // 获取文档集合统计信息
-        Count total_docs = env_->getDatabase().getDocumentCount();  // 总文档数
-        long long total_tokens = env_->getTotalTokenCount();        // 总token数
-        double avgdl = total_docs > 0 ? static_cast<double>(total_tokens) / static_cast<double>(total_docs) : 0.0;  // 平均文档长度
-
-        // BM25算法的可调参数
-        const double k1 = env_->getConfig().bm25_k1;  // BM25 k1参数，控制词频饱和度
-        const double b = env_->getConfig().bm25_b;    // BM25 b参数，控制文档长度归一化
-
-        // 计算每个查询词的IDF（逆文档频率）
-        std::vector<double> idfs;
-        idfs.reserve(qd.docs_counts.size());
-        for (auto df: qd.docs_counts) {
-            double idf = 0.0;
-            if (env_->getConfig().scoring_method == ScoringMethod::BM25) {
-                // BM25 IDF公式: log( (N - df + 0.5) / (df + 0.5) + 1 )
-                double numerator = static_cast<double>(total_docs) - static_cast<double>(df) + 0.5;  // N - df + 0.5
-                double denominator = static_cast<double>(df) + 0.5;  // df + 0.5
-                idf = std::log(numerator / denominator + 1.0);  // log((N-df+0.5)/(df+0.5) + 1)
-            } else {
-                // TF-IDF IDF公式 (标准): log( (N + 1) / (df + 1) ) + 1
-                idf = std::log((1.0 + static_cast<double>(total_docs)) / (
-                                      1.0 + static_cast<double>(std::max<Count>(0, df)))) + 1.0;
+    SearchEngine::QueryData SearchEngine::fetchPostings(const std::vector<TokenId>& token_ids) const {
+        QueryData qd;
+        // 预分配空间以提高性能
+        qd.docs_counts.reserve(token_ids.size());
+        qd.disk_postings.reserve(token_ids.size());
+        qd.mem_postings.reserve(token_ids.size());
+
+        // 第一遍：文档频率、内存缓冲区倒排与候选区间
+        DocId min_doc = kMinDocId;
+        DocId max_doc = kMaxDocId;
+        for (TokenId token_id: token_ids) {
+            auto stats = env_->getDatabase().getPostingsStats(token_id);
+            // 从内存缓冲区获取未持久化的倒排索引记录（新词元在刷新前只存在于内存中）
+            const PostingsList* mem_postings_list = env_->getIndexBuffer().getPostingsList(token_id);
+            if (mem_postings_list && mem_postings_list->empty()) {
+                mem_postings_list = nullptr;
             }
-            // 确保IDF值为非负且有限
-            if (idf < 0) idf = 0;
-            if (!std::isfinite(idf)) idf = 0.0;
-            idfs.push_back(idf);
-        }
 
-        // 准备存储评分结果的向量
-        std::vector<SearchResultImpl> scored;
-        scored.reserve(result_docs.size());
+            // 该词元所有来源的文档区间
+            DocId first_doc = kMaxDocId;
+            DocId last_doc = kMinDocId;
+            if (stats) {
+                first_doc = stats->first_doc;
+                last_doc = stats->last_doc;
+            }
+            if (mem_postings_list) {
+                first_doc = std::min(first_doc, mem_postings_list->getDocumentIds().front());
+                last_doc = std::max(last_doc, mem_postings_list->getDocumentIds().back());
+            }
+            min_doc = std::max(min_doc, first_doc);
+            max_doc = std::min(max_doc, last_doc);
 
-        // 准备循环常量：确定使用BM25还是TF-IDF算法
-        const bool use_bm25 = (env_->getConfig().scoring_method == ScoringMethod::BM25);
+            qd.docs_counts.push_back(stats ? stats->docs_count : 0);
+            qd.mem_postings.push_back(mem_postings_list);
+        }
 
-        // 遍历所有结果文档，计算每个文档的评分
-        for (auto doc_id: result_docs) {
-            int doc_len = 0;      // 文档长度（token数量）
-            double score = 0.0;   // 文档总评分
+        // 第二遍：只取回与候选区间相交的持久化倒排记录（每个索引段至多一条）
+        for (TokenId token_id: token_ids) {
+            auto& disk = qd.disk_postings.emplace_back();
+            if (min_doc > max_doc) {
+                continue;
+            }
+            env_->getDatabase().collectPostings(token_id, disk, qd.snapshot, min_doc, max_doc);
+        }
+        return qd;
+    }
 
-            // 如果是BM25算法，需要获取文档长度
-            if (use_bm25) {
-                doc_len = env_->getDocumentTokenCount(doc_id); // Only needed for BM25
+    /**
+     * @brief 为每个查询词元打开游标
+     *
+     * 每个索引段中的持久化倒排使用分块游标，内存缓冲区倒排使用内存游标，多个来源时逐个取有序并集。
+     *
+     * @param qd 查询数据结构（游标引用其中的数据，须在游标生命周期内有效）
+     * @return 与查询词元一一对应的游标
+     */
+    std::vector<std::unique_ptr<PostingsCursor>> SearchEngine::openCursors(const QueryData& qd) const {
+        const CompressMethod method = env_->getConfig().compress_method;
+        std::vector<std::unique_ptr<PostingsCursor>> cursors;
+        cursors.reserve(qd.disk_postings.size());
+        for (size_t i = 0; i < qd.disk_postings.size(); ++i) {
+            std::unique_ptr<PostingsCursor> cursor;
+            auto add = [&cursor](std::unique_ptr<PostingsCursor> source) {
+                cursor = cursor ? std::make_unique<UnionPostingsCursor>(std::move(cursor), std::move(source))
+                                : std::move(source);
+            };
+            for (const auto& postings: qd.disk_postings[i]) {
+                add(std::make_unique<BlockPostingsCursor>(postings, method));
+            }
+            if (qd.mem_postings[i]) {
+                add(std::make_unique<MemoryPostingsCursor>(*qd.mem_postings[i]));
+            }
+            if (!cursor) {
+                // 词元没有任何倒排：空游标
+                cursor = std::make_unique<BlockPostingsCursor>(nullptr, 0, method);
             }
+            cursors.push_back(std::move(cursor));
+        }
+        return cursors;
+    }
 
-            // 遍历所有查询词，累加每个词的贡献分数
-            for (size_t i = 0; i < token_ids.size(); ++i) {
-                // 查找当前文档在当前查询词中的词频
-                auto it = qd.token_tf_maps[i].find(doc_id);
-                if (it == qd.token_tf_maps[i].end())
-                    continue;  // 文档不包含当前查询词，跳过
-                
-                // 获取原始词频并确保非负
-                Count raw_tf = std::max<Count>(0, it->second);
-                if (raw_tf == 0)
-                    continue;  // 词频为0，跳过
-
-                // 根据算法类型计算当前查询词的分数贡献
-                if (use_bm25) {
-                    // BM25算法：tf * (k1 + 1) / (tf + k1 * (1 - b + b * (doc_len / avgdl))) * idf
-                    double tf = static_cast<double>(raw_tf);  // 转换为浮点数
-                    double numerator = tf * (k1 + 1.0);       // 分子部分：tf * (k1 + 1)
-                    double denominator = tf + k1 * (1.0 - b + b * (static_cast<double>(doc_len) / avgdl));  // 分母部分
-                    score += idfs[i] * (numerator / denominator);  // 累加当前词的BM25分数
-                } else {
-                    // TF-IDF算法：tf(1 + log(tf)) * idf
-                    double tf = 1.0 + std::log(static_cast<double>(raw_tf));  // 对数词频
-                    score += tf * idfs[i];  // 累加当前词的TF-IDF分数
-                }
+    /**
+     * @brief 按文档逐个求值：求交、短语校验与打分一次完成
+     *
+     * 附带文档位图的高频词元先按位图求交（位图容器按 64 位字 AND），结果作为过滤集合；
+     * 其余词元以文档数最少者驱动，其余游标用 advance 跳到目标文档（跳表定位，整块跳过不解码）。
+     * 每个同时包含所有查询词的文档当场做短语校验（仅启用短语搜索且词元数大于 1 时解码位置）并打分，
+     * 不物化倒排列表或逐文档的 tf/位置映射，内存只与词元数和结果数有关。
+     * 求交与打分循环按评分方法实例化（见 scoreCandidates），每次查询只按配置选取一次。
+     *
+     * @param qd 查询数据结构，包含所有token的倒排来源
+     * @param candidate_count 输出包含所有查询词的文档数（短语校验前）
+     * @return 按分数降序（同分按文档 ID 升序）的 (doc_id, score) 列表
+     */
+    std::vector<std::pair<DocId, double>> SearchEngine::evaluateQuery(const QueryData& qd,
+                                                                     size_t& candidate_count) const {
+        candidate_count = 0;
+        const size_t n = qd.disk_postings.size();
+        if (n == 0) {
+            return {};
+        }
+
+        const bool phrase = env_->isPhraseSearchEnabled() && n > 1;
+        CursorList cursors = openCursors(qd);
+
+        // 高文档频率词元（只在一个段中、附带文档位图且无内存缓冲数据）先按位图求交，得到候选过滤集合；
+        // 其余词元参与游标跳跃求交
+        std::optional<RoaringBitmap> doc_filter;
+        std::vector<size_t> order;
+        order.reserve(n);
+        for (size_t i = 0; i < n; ++i) {
+            std::optional<RoaringBitmap> bitmap;
+            if (!qd.mem_postings[i] && qd.disk_postings[i].size() == 1) {
+                bitmap = readDocBitmap(qd.disk_postings[i][0]);
+            }
+            if (!bitmap) {
+                order.push_back(i);
+            } else if (doc_filter) {
+                doc_filter->intersectWith(*bitmap);
+            } else {
+                doc_filter = std::move(bitmap);
             }
-            // 将文档ID和评分存入结果向量
-            scored.emplace_back(doc_id, score);
         }
-        
+        if (doc_filter && doc_filter->empty()) {
+            return {};
+        }
+
+        // 按文档数升序排列，最稀有的词元作为驱动
+        std::ranges::stable_sort(order, [&](size_t a, size_t b) {
+            return cursors[a]->size() < cursors[b]->size();
+        });
+
+        // 按评分方法选取编译期特化的求值内核（每次查询选取一次）。
+        // 评分方法可能来自设置表中的任意整数，未知值与 TF_IDF 一样按 TF-IDF 打分
+        CandidatePlan plan{ cursors, doc_filter, order, phrase };
+        std::vector<SearchResultImpl> scored;
+        switch (env_->getConfig().scoring_method) {
+            case ScoringMethod::BM25:
+                scored = scoreCandidates<ScoringMethod::BM25>(env_, qd.docs_counts, plan, candidate_count);
+                break;
+            case ScoringMethod::TF_IDF:
+            default:
+                scored = scoreCandidates<ScoringMethod::TF_IDF>(env_, qd.docs_counts, plan, candidate_count);
+                break;
+        }
+
         // 对搜索结果按评分降序排序，评分相同的按文档ID升序排序
         std::ranges::sort(scored, [](const SearchResultImpl& a, const SearchResultImpl& b) {
             return a.score == b.score ? a.document_id < b.document_id : a.score > b.score;
         });
-        
+
         // 转换为最终的显示格式（文档ID和评分对）
         std::vector<std::pair<DocId, double>> display;
         display.reserve(scored.size());
         for (const auto& r: scored)
             display.emplace_back(r.document_id, r.score);
-        
         return display;
     }
 
@@ -375,13 +458,18 @@ namespace wiser {
             // 获取token对应的字符串表示
             std::string token_str = env_->getDatabase().getToken(token_id);
 
-            // 获取持久化倒排索引信息（磁盘）
-            auto rec = env_->getDatabase().getPostings(token_id);
-            Count disk_docs_cnt = rec ? rec->docs_count : 0;  // 磁盘中的文档数量
+            // 获取持久化倒排索引信息（磁盘，各索引段），直接从 BLOB 内存解码，不拷贝
+            Count disk_docs_cnt = 0;  // 磁盘中的文档数量
+            PostingsList pl, segment_pl;
+            env_->getDatabase().visitPostings(token_id, [&](Count docs_count, std::span<const char> postings) {
+                disk_docs_cnt += docs_count;
+                segment_pl.deserialize(postings.data(), postings.size(), env_->getConfig().compress_method);
+                pl.merge(std::move(segment_pl));  // 各段按文档 ID 归并
+            });
 
             // 获取内存缓存倒排索引信息
             auto mem_postings_list = env_->getIndexBuffer().getPostingsList(token_id);
-            size_t mem_docs_cnt = (mem_postings_list ? mem_postings_list->getItems().size() : 0);  // 内存中的文档数量
+            size_t mem_docs_cnt = (mem_postings_list ? static_cast<size_t>(mem_postings_list->getDocumentsCount()) : 0);  // 内存中的文档数量
 
             // 打印token基本信息
             if (mem_docs_cnt > 0) {
@@ -392,14 +480,10 @@ namespace wiser {
             }
 
             // 打印持久化倒排索引的详细信息
-            if (rec && !rec->postings.empty()) {
-                // 反序列化倒排列表
-                PostingsList pl;
-                pl.deserialize(rec->postings);
-                
+            if (!pl.empty()) {
                 // 遍历所有文档项
-                for (const auto& item: pl.getItems()) {
-                    const auto& pos = item->getPositions();
+                for (size_t d = 0; d < static_cast<size_t>(pl.getDocumentsCount()); ++d) {
+                    auto pos = pl.getPositions(d);
                     std::string pos_line;
                     pos_line.reserve(pos.size() * 4);  // 预分配空间
                     
@@ -411,7 +495,7 @@ namespace wiser {
                     }
                     
                     // 打印磁盘倒排索引项
-                    spdlog::debug("      [disk] doc={} positions=[{}]", item->getDocumentId(), pos_line);
+                    spdlog::debug("      [disk] doc={} positions=[{}]", pl.getDocumentId(d), pos_line);
                 }
             } else {
                 // 磁盘中没有该token的倒排索引
@@ -419,10 +503,10 @@ namespace wiser {
             }
 
             // 打印内存缓存倒排索引的详细信息
-            if (mem_postings_list && !mem_postings_list->getItems().empty()) {
+            if (mem_postings_list && !mem_postings_list->empty()) {
                 // 遍历内存中的所有文档项
-                for (const auto& mem_item: mem_postings_list->getItems()) {
-                    const auto& pos = mem_item->getPositions();
+                for (size_t d = 0; d < static_cast<size_t>(mem_postings_list->getDocumentsCount()); ++d) {
+                    auto pos = mem_postings_list->getPositions(d);
                     std::string pos_line;
                     pos_line.reserve(pos.size() * 4);  // 预分配空间
                     
@@ -434,7 +518,7 @@ namespace wiser {
                     }
                     
                     // 打印内存倒排索引项
-                    spdlog::debug("      [mem ] doc={} positions=[{}]", mem_item->getDocumentId(), pos_line);
+                    spdlog::debug("      [mem ] doc={} positions=[{}]", mem_postings_list->getDocumentId(d), pos_line);
                 }
             } else {
                 // 内存中没有该token的倒排索引
@@ -481,73 +565,39 @@ namespace wiser {
             return display;
         }
 
-        // 2) 为每个词元提取倒排与辅助映射
+        // 2) 为每个词元取回倒排来源（持久化原始字节 + 内存缓冲区）
         QueryData qd = fetchPostings(token_ids);
         const auto t2 = high_resolution_clock::now();  // 获取倒排索引完成时间
 
-        // 3) 求交集，获取候选文档
-        std::vector<DocId> candidate_docs = getCandidateDocs(qd);
-        const auto t3 = high_resolution_clock::now();  // 候选文档筛选完成时间
-        
-        // 如果没有候选文档，记录日志并返回空结果
-        if (candidate_docs.empty()) {
-            auto tokenize_us = duration_cast<microseconds>(t1 - t0).count();
-            auto postings_us = duration_cast<microseconds>(t2 - t1).count();
-            auto intersect_us = duration_cast<microseconds>(t3 - t2).count();
-            double total_ms = static_cast<double>(tokenize_us + postings_us + intersect_us) / 1000.0;
-            spdlog::info(
-                         "search_log | query=\"{}\" | tokens={} | phrase={} | result_count=0 | reason=no_candidates | time_ms={:.3f} | breakdown={{tokenize:{}us,postings:{}us,intersect:{}us}}",
-                         query,
-                         token_ids.size(),
-                         env_->isPhraseSearchEnabled(),
-                         total_ms,
-                         tokenize_us,
-                         postings_us,
-                         intersect_us
-                        );
-            return {};
-        }
-        
-        // 4) 若启用短语搜索，做位置相邻校验
-        std::vector<DocId> result_docs = filterByPhrase(candidate_docs, qd, token_ids);
-        const auto t4 = high_resolution_clock::now();  // 短语匹配过滤完成时间
-        
-        // 如果短语过滤后没有结果，记录日志并返回空结果
-        if (result_docs.empty()) {
-            auto tokenize_us = duration_cast<microseconds>(t1 - t0).count();
-            auto postings_us = duration_cast<microseconds>(t2 - t1).count();
-            auto intersect_us = duration_cast<microseconds>(t3 - t2).count();
-            auto phrase_us = duration_cast<microseconds>(t4 - t3).count();
-            double total_ms = static_cast<double>(tokenize_us + postings_us + intersect_us + phrase_us) / 1000.0;
+        // 3) 按文档逐个求交、短语校验（若启用）并打分
+        size_t candidate_count = 0;
+        std::vector<std::pair<DocId, double>> display = evaluateQuery(qd, candidate_count);
+        const auto t3 = high_resolution_clock::now();  // 求值完成时间
+
+        // 计算各阶段耗时（微秒）
+        const auto tokenize_us = duration_cast<microseconds>(t1 - t0).count();
+        const auto postings_us = duration_cast<microseconds>(t2 - t1).count();
+        const auto evaluate_us = duration_cast<microseconds>(t3 - t2).count();
+        const double total_ms = static_cast<double>(duration_cast<microseconds>(t3 - t0).count()) / 1000.0;
+
+        // 没有结果：区分无候选文档与被短语校验全部过滤
+        if (display.empty()) {
             spdlog::info(
-                         "search_log | query=\"{}\" | tokens={} | phrase={} | result_count=0 | reason=phrase_filter | time_ms={:.3f} | breakdown={{tokenize:{}us,postings:{}us,intersect:{}us,phrase:{}us}}",
+                         "search_log | query=\"{}\" | tokens={} | phrase={} | result_count=0 | reason={} | time_ms={:.3f} | breakdown={{tokenize:{}us,postings:{}us,evaluate:{}us}}",
                          query,
                          token_ids.size(),
                          env_->isPhraseSearchEnabled(),
+                         candidate_count == 0 ? "no_candidates" : "phrase_filter",
                          total_ms,
                          tokenize_us,
                          postings_us,
-                         intersect_us,
-                         phrase_us
+                         evaluate_us
                         );
             return {};
         }
 
-        // 5) 计算得分
-        std::vector<std::pair<DocId, double>> display = calculateScores(result_docs, qd, token_ids);
-        const auto t5 = high_resolution_clock::now();  // 评分计算完成时间
-
         // ---- 汇总日志（精细耗时） ----
         {
-            // 计算各阶段耗时（微秒）
-            auto tokenize_us = duration_cast<microseconds>(t1 - t0).count();
-            auto postings_us = duration_cast<microseconds>(t2 - t1).count();
-            auto intersect_us = duration_cast<microseconds>(t3 - t2).count();
-            auto phrase_us = duration_cast<microseconds>(t4 - t3).count();
-            auto score_us = duration_cast<microseconds>(t5 - t4).count();
-            auto total_us = duration_cast<microseconds>(t5 - t0).count();
-            double total_ms = static_cast<double>(total_us) / 1000.0;
-            
             // 构建token ID列表字符串
             std::string token_line;
             token_line.reserve(token_ids.size() * 6);
@@ -569,7 +619,7 @@ namespace wiser {
             
             // 记录完整的搜索日志
             spdlog::info(
-                         "search_log | query=\"{}\" | tokens={} [{}] | phrase={} | result_count={} | top=[{}] | time_ms={:.3f} | breakdown={{tokenize:{}us,postings:{}us,intersect:{}us,phrase:{}us,score:{}us}}",
+                         "search_log | query=\"{}\" | tokens={} [{}] | phrase={} | result_count={} | top=[{}] | time_ms={:.3f} | breakdown={{tokenize:{}us,postings:{}us,evaluate:{}us}}",
                          query,
                          token_ids.size(),
                          token_line,
@@ -579,9 +629,7 @@ namespace wiser {
                          total_ms,
                          tokenize_us,
                          postings_us,
-                         intersect_us,
-                         phrase_us,
-                         score_us
+                         evaluate_us
                         );
         }
         return display;
@@ -757,80 +805,29 @@ namespace wiser {
 
     std::vector<TokenId> SearchEngine::getTokenIds(std::string_view query) const {
         std::vector<TokenId> token_ids;
-
-        // 转换为UTF-32
-        std::string q{ query };
-        auto utf32_query = Utils::utf8ToUtf32(q);
-
-        // 分解为N-gram
-        size_t pos = 0;
         const std::int32_t n = env_->getTokenLength();
-
-        while (pos < utf32_query.size()) {
-            // 跳过忽略字符
-            while (pos < utf32_query.size() && Utils::isIgnoredChar(utf32_query[pos])) {
-                ++pos;
-            }
-            if (pos >= utf32_query.size())
-                break;
-
-            // 收集最多n个非忽略字符
-            size_t start = pos;
-            size_t count = 0;
-            while (pos < utf32_query.size() && count < static_cast<size_t>(n) && !
-                   Utils::isIgnoredChar(utf32_query[pos])) {
-                ++pos;
-                ++count;
-            }
-
-            if (count >= static_cast<size_t>(n)) {
-                std::vector<UTF32Char> token_chars(utf32_query.begin() + start,
-                                                   utf32_query.begin() + start + n);
-                std::string token = Utils::utf32ToUtf8(token_chars);
-
-                // 查询侧统一小写（ASCII）
-                for (auto& ch: token) {
-                    unsigned char uch = static_cast<unsigned char>(ch);
-                    if (uch < 128)
-                        ch = static_cast<char>(std::tolower(uch));
-                }
-
-                auto info = env_->getDatabase().getTokenInfo(token, false);
-                if (info.has_value() && info->id > 0) {
-                    token_ids.push_back(info->id);
-                }
-            }
-
-            // 滑动一个字符
-            pos = start + 1;
+        if (n <= 0) {
+            return token_ids;
         }
 
-        return token_ids;
-    }
+        // 与建索引时相同的分析器切分查询（已做 ASCII 小写化），直接从 UTF-8 解码
+        Utf8Source source(query);
+        std::vector<UTF32Char> window, word;
+        std::string token;
+        forEachTerm(env_->getAnalyzer(), static_cast<size_t>(n), source, window, word,
+                    [&](std::span<const UTF32Char> term) {
+                        token.clear();
+                        for (UTF32Char ch: term) {
+                            Utils::appendUtf8(token, ch);
+                        }
+                        // 词元字典在初始化时已由 tokens 表预热，且包含尚未 flush 的新词元
+                        auto token_id = env_->getTokenDictionary().find(token);
+                        if (token_id.has_value()) {
+                            token_ids.push_back(*token_id);
+                        }
+                    });
 
-    std::vector<DocId> SearchEngine::intersectPostings(const std::vector<std::vector<DocId>>& postings_lists) {
-        if (postings_lists.empty()) {
-            return {};
-        }
-        if (postings_lists.size() == 1) {
-            return postings_lists[0];
-        }
-        auto min_it = std::ranges::min_element(postings_lists,
-                                               [](const auto& a, const auto& b) {
-                                                   return a.size() < b.size();
-                                               });
-        std::vector<DocId> result = *min_it;
-        for (const auto& postings_list: postings_lists) {
-            if (&postings_list == &(*min_it))
-                continue;
-            std::vector<DocId> intersection;
-            std::ranges::set_intersection(result, postings_list,
-                                          std::back_inserter(intersection));
-            result = std::move(intersection);
-            if (result.empty())
-                break;
-        }
-        return result;
+        return token_ids;
     }
 
     void SearchEngine::displayResults(const std::vector<std::pair<DocId, double>>& results) const {
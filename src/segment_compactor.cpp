@@ -0,0 +1,281 @@
+/**
+ * @file segment_compactor.cpp
+ * @brief 索引段分层合并实现
+ */
+
+#include "wiser/segment_compactor.h"
+#include "wiser/wiser_environment.h"
+#include "wiser/postings_block.h"
+#include "wiser/postings_file.h"
+#include <algorithm>
+#include <iterator>
+#include <spdlog/spdlog.h>
+
+namespace wiser {
+    namespace {
+        /**
+         * @brief 一个词元在某个被合并段中的倒排（从 BLOB 拷贝，读语句随即重置）
+         */
+        struct SegmentPart {
+            Count docs_count = 0;
+            DocId first_doc = 0;
+            DocId last_doc = 0;
+            std::vector<char> postings;
+        };
+
+        std::int64_t tierSize(const SegmentInfo& segment) {
+            return std::max(segment.size, kCompactionMinSegmentSize);
+        }
+
+        /**
+         * @brief 合并一个词元在若干段中的倒排
+         *
+         * 只出现在一个段中时原样复制；按首个文档排序后各段的文档区间互不重叠（顺序导入的常见情况）时，
+         * 保留首段的编码并依次追加其余段（见 appendBlockedPostings）；否则解码后按文档 ID 归并再重新编码。
+         * @param parts 各段中的倒排（可能被重排或移走）
+         * @param method 压缩方法
+         * @param total_docs 总文档数（判断是否附带文档位图）
+         * @param docs_count 输出合并后的文档数
+         * @return 合并后的序列化倒排
+         */
+        std::vector<char> mergePostings(std::vector<SegmentPart>& parts, CompressMethod method, Count total_docs,
+                                        Count& docs_count) {
+            if (parts.size() > 1) {
+                std::ranges::sort(parts, {}, &SegmentPart::first_doc);
+            }
+            docs_count = parts[0].docs_count;
+            if (parts.size() == 1) {
+                return std::move(parts[0].postings);
+            }
+
+            std::vector<char> merged = std::move(parts[0].postings);
+            PostingsList tail;
+            size_t next = 1;
+            for (; next < parts.size(); ++next) {
+                tail.deserialize(parts[next].postings.data(), parts[next].postings.size(), method);
+                const Count next_count = docs_count + tail.getDocumentsCount();
+                auto appended = appendBlockedPostings(merged.data(), merged.size(), tail, method,
+                                                      useDocBitmap(next_count, total_docs));
+                if (!appended) {
+                    break;
+                }
+                merged = std::move(*appended);
+                docs_count = next_count;
+            }
+            if (next == parts.size()) {
+                return merged;
+            }
+
+            // 其余段与已合并部分的文档区间重叠，或编码需要变化：整体解码后按文档 ID 归并（tail 已是第 next 段）
+            PostingsList list;
+            list.deserialize(merged.data(), merged.size(), method);
+            list.merge(std::move(tail));
+            for (size_t i = next + 1; i < parts.size(); ++i) {
+                tail.deserialize(parts[i].postings.data(), parts[i].postings.size(), method);
+                list.merge(std::move(tail));
+            }
+            docs_count = list.getDocumentsCount();
+            return list.serialize(method, useDocBitmap(docs_count, total_docs));
+        }
+    } // anonymous namespace
+
+    std::vector<SegmentId> pickSegmentsToMerge(std::vector<SegmentInfo> segments) {
+        if (segments.size() < kCompactionMinSegments) {
+            return {};
+        }
+        // 同体积时保持段 ID 顺序，使较早的段先被合并
+        std::ranges::stable_sort(segments, {}, tierSize);
+        for (size_t first = 0; first + kCompactionMinSegments <= segments.size(); ++first) {
+            const double limit = static_cast<double>(tierSize(segments[first])) * kCompactionSizeRatio;
+            size_t last = first;
+            while (last < segments.size() && last - first < kCompactionMaxSegments &&
+                   static_cast<double>(tierSize(segments[last])) <= limit) {
+                ++last;
+            }
+            if (last - first >= kCompactionMinSegments) {
+                std::vector<SegmentId> ids;
+                ids.reserve(last - first);
+                for (size_t i = first; i < last; ++i) {
+                    ids.push_back(segments[i].id);
+                }
+                return ids;
+            }
+        }
+        return {};
+    }
+
+    SegmentCompactor::SegmentCompactor(WiserEnvironment* env)
+        : env_(env) {}
+
+    SegmentCompactor::~SegmentCompactor() {
+        stop();
+    }
+
+    void SegmentCompactor::start() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (thread_.joinable()) {
+            return;
+        }
+        stopping_ = false;
+        pending_ = true; // 启动时先检查上次运行遗留的段
+        thread_ = std::thread(&SegmentCompactor::run, this);
+    }
+
+    void SegmentCompactor::stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        cond_.notify_all();
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+    void SegmentCompactor::notify() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            pending_ = true;
+        }
+        cond_.notify_one();
+    }
+
+    bool SegmentCompactor::stopRequested() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return stopping_;
+    }
+
+    void SegmentCompactor::run() {
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cond_.wait(lock, [this] { return stopping_ || pending_; });
+                if (stopping_) {
+                    return;
+                }
+                pending_ = false;
+            }
+            // 一轮合并产生的新段可能又凑齐了更高一层
+            while (compactOnce()) {
+            }
+        }
+    }
+
+    bool SegmentCompactor::compactOnce() {
+        if (stopRequested()) {
+            return false;
+        }
+        // 在写锁内读取段表：刷新在同一连接上、提交前发布新段，锁外可能读到随后被回滚的段
+        std::vector<SegmentInfo> segments;
+        {
+            std::lock_guard<std::mutex> lock(env_->getIndexWriteMutex());
+            segments = env_->getDatabase().getSegments();
+        }
+        auto inputs = pickSegmentsToMerge(std::move(segments));
+        if (inputs.empty()) {
+            return false;
+        }
+        return mergeSegments(inputs);
+    }
+
+    bool SegmentCompactor::mergeSegments(const std::vector<SegmentId>& inputs) {
+        Database& database = env_->getDatabase();
+        std::mutex& write_mutex = env_->getIndexWriteMutex();
+
+        // 被合并段中出现的全部词元（各段内升序，逐段归并去重）
+        std::vector<TokenId> tokens;
+        for (SegmentId id: inputs) {
+            auto segment_tokens = database.getSegmentTokens(id);
+            std::vector<TokenId> merged;
+            merged.reserve(tokens.size() + segment_tokens.size());
+            std::ranges::set_union(tokens, segment_tokens, std::back_inserter(merged));
+            tokens = std::move(merged);
+        }
+
+        std::optional<SegmentId> segment_id;
+        {
+            std::lock_guard<std::mutex> lock(write_mutex);
+            segment_id = database.createSegment();
+        }
+        if (!segment_id) {
+            return false;
+        }
+        auto abandon = [&]() {
+            std::lock_guard<std::mutex> lock(write_mutex);
+            database.dropSegment(*segment_id);
+        };
+
+        const CompressMethod method = env_->getCompressMethod();
+        const Count total_docs = database.getDocumentCount();
+        std::int64_t size = 0;
+        std::vector<SegmentPart> parts;
+        std::vector<SegmentPostingsRecord> batch;
+        batch.reserve(kCompactionBatchTokens);
+
+        // 写成倒排文件时不经过数据库，也不需要写锁：文件在发布前对查询不可见
+        const bool to_file = env_->isMmapPostingsEnabled();
+        PostingsFileWriter file_writer;
+        if (to_file && !file_writer.open(database.segmentFilePath(*segment_id))) {
+            abandon();
+            return false;
+        }
+        auto write_batch = [&]() {
+            bool ok = true;
+            if (to_file) {
+                for (const auto& record: batch) {
+                    ok = ok && file_writer.add(record);
+                }
+            } else {
+                std::lock_guard<std::mutex> lock(write_mutex);
+                ok = database.addSegmentPostingsBatch(*segment_id, batch);
+            }
+            batch.clear();
+            return ok;
+        };
+
+        for (TokenId token_id: tokens) {
+            parts.clear();
+            database.visitSegmentPostings(token_id, [&](SegmentId id, Count docs_count, DocId first_doc,
+                                                        DocId last_doc, std::span<const char> postings) {
+                if (std::ranges::find(inputs, id) == inputs.end()) {
+                    return;
+                }
+                parts.push_back(SegmentPart{ docs_count, first_doc, last_doc,
+                                             std::vector<char>(postings.begin(), postings.end()) });
+            });
+            if (parts.empty()) {
+                continue;
+            }
+
+            // 合并后的文档区间覆盖各段的区间
+            const DocId first_doc = std::ranges::min(parts, {}, &SegmentPart::first_doc).first_doc;
+            const DocId last_doc = std::ranges::max(parts, {}, &SegmentPart::last_doc).last_doc;
+            SegmentPostingsRecord record{ token_id, 0, first_doc, last_doc, {} };
+            record.postings = mergePostings(parts, method, total_docs, record.docs_count);
+            size += static_cast<std::int64_t>(record.postings.size());
+            batch.push_back(std::move(record));
+
+            if (batch.size() >= kCompactionBatchTokens) {
+                if (stopRequested() || !write_batch()) {
+                    abandon();
+                    return false;
+                }
+            }
+        }
+        if (stopRequested() || (!batch.empty() && !write_batch()) || (to_file && !file_writer.finish())) {
+            abandon();
+            return false;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(write_mutex);
+            if (!database.replaceSegments(*segment_id, size, inputs, to_file)) {
+                database.dropSegment(*segment_id);
+                return false;
+            }
+        }
+        spdlog::debug("Merged {} segment(s) into {}segment {} ({} token(s), {} bytes).", inputs.size(),
+                      to_file ? "postings file " : "", *segment_id, tokens.size(), size);
+        return true;
+    }
+} // namespace wiser
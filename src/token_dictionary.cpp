@@ -0,0 +1,300 @@
+/**
+ * @file token_dictionary.cpp
+ * @brief 词元字典实现：线性探测开放寻址哈希 + 连续 arena 存储词元字节
+ *
+ * 说明：
+ * - 查找先探测哈希表（启动后新增的词元），未命中时经 Bloom 过滤器判断后才查前缀压缩字典（预热的词元）；
+ * - 槽位数组容量始终为 2 的幂，装载因子超过 0.7 时扩容一倍并重新散列；
+ * - 槽位中缓存完整 64 位哈希，探测时先比哈希再比字节，绝大多数未命中无需访问 arena；
+ * - 打包键缓存同样是线性探测的开放寻址表，只缓存已解析过的键，预热的词元在首次出现时才进入缓存；
+ * - ID 分配沿用 SQLite INTEGER PRIMARY KEY 的规则（当前最大 ID + 1），写库时显式指定 ID。
+ */
+
+#include "wiser/token_dictionary.h"
+#include "wiser/utils.h"
+#include <algorithm>
+#include <functional>
+#include <mutex>
+
+namespace wiser {
+    namespace {
+        constexpr size_t kInitialCapacity = 1024;
+
+        std::uint64_t mixPackedKey(std::uint64_t key) {
+            // 64 位终结混合（murmur3 fmix64），打包键的低位分布不均
+            key ^= key >> 33;
+            key *= 0xff51afd7ed558ccdULL;
+            key ^= key >> 33;
+            return key;
+        }
+    }
+
+    std::string unpackToken(std::uint64_t key) {
+        std::string token;
+        for (size_t i = kMaxPackedTokenLength; i-- > 0;) {
+            const auto value = static_cast<UTF32Char>((key >> (i * kPackedCodePointBits)) &
+                                                      ((1u << kPackedCodePointBits) - 1));
+            if (value == 0) {
+                continue;
+            }
+            Utils::appendUtf8(token, value - 1);
+        }
+        return token;
+    }
+
+    TokenDictionary::TokenDictionary()
+        : slots_(kInitialCapacity), packed_slots_(kInitialCapacity) {}
+
+    std::uint64_t TokenDictionary::hashToken(std::string_view token) {
+        return static_cast<std::uint64_t>(std::hash<std::string_view>{}(token));
+    }
+
+    std::string_view TokenDictionary::keyOf(const Slot& slot) const {
+        return { arena_.data() + slot.offset, slot.length };
+    }
+
+    size_t TokenDictionary::probe(std::string_view token, std::uint64_t hash) const {
+        // 返回命中的槽位，或第一个空槽位（调用方通过 id == 0 判断是否命中）
+        const size_t mask = slots_.size() - 1;
+        size_t i = static_cast<size_t>(hash) & mask;
+        while (true) {
+            const Slot& slot = slots_[i];
+            if (slot.id == 0) {
+                return i;
+            }
+            if (slot.hash == hash && keyOf(slot) == token) {
+                return i;
+            }
+            i = (i + 1) & mask;
+        }
+    }
+
+    size_t TokenDictionary::emplace(std::string_view token, std::uint64_t hash, TokenId id) {
+        if ((size_ + 1) * 10 > slots_.size() * 7) {
+            grow();
+        }
+        size_t i = probe(token, hash);
+        Slot& slot = slots_[i];
+        if (slot.id != 0) {
+            return i;
+        }
+        slot.hash = hash;
+        slot.id = id;
+        slot.offset = static_cast<std::uint32_t>(arena_.size());
+        slot.length = static_cast<std::uint32_t>(token.size());
+        arena_.append(token);
+        ++size_;
+        if (id >= next_id_) {
+            next_id_ = id + 1;
+        }
+        return i;
+    }
+
+    void TokenDictionary::grow() {
+        std::vector<Slot> old = std::move(slots_);
+        slots_.assign(old.size() * 2, Slot{});
+        const size_t mask = slots_.size() - 1;
+        for (const Slot& slot: old) {
+            if (slot.id == 0) {
+                continue;
+            }
+            size_t i = static_cast<size_t>(slot.hash) & mask;
+            while (slots_[i].id != 0) {
+                i = (i + 1) & mask;
+            }
+            slots_[i] = slot;
+        }
+    }
+
+    size_t TokenDictionary::probePacked(std::uint64_t key) const {
+        const size_t mask = packed_slots_.size() - 1;
+        size_t i = static_cast<size_t>(mixPackedKey(key)) & mask;
+        while (packed_slots_[i].id != 0 && packed_slots_[i].key != key) {
+            i = (i + 1) & mask;
+        }
+        return i;
+    }
+
+    void TokenDictionary::emplacePacked(std::uint64_t key, TokenId id) {
+        if ((packed_size_ + 1) * 10 > packed_slots_.size() * 7) {
+            std::vector<PackedSlot> old = std::move(packed_slots_);
+            packed_slots_.assign(old.size() * 2, PackedSlot{});
+            for (const PackedSlot& slot: old) {
+                if (slot.id != 0) {
+                    packed_slots_[probePacked(slot.key)] = slot;
+                }
+            }
+        }
+        PackedSlot& slot = packed_slots_[probePacked(key)];
+        if (slot.id == 0) {
+            slot = PackedSlot{ key, id };
+            ++packed_size_;
+        }
+    }
+
+    std::optional<TokenId> TokenDictionary::findLocked(std::string_view token, std::uint64_t hash) const {
+        const Slot& slot = slots_[probe(token, hash)];
+        if (slot.id != 0) {
+            return slot.id;
+        }
+        if (!base_filter_.mayContain(hash)) {
+            return std::nullopt;
+        }
+        return base_.find(token);
+    }
+
+    std::optional<TokenId> TokenDictionary::find(std::string_view token) const {
+        const std::uint64_t hash = hashToken(token);
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        return findLocked(token, hash);
+    }
+
+    TokenId TokenDictionary::getOrAssign(std::string_view token) {
+        const std::uint64_t hash = hashToken(token);
+        {
+            // 快路径：只读锁下命中（base_ 只在 load/clear 时改变，释放读锁后不会新增命中）
+            std::shared_lock<std::shared_mutex> lock(mutex_);
+            if (auto id = findLocked(token, hash)) {
+                return *id;
+            }
+        }
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        const TokenId candidate = next_id_;
+        const Slot& slot = slots_[emplace(token, hash, candidate)];
+        if (slot.id == candidate) {
+            // 新分配的词元，等待 flushIndexBuffer 批量写库
+            pending_.push_back(slot);
+        }
+        return slot.id;
+    }
+
+    void TokenDictionary::getOrAssignAll(std::span<const std::string_view> tokens, std::span<TokenId> ids) {
+        std::vector<std::uint64_t> hashes(tokens.size());
+        size_t missing = 0;
+        {
+            std::shared_lock<std::shared_mutex> lock(mutex_);
+            for (size_t i = 0; i < tokens.size(); ++i) {
+                hashes[i] = hashToken(tokens[i]);
+                auto id = findLocked(tokens[i], hashes[i]);
+                ids[i] = id.value_or(0);
+                missing += id ? 0 : 1;
+            }
+        }
+        if (missing == 0) {
+            return;
+        }
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        for (size_t i = 0; i < tokens.size(); ++i) {
+            if (ids[i] != 0) {
+                continue;
+            }
+            const TokenId candidate = next_id_;
+            const Slot& slot = slots_[emplace(tokens[i], hashes[i], candidate)];
+            if (slot.id == candidate) {
+                pending_.push_back(slot);
+            }
+            ids[i] = slot.id;
+        }
+    }
+
+    void TokenDictionary::getOrAssignAll(std::span<const std::uint64_t> keys, std::span<TokenId> ids) {
+        size_t missing = 0;
+        {
+            // 快路径：只读锁下命中打包键缓存
+            std::shared_lock<std::shared_mutex> lock(mutex_);
+            for (size_t i = 0; i < keys.size(); ++i) {
+                ids[i] = packed_slots_[probePacked(keys[i])].id;
+                missing += ids[i] == 0 ? 1 : 0;
+            }
+        }
+        if (missing == 0) {
+            return;
+        }
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        for (size_t i = 0; i < keys.size(); ++i) {
+            if (ids[i] != 0) {
+                continue;
+            }
+            if (const TokenId cached = packed_slots_[probePacked(keys[i])].id; cached != 0) {
+                ids[i] = cached; // 其他线程刚刚解析过
+                continue;
+            }
+            // 还原为 UTF-8（不超过 12 字节，短字符串优化下不分配内存）后按字符串解析
+            const std::string token = unpackToken(keys[i]);
+            const std::uint64_t hash = hashToken(token);
+            TokenId id = findLocked(token, hash).value_or(0);
+            if (id == 0) {
+                const TokenId candidate = next_id_;
+                const Slot& slot = slots_[emplace(token, hash, candidate)];
+                if (slot.id == candidate) {
+                    pending_.push_back(slot);
+                }
+                id = slot.id;
+            }
+            emplacePacked(keys[i], id);
+            ids[i] = id;
+        }
+    }
+
+    void TokenDictionary::load(std::vector<std::pair<TokenId, std::string>> tokens) {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        slots_.assign(kInitialCapacity, Slot{});
+        arena_.clear();
+        size_ = 0;
+        packed_slots_.assign(kInitialCapacity, PackedSlot{});
+        packed_size_ = 0;
+        pending_.clear();
+
+        base_filter_.reset(tokens.size());
+        for (const auto& [id, token]: tokens) {
+            base_filter_.add(hashToken(token));
+        }
+        base_.build(std::move(tokens));
+        next_id_ = base_.maxId() + 1;
+    }
+
+    std::vector<std::pair<TokenId, std::string>> TokenDictionary::getPendingTokens() const {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        std::vector<std::pair<TokenId, std::string>> result;
+        result.reserve(pending_.size());
+        for (const Slot& slot: pending_) {
+            result.emplace_back(slot.id, std::string(keyOf(slot)));
+        }
+        return result;
+    }
+
+    bool TokenDictionary::hasPendingTokens() const {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        return !pending_.empty();
+    }
+
+    void TokenDictionary::clearPendingTokens(size_t count) {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        count = std::min(count, pending_.size());
+        pending_.erase(pending_.begin(), pending_.begin() + static_cast<std::ptrdiff_t>(count));
+    }
+
+    void TokenDictionary::clear() {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        slots_.assign(kInitialCapacity, Slot{});
+        arena_.clear();
+        size_ = 0;
+        packed_slots_.assign(kInitialCapacity, PackedSlot{});
+        packed_size_ = 0;
+        next_id_ = 1;
+        pending_.clear();
+        base_.clear();
+        base_filter_.reset(0);
+    }
+
+    size_t TokenDictionary::size() const {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        return base_.size() + size_;
+    }
+
+    size_t TokenDictionary::memoryUsage() const {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        return base_.memoryUsage() + base_filter_.memoryUsage() + slots_.capacity() * sizeof(Slot) +
+               arena_.capacity() + pending_.capacity() * sizeof(Slot) + packed_slots_.capacity() * sizeof(PackedSlot);
+    }
+} // namespace wiser
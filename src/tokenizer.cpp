@@ -5,93 +5,224 @@
  * 主要职责：
  * - 将输入文本（UTF-8/UTF-32）按环境配置的 N 值切分为 N-gram
  * - 对 ASCII 字符进行小写化，与查询侧归一化保持一致
- * - 将 (token_id, doc_id, position) 追加到内存倒排索引中
+ * - 先收集文档内互不相同的词元及其位置，再批量解析词元 ID，每个词元以一次调用追加到内存倒排索引中
+ * - N 不超过 3 时词元以 64 位打包键表示（见 token_dictionary.h），只有新词元落库时才生成 UTF-8
+ * - UTF-8 输入边解码边分词，只保留最后 N 个码点的滑动窗口
+ * - 切分规则由分析器决定（见 analyzer.h）：纯 N-gram，或 ASCII 词整词 + 其余文字 N-gram 的混合分析器
+ * - 纯 N-gram 且 N = 1、2、3 时各有编译期特化的内核（以滚动打包键代替窗口），每篇文档按 N 查表选取一次；
+ *   其余情况走 forEachTerm 通用路径，其中不超过 3 个码点的词元仍以打包键去重
  */
 
 #include "wiser/tokenizer.h"
+#include "wiser/analyzer.h"
+#include "wiser/char_class.h"
+#include "wiser/token_dictionary.h"
 #include "wiser/wiser_environment.h"
 #include "wiser/utils.h"
 #include <algorithm>
-#include <cctype>
 #include <string_view>
+#include <unordered_map>
+#include <utility>
 
 namespace wiser {
+    namespace {
+        constexpr size_t kInitialLocalSlots = 1024;
+        constexpr std::uint32_t kStringLocal = 0x80000000u; ///< 字符串词元的文档内编号标记（见 resolveTokenIds）
+
+        size_t localSlotOf(std::uint64_t key, size_t mask) {
+            return static_cast<size_t>((key * 0x9E3779B97F4A7C15ULL) >> 32) & mask;
+        }
+    } // anonymous namespace
+
     Tokenizer::Tokenizer(WiserEnvironment* env)
         : env_(env) {}
 
-    // N-gram 扫描的返回结果：包含本次 N-gram 起点、长度以及是否仍有后续内容
-    struct NGramResult {
-        size_t start;
-        size_t length;
-        bool has_more;
-    };
-
-    static NGramResult getNextNGram(const std::vector<UTF32Char>& text, size_t& pos, std::int32_t n) {
-        size_t len = text.size();
-        // 跳过忽略字符（空白、标点等），定位到下一个可参与分词的位置
-        while (pos < len && Utils::isIgnoredChar(text[pos])) {
-            ++pos;
-        }
-        if (pos >= len) {
-            return { pos, 0, false };
-        }
-        size_t start = pos;
-        size_t count = 0;
-        // 从 start 开始连续读入最多 n 个非忽略字符，构成一个候选 N-gram
-        while (pos < len && count < static_cast<size_t>(n) && !Utils::isIgnoredChar(text[pos])) {
-            ++pos;
-            ++count;
-        }
-        return { start, count, pos < len };
+    template <size_t N, typename CodePointSource>
+    void Tokenizer::collectPackedNGrams(CodePointSource& source) {
+        static_assert(N >= 1 && N <= kMaxPackedTokenLength);
+        constexpr std::uint64_t kWindowMask = (std::uint64_t{ 1 } << (kPackedCodePointBits * N)) - 1;
+        constexpr unsigned kAlign = kPackedCodePointBits * static_cast<unsigned>(kMaxPackedTokenLength - N);
+        // rolling 的低 21*N 位为最后 N 个码点的打包值，左移 kAlign 即得与 packToken 相同的键
+        std::uint64_t rolling = 0;
+        size_t run = 0;
+        for (auto block = source.nextBlock(); !block.empty(); block = source.nextBlock()) {
+            for (UTF32Char ch: block) {
+                const std::uint8_t cls = charClass(ch);
+                if (cls & kCharIgnored) {
+                    run = 0;
+                    continue;
+                }
+                const UTF32Char folded = ch | static_cast<UTF32Char>((cls & kCharUpper) << 4);
+                rolling = ((rolling << kPackedCodePointBits) | packCodePoint(folded)) & kWindowMask;
+                run += run < N ? 1 : 0;
+                if (run == N) {
+                    addPackedNGram(rolling << kAlign);
+                }
+            }
+        }
     }
 
-    int Tokenizer::textToPostingsLists(DocId document_id,
-                                        const std::vector<UTF32Char>& text,
-                                        InvertedIndex& index) {
-        // pos：UTF-32 字符索引；position：token 在文档中的序号（用于短语搜索的相邻验证）
-        size_t pos = 0;
-        Position position = 0;
+    template <typename CodePointSource>
+    int Tokenizer::tokenize(DocId document_id, CodePointSource& source, InvertedIndex& index) {
         // N 值来自环境配置（Config::token_len）
         const std::int32_t n = env_->getTokenLength();
-        while (pos < text.size()) {
-            // 读取下一个候选 token 的范围
-            auto ngram_result = getNextNGram(text, pos, n);
-            if (ngram_result.length == 0)
-                break;
-            if (ngram_result.length >= static_cast<size_t>(n)) {
-                // 将 [start, start+length) 转为 UTF-8 token，并写入倒排索引
-                std::string token = extractNGram(text, ngram_result.start,
-                                                 static_cast<std::int32_t>(ngram_result.length));
-                tokenToPostingsList(document_id, token, position, index);
-                ++position;
-            }
-            // 滑动窗口：从 start+1 继续尝试，形成重叠 N-gram
-            pos = ngram_result.start + 1;
+        if (n <= 0) {
+            return 0;
+        }
+        // occurrences_ 的下标即 token 在文档中的序号（用于短语搜索的相邻验证）
+        occurrences_.clear();
+        if (local_slots_.empty()) {
+            local_slots_.assign(kInitialLocalSlots, LocalSlot{});
+        }
+        if (++local_stamp_ == 0) {
+            std::ranges::fill(local_slots_, LocalSlot{});
+            local_stamp_ = 1;
+        }
+        packed_keys_.clear();
+        local_ids_.clear();
+        local_tokens_.clear();
+        const AnalyzerType analyzer = env_->getAnalyzer();
+        if (analyzer == AnalyzerType::NGRAM && n <= static_cast<std::int32_t>(kMaxPackedTokenLength)) {
+            // 按 N 选取编译期特化的内核
+            using Collector = void (Tokenizer::*)(CodePointSource&);
+            static constexpr Collector kCollectors[kMaxPackedTokenLength] = {
+                    &Tokenizer::collectPackedNGrams<1, CodePointSource>,
+                    &Tokenizer::collectPackedNGrams<2, CodePointSource>,
+                    &Tokenizer::collectPackedNGrams<3, CodePointSource>,
+            };
+            (this->*kCollectors[n - 1])(source);
+        } else {
+            forEachTerm(analyzer, static_cast<size_t>(n), source, window_, word_,
+                        [this](std::span<const UTF32Char> term) { addTerm(term); });
         }
-        // position 即写入的 token 数量
-        return static_cast<int>(position);
+        resolveTokenIds();
+        if (occurrences_.empty()) {
+            return 0;
+        }
+        appendPostings(document_id, index);
+        // 位置数即写入的 token 数量
+        return static_cast<int>(occurrences_.size());
+    }
+
+    int Tokenizer::textToPostingsLists(DocId document_id,
+                                        const std::vector<UTF32Char>& text,
+                                        InvertedIndex& index) {
+        Utf32Source source{ std::span<const UTF32Char>(text) };
+        return tokenize(document_id, source, index);
     }
 
     int Tokenizer::textToPostingsLists(DocId document_id,
                                         std::string_view utf8_text,
                                         InvertedIndex& index) {
-        // 将 UTF-8 先转换为 UTF-32 再处理，避免按字节切分造成 Unicode 破坏
-        std::string s{ utf8_text };
-        auto utf32 = Utils::utf8ToUtf32(s);
-        return textToPostingsLists(document_id, utf32, index);
+        // 边解码边分词，避免复制正文与生成整篇 UTF-32 数组
+        Utf8Source source(utf8_text);
+        return tokenize(document_id, source, index);
+    }
+
+    void Tokenizer::addPackedNGram(std::uint64_t key) {
+        size_t mask = local_slots_.size() - 1;
+        size_t i = localSlotOf(key, mask);
+        while (local_slots_[i].stamp == local_stamp_ && local_slots_[i].key != key) {
+            i = (i + 1) & mask;
+        }
+        if (local_slots_[i].stamp != local_stamp_) {
+            // 文档内首次出现
+            if ((packed_keys_.size() + 1) * 2 > local_slots_.size()) {
+                growLocalSlots();
+                mask = local_slots_.size() - 1;
+                i = localSlotOf(key, mask);
+                while (local_slots_[i].stamp == local_stamp_) {
+                    i = (i + 1) & mask;
+                }
+            }
+            local_slots_[i] = LocalSlot{ key, static_cast<std::uint32_t>(packed_keys_.size()), local_stamp_ };
+            packed_keys_.push_back(key);
+        }
+        occurrences_.push_back(local_slots_[i].local);
+    }
+
+    void Tokenizer::growLocalSlots() {
+        local_slots_.assign(local_slots_.size() * 2, LocalSlot{});
+        local_stamp_ = 1;
+        const size_t mask = local_slots_.size() - 1;
+        for (size_t local = 0; local < packed_keys_.size(); ++local) {
+            size_t i = localSlotOf(packed_keys_[local], mask);
+            while (local_slots_[i].stamp == local_stamp_) {
+                i = (i + 1) & mask;
+            }
+            local_slots_[i] = LocalSlot{ packed_keys_[local], static_cast<std::uint32_t>(local), local_stamp_ };
+        }
+    }
+
+    void Tokenizer::addTerm(std::span<const UTF32Char> term) {
+        if (term.size() <= kMaxPackedTokenLength) {
+            addPackedNGram(packToken(term));
+        } else {
+            addNGram(term);
+        }
+    }
+
+    void Tokenizer::addNGram(std::span<const UTF32Char> ngram) {
+        token_.clear();
+        for (UTF32Char ch: ngram) {
+            Utils::appendUtf8(token_, ch);
+        }
+        auto [it, inserted] = local_ids_.try_emplace(token_, static_cast<std::uint32_t>(local_tokens_.size()));
+        if (inserted) {
+            local_tokens_.emplace_back(it->first); // unordered_map 的键地址稳定
+        }
+        occurrences_.push_back(it->second | kStringLocal);
+    }
+
+    void Tokenizer::resolveTokenIds() {
+        // token_ids_ 中打包键词元在前、字符串词元在后；各自一次批量解析（按首次出现顺序分配，与逐个解析的结果相同）
+        const size_t packed = packed_keys_.size();
+        token_ids_.resize(packed + local_tokens_.size());
+        TokenDictionary& dictionary = env_->getTokenDictionary();
+        if (packed > 0) {
+            dictionary.getOrAssignAll(std::span<const std::uint64_t>(packed_keys_),
+                                      std::span<TokenId>(token_ids_).first(packed));
+        }
+        if (!local_tokens_.empty()) {
+            dictionary.getOrAssignAll(std::span<const std::string_view>(local_tokens_),
+                                      std::span<TokenId>(token_ids_).subspan(packed));
+            // 字符串词元的文档内编号换算为 token_ids_ 中的下标
+            for (std::uint32_t& local: occurrences_) {
+                if (local & kStringLocal) {
+                    local = static_cast<std::uint32_t>(packed) + (local & ~kStringLocal);
+                }
+            }
+        }
+    }
+
+    void Tokenizer::appendPostings(DocId document_id, InvertedIndex& index) {
+        // 按词元归组位置（计数排序，组内位置保持升序），每个词元整段写入倒排索引
+        const size_t distinct = token_ids_.size();
+        group_ends_.assign(distinct + 1, 0);
+        for (std::uint32_t local: occurrences_) {
+            ++group_ends_[local + 1];
+        }
+        for (size_t i = 1; i < group_ends_.size(); ++i) {
+            group_ends_[i] += group_ends_[i - 1];
+        }
+        grouped_.resize(occurrences_.size());
+        group_cursor_.assign(group_ends_.begin(), group_ends_.end() - 1);
+        for (size_t p = 0; p < occurrences_.size(); ++p) {
+            grouped_[group_cursor_[occurrences_[p]]++] = static_cast<Position>(p);
+        }
+        for (size_t i = 0; i < distinct; ++i) {
+            index.addDocument(token_ids_[i], document_id,
+                              std::span<const Position>(grouped_.data() + group_ends_[i],
+                                                        grouped_.data() + group_ends_[i + 1]));
+        }
     }
 
     void Tokenizer::tokenToPostingsList(DocId document_id,
                                         const std::string& token,
                                         Position position,
                                         InvertedIndex& index) {
-        // 获取或创建词元ID
-        auto info = env_->getDatabase().getTokenInfo(token, true);
-        if (!info.has_value() || info->id <= 0) {
-            spdlog::error("Failed to get token ID for token: {}", token);
-            return;
-        }
-        TokenId token_id = info->id;
+        // 获取或分配词元ID：命中进程内字典只需一次哈希探测，新词元在 flush 时批量落库
+        TokenId token_id = env_->getTokenDictionary().getOrAssign(token);
 
         // 将该 token 在该文档出现的位置写入内存倒排索引
         index.addPosting(token_id, document_id, position);
@@ -103,30 +234,17 @@ namespace wiser {
         if (!token.empty()) {
             spdlog::info("Token {}: {}", token_id, token);
 
-            // 获取倒排列表信息
-            auto rec = env_->getDatabase().getPostings(token_id);
-            Count docs_count = rec ? rec->docs_count : 0;
-            size_t sz = rec ? rec->postings.size() : 0u;
+            // 获取倒排列表信息（各索引段之和）
+            Count docs_count = 0;
+            size_t sz = 0;
+            env_->getDatabase().visitPostings(token_id, [&](Count count, std::span<const char> postings) {
+                docs_count += count;
+                sz += postings.size();
+            });
 
             spdlog::info("Documents: {}, Postings size: {} bytes", docs_count, sz);
         } else {
             spdlog::error("Token {}: not found", token_id);
         }
     }
-
-    std::string Tokenizer::extractNGram(const std::vector<UTF32Char>& text,
-                                        size_t start, std::int32_t length) {
-        if (start >= text.size() || length <= 0) {
-            return "";
-        }
-        size_t end = std::min(start + static_cast<size_t>(length), text.size());
-        std::vector<UTF32Char> ngram(text.begin() + start, text.begin() + end);
-        // ASCII 字符统一小写化，保证大小写不敏感匹配
-        for (auto& ch: ngram) {
-            if (ch <= 127) {
-                ch = static_cast<UTF32Char>(std::tolower(static_cast<unsigned char>(ch)));
-            }
-        }
-        return Utils::utf32ToUtf8(ngram);
-    }
 } // namespace wiser
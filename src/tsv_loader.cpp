@@ -16,6 +16,8 @@
 #include <fstream>
 #include <string>
 #include <iostream>
+#include <utility>
+#include <vector>
 
 namespace wiser {
     bool TsvLoader::loadFromFile(const std::string& file_path, bool has_header) {
@@ -77,6 +79,15 @@ namespace wiser {
 
         std::uint64_t processed_ok = 0;
 
+        // 按批提交，正文由环境并行分词
+        std::vector<std::pair<std::string, std::string>> batch;
+        batch.reserve(kIngestBatchSize);
+        auto submit_batch = [&]() {
+            processed_ok += env_->addDocuments(batch);
+            batch.clear();
+            print_progress(processed_ok, total_for_progress);
+        };
+
         // 跳过表头（若有）
         if (has_header && std::getline(ifs, line)) {
             // skip header
@@ -98,16 +109,21 @@ namespace wiser {
             if (title.empty() || body.empty())
                 continue;
 
-            // 写入文档并更新导入进度
-            env_->addDocument(title, body);
-            ++processed_ok;
-            print_progress(processed_ok, total_for_progress);
+            batch.emplace_back(std::move(title), std::move(body));
+            if (batch.size() < kIngestBatchSize) {
+                continue;
+            }
+            // 写入一批文档并更新导入进度
+            submit_batch();
 
             if (env_->hasReachedIndexLimit()) {
                 std::cerr << std::endl;
                 break;
             }
         }
+        if (!batch.empty()) {
+            submit_batch();
+        }
 
         if (processed_ok > 0) {
             print_progress(processed_ok, total_for_progress);
@@ -8,12 +8,154 @@
  */
 
 #include "wiser/utils.h"
+#include "wiser/analyzer.h"
 #include <chrono>
 #include <cstdio>
 #include <cctype>
 #include <algorithm>
 
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define WISER_UTF8_SSE2 1
+#endif
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define WISER_UTF8_AVX2 1 // 以 target 属性单独编译，运行时按 CPU 支持情况选用
+#endif
+
 namespace wiser {
+    namespace {
+        constexpr size_t kUtf8Window = 64; ///< 续字节位图的窗口字节数
+
+        /**
+         * @brief 把开头的 ASCII 字节逐个拓宽为码点，遇到第一个非 ASCII 字节即停止
+         * @return 处理的字节数
+         */
+        size_t widenAsciiScalar(const unsigned char* in, size_t n, UTF32Char* out) {
+            size_t i = 0;
+            while (i < n && in[i] < 0x80) {
+                out[i] = in[i];
+                ++i;
+            }
+            return i;
+        }
+
+#ifdef WISER_UTF8_SSE2
+        size_t widenAsciiSse2(const unsigned char* in, size_t n, UTF32Char* out) {
+            const __m128i zero = _mm_setzero_si128();
+            size_t i = 0;
+            for (; i + 16 <= n; i += 16) {
+                const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+                if (_mm_movemask_epi8(bytes) != 0) {
+                    break; // 含非 ASCII 字节，余下交给标量处理
+                }
+                const __m128i lo = _mm_unpacklo_epi8(bytes, zero);
+                const __m128i hi = _mm_unpackhi_epi8(bytes, zero);
+                auto* dst = reinterpret_cast<__m128i*>(out + i);
+                _mm_storeu_si128(dst, _mm_unpacklo_epi16(lo, zero));
+                _mm_storeu_si128(dst + 1, _mm_unpackhi_epi16(lo, zero));
+                _mm_storeu_si128(dst + 2, _mm_unpacklo_epi16(hi, zero));
+                _mm_storeu_si128(dst + 3, _mm_unpackhi_epi16(hi, zero));
+            }
+            return i + widenAsciiScalar(in + i, n - i, out + i);
+        }
+#endif
+
+#ifdef WISER_UTF8_AVX2
+        __attribute__((target("avx2"))) size_t widenAsciiAvx2(const unsigned char* in, size_t n, UTF32Char* out) {
+            size_t i = 0;
+            for (; i + 32 <= n; i += 32) {
+                const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+                if (_mm256_movemask_epi8(bytes) != 0) {
+                    break;
+                }
+                auto* dst = reinterpret_cast<__m256i*>(out + i);
+                for (int k = 0; k < 4; ++k) {
+                    const __m128i eight = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(in + i + 8 * k));
+                    _mm256_storeu_si256(dst + k, _mm256_cvtepu8_epi32(eight));
+                }
+            }
+            return i + widenAsciiScalar(in + i, n - i, out + i);
+        }
+#endif
+
+        using WidenAsciiFn = size_t (*)(const unsigned char*, size_t, UTF32Char*);
+
+        WidenAsciiFn selectWidenAscii() {
+#ifdef WISER_UTF8_AVX2
+            if (__builtin_cpu_supports("avx2")) {
+                return widenAsciiAvx2;
+            }
+#endif
+#ifdef WISER_UTF8_SSE2
+            return widenAsciiSse2;
+#else
+            return widenAsciiScalar;
+#endif
+        }
+
+        WidenAsciiFn widenAscii() {
+            static const WidenAsciiFn fn = selectWidenAscii();
+            return fn;
+        }
+
+        /**
+         * @brief 多字节序列的首字节对应的序列长度
+         * @return 110xxxxx、1110xxxx、11110xxx 分别返回 2、3、4；续字节或无效字节返回 0
+         */
+        int utf8SequenceLength(unsigned char first_byte) {
+            if ((first_byte & 0xE0) == 0xC0) {
+                return 2;
+            }
+            if ((first_byte & 0xF0) == 0xE0) {
+                return 3;
+            }
+            if ((first_byte & 0xF8) == 0xF0) {
+                return 4;
+            }
+            return 0;
+        }
+
+        /**
+         * @brief 解码已校验的多字节序列
+         */
+        UTF32Char decodeSequence(const unsigned char* in, int byte_count) {
+            switch (byte_count) {
+                case 2:
+                    return (UTF32Char{ in[0] & 0x1Fu } << 6) | (in[1] & 0x3Fu);
+                case 3:
+                    return (UTF32Char{ in[0] & 0x0Fu } << 12) | ((in[1] & 0x3Fu) << 6) | (in[2] & 0x3Fu);
+                default:
+                    return (UTF32Char{ in[0] & 0x07u } << 18) | ((in[1] & 0x3Fu) << 12) | ((in[2] & 0x3Fu) << 6) |
+                           (in[3] & 0x3Fu);
+            }
+        }
+
+        /**
+         * @brief 64 字节窗口的续字节位图：第 i 位为 1 表示 in[i] 形如 10xxxxxx
+         */
+        std::uint64_t continuationMask64(const unsigned char* in) {
+#ifdef WISER_UTF8_SSE2
+            // 有符号比较：0x80..0xBF 即 -128..-65，小于 -64（0xC0）
+            const __m128i limit = _mm_set1_epi8(-64);
+            std::uint64_t mask = 0;
+            for (int k = 0; k < 4; ++k) {
+                const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 16 * k));
+                mask |= static_cast<std::uint64_t>(static_cast<std::uint32_t>(
+                                _mm_movemask_epi8(_mm_cmplt_epi8(bytes, limit))))
+                        << (16 * k);
+            }
+            return mask;
+#else
+            std::uint64_t mask = 0;
+            for (int i = 0; i < 64; ++i) {
+                mask |= static_cast<std::uint64_t>((in[i] & 0xC0) == 0x80) << i;
+            }
+            return mask;
+#endif
+        }
+    } // anonymous namespace
+
     // Buffer 实现：支持按字节追加，也支持按位追加（用于压缩编码）
     Buffer::Buffer() {
         buffer_.reserve(32); // 初始容量
@@ -60,90 +202,117 @@ namespace wiser {
         result.reserve(utf32_str.size() * 4); // 预分配空间
 
         for (UTF32Char code_point: utf32_str) {
-            if (code_point <= 0x7F) {
-                // 1字节UTF-8
-                result.push_back(static_cast<char>(code_point));
-            } else if (code_point <= 0x7FF) {
-                // 2字节UTF-8
-                result.push_back(static_cast<char>(0xC0 | (code_point >> 6)));
-                result.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
-            } else if (code_point <= 0xFFFF) {
-                // 3字节UTF-8
-                result.push_back(static_cast<char>(0xE0 | (code_point >> 12)));
-                result.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
-                result.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
-            } else if (code_point <= 0x10FFFF) {
-                // 4字节UTF-8
-                result.push_back(static_cast<char>(0xF0 | (code_point >> 18)));
-                result.push_back(static_cast<char>(0x80 | ((code_point >> 12) & 0x3F)));
-                result.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
-                result.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
-            }
-            // 忽略无效的码点
+            appendUtf8(result, code_point);
         }
 
         return result;
     }
 
+    void Utils::appendUtf8(std::string& out, UTF32Char code_point) {
+        if (code_point <= 0x7F) {
+            // 1字节UTF-8
+            out.push_back(static_cast<char>(code_point));
+        } else if (code_point <= 0x7FF) {
+            // 2字节UTF-8
+            out.push_back(static_cast<char>(0xC0 | (code_point >> 6)));
+            out.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+        } else if (code_point <= 0xFFFF) {
+            // 3字节UTF-8
+            out.push_back(static_cast<char>(0xE0 | (code_point >> 12)));
+            out.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+        } else if (code_point <= 0x10FFFF) {
+            // 4字节UTF-8
+            out.push_back(static_cast<char>(0xF0 | (code_point >> 18)));
+            out.push_back(static_cast<char>(0x80 | ((code_point >> 12) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+        }
+        // 忽略无效的码点
+    }
+
     std::vector<UTF32Char> Utils::utf8ToUtf32(const std::string& utf8_str) {
+        // 码点数不超过字节数：按字节数预留容量（不初始化），分块解码后追加
         std::vector<UTF32Char> result;
+        result.reserve(utf8_str.size());
+        UTF32Char chunk[256];
+        size_t pos = 0;
+        while (size_t n = decodeUtf8(utf8_str, pos, chunk, std::size(chunk))) {
+            result.insert(result.end(), chunk, chunk + n);
+        }
+        return result;
+    }
 
-        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(utf8_str.c_str());
-        size_t len = utf8_str.length();
-
-        for (size_t i = 0; i < len;) {
-            UTF32Char code_point = 0;
-            std::int32_t byte_count = 0;
-
-            unsigned char first_byte = bytes[i];
-
-            if ((first_byte & 0x80) == 0) {
-                // 1字节字符 (0xxxxxxx)
-                code_point = first_byte;
-                byte_count = 1;
-            } else if ((first_byte & 0xE0) == 0xC0) {
-                // 2字节字符 (110xxxxx 10xxxxxx)
-                code_point = first_byte & 0x1F;
-                byte_count = 2;
-            } else if ((first_byte & 0xF0) == 0xE0) {
-                // 3字节字符 (1110xxxx 10xxxxxx 10xxxxxx)
-                code_point = first_byte & 0x0F;
-                byte_count = 3;
-            } else if ((first_byte & 0xF8) == 0xF0) {
-                // 4字节字符 (11110xxx 10xxxxxx 10xxxxxx 10xxxxxx)
-                code_point = first_byte & 0x07;
-                byte_count = 4;
-            } else {
-                // 无效的UTF-8序列，跳过
-                ++i;
+    size_t Utils::decodeUtf8(std::string_view utf8_str, size_t& pos, UTF32Char* out, size_t max_count) {
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(utf8_str.data());
+        const size_t len = utf8_str.size();
+        const WidenAsciiFn widen_ascii = widenAscii();
+        size_t written = 0;
+
+        while (pos < len && written < max_count) {
+            if (bytes[pos] < 0x80) {
+                // 1字节字符 (0xxxxxxx)：连续的 ASCII 片段整段拓宽
+                const size_t n = widen_ascii(bytes + pos, std::min(len - pos, max_count - written), out + written);
+                pos += n;
+                written += n;
                 continue;
             }
 
-            // 检查是否有足够的字节
-            if (i + byte_count > len) {
-                break;
+            if (pos + kUtf8Window <= len) {
+                // 64 字节窗口：续字节位图只计算一次，窗口内完整的多字节序列逐个查位图校验，遇到 ASCII 即返回快路径
+                const size_t base = pos;
+                const std::uint64_t mask = continuationMask64(bytes + base);
+                while (written < max_count && pos - base < kUtf8Window && bytes[pos] >= 0x80) {
+                    const int byte_count = utf8SequenceLength(bytes[pos]);
+                    const size_t offset = pos - base;
+                    if (byte_count == 0) {
+                        // 无效的首字节，跳过
+                        ++pos;
+                        continue;
+                    }
+                    if (offset + static_cast<size_t>(byte_count) > kUtf8Window) {
+                        break; // 序列跨出窗口，下一轮以新窗口处理
+                    }
+                    const std::uint64_t need = ((std::uint64_t{ 1 } << byte_count) - 2u) << offset;
+                    if ((mask & need) != need) {
+                        // 无效序列，跳过第一个字节
+                        ++pos;
+                        continue;
+                    }
+                    out[written++] = decodeSequence(bytes + pos, byte_count);
+                    pos += static_cast<size_t>(byte_count);
+                }
+                continue;
             }
 
-            // 读取后续字节
+            // 末尾不足一个窗口：逐字节校验
+            const int byte_count = utf8SequenceLength(bytes[pos]);
+            if (byte_count == 0) {
+                // 无效的UTF-8序列，跳过
+                ++pos;
+                continue;
+            }
+            // 检查是否有足够的字节：不足则视为结束
+            if (pos + static_cast<size_t>(byte_count) > len) {
+                pos = len;
+                break;
+            }
             bool valid = true;
-            for (std::int32_t j = 1; j < byte_count; ++j) {
-                if ((bytes[i + j] & 0xC0) != 0x80) {
+            for (int j = 1; j < byte_count; ++j) {
+                if ((bytes[pos + j] & 0xC0) != 0x80) {
                     valid = false;
                     break;
                 }
-                code_point = (code_point << 6) | (bytes[i + j] & 0x3F);
             }
-
             if (valid) {
-                result.push_back(code_point);
-                i += static_cast<size_t>(byte_count);
+                out[written++] = decodeSequence(bytes + pos, byte_count);
+                pos += static_cast<size_t>(byte_count);
             } else {
                 // 无效序列，跳过第一个字节
-                ++i;
+                ++pos;
             }
         }
-
-        return result;
+        return written;
     }
 
     std::int32_t Utils::calculateUtf8Size(const std::vector<UTF32Char>& utf32_str) {
@@ -173,46 +342,6 @@ namespace wiser {
     }
 
     // ---- 新增通用工具实现 ----
-    bool Utils::isIgnoredChar(const UTF32Char ch) {
-        if (ch <= 127) {
-            // ASCII 空白一律忽略；标点大多忽略，但保留 '.'：
-            // 这样小数（如 2.5）会形成连续字符序列，从而在 N=2 时产生 "2."、".5" 等 token，
-            // 支持对小数的检索。若把 '.' 也当作标点忽略，则会把 "2" 与 "5" 分割成两个长度 < N 的片段，
-            // 导致查询无法产生 token。
-            if (std::isspace(static_cast<unsigned char>(ch))) {
-                return true;
-            }
-            if (std::ispunct(static_cast<unsigned char>(ch))) {
-                if (ch == '.') {
-                    return false; // keep periods inside tokens
-                }
-                return true;
-            }
-            return false;
-        }
-        switch (ch) {
-            case 0x3000: // 全角空格
-            case 0x3001: // 、
-            case 0x3002: // 。
-            case 0xFF08: // （
-            case 0xFF09: // ）
-            case 0xFF01: // ！
-            case 0xFF0C: // ，
-            case 0xFF1A: // ：
-            case 0xFF1B: // ；
-            case 0xFF1F: // ？
-            case 0xFF3B: // ［
-            case 0xFF3D: // ］
-            case 0x201C: // “
-            case 0x201D: // ”
-            case 0x2018: // ‘
-            case 0x2019: // ’
-                return true;
-            default:
-                return false;
-        }
-    }
-
     void Utils::toLowerAsciiInPlace(std::string& s) {
         std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) {
             if (c < 128)
@@ -239,38 +368,20 @@ namespace wiser {
         return true;
     }
 
-    std::vector<std::string> Utils::tokenizeQueryTokens(const std::string& q, int n) {
+    std::vector<std::string> Utils::tokenizeQueryTokens(const std::string& q, int n, AnalyzerType analyzer) {
         std::vector<std::string> tokens;
-        auto utf32_vec = utf8ToUtf32(q);
-
-        std::vector<std::vector<UTF32Char>> runs;
-        std::vector<UTF32Char> cur;
-        cur.reserve(16);
-        for (auto cp: utf32_vec) {
-            if (isIgnoredChar(cp)) {
-                if (!cur.empty()) {
-                    runs.push_back(cur);
-                    cur.clear();
-                }
-            } else {
-                if (cp <= 127) {
-                    cp = static_cast<UTF32Char>(std::tolower(static_cast<unsigned char>(cp)));
-                }
-                cur.push_back(cp);
-            }
+        if (n <= 0) {
+            return tokens;
         }
-        if (!cur.empty())
-            runs.push_back(cur);
-
-        for (auto& run: runs) {
-            if (run.size() < static_cast<size_t>(n))
-                continue;
-            for (size_t i = 0; i + static_cast<size_t>(n) <= run.size(); ++i) {
-                std::vector<UTF32Char> ng(run.begin() + static_cast<std::ptrdiff_t>(i),
-                                          run.begin() + static_cast<std::ptrdiff_t>(i + n));
-                tokens.push_back(utf32ToUtf8(ng));
+        Utf8Source source(q);
+        std::vector<UTF32Char> window, word;
+        forEachTerm(analyzer, static_cast<size_t>(n), source, window, word, [&](std::span<const UTF32Char> term) {
+            std::string token;
+            for (UTF32Char ch: term) {
+                appendUtf8(token, ch);
             }
-        }
+            tokens.push_back(std::move(token));
+        });
 
         // 去重，保序
         std::vector<std::string> unique;
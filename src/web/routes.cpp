@@ -79,7 +79,7 @@ namespace wiser::web {
             }
 
             const int n = env.getTokenLength();                       // 查询 token 长度配置
-            auto query_tokens = Utils::tokenizeQueryTokens(query, n); // 分词（已假设做过归一化）
+            auto query_tokens = Utils::tokenizeQueryTokens(query, n, env.getAnalyzer()); // 与索引相同的分析器分词
             std::vector<std::pair<wiser::DocId, double>> results = search_engine.searchWithResults(query);
 
             // 局部 lambda：复制并转小写（只处理 ASCII）
@@ -63,6 +63,14 @@ static const char* compressMethodToString(wiser::CompressMethod m) {
             return "none";
         case wiser::CompressMethod::GOLOMB:
             return "golomb";
+        case wiser::CompressMethod::BP128:
+            return "bp128";
+        case wiser::CompressMethod::ELIAS_FANO:
+            return "eliasfano";
+        case wiser::CompressMethod::GOLOMB_ADAPTIVE:
+            return "golomb-adaptive";
+        case wiser::CompressMethod::AUTO:
+            return "auto";
         default:
             return "unknown";
     }
@@ -76,6 +84,14 @@ wiser::CompressMethod parseCompressMethod(const std::string& method_str) {
         return wiser::CompressMethod::NONE;
     } else if (lower_method == "golomb") {
         return wiser::CompressMethod::GOLOMB;
+    } else if (lower_method == "bp128") {
+        return wiser::CompressMethod::BP128;
+    } else if (lower_method == "eliasfano") {
+        return wiser::CompressMethod::ELIAS_FANO;
+    } else if (lower_method == "golomb-adaptive") {
+        return wiser::CompressMethod::GOLOMB_ADAPTIVE;
+    } else if (lower_method == "auto") {
+        return wiser::CompressMethod::AUTO;
     } else {
         spdlog::error("Invalid compress method({}). Using none instead.", method_str);
         return wiser::CompressMethod::NONE;
@@ -152,14 +168,15 @@ int main(int argc, char* argv[]) {
             config.buffer_update_threshold, config.max_index_count);
     } else {
         // 对于已存在的数据库，仅应用 Config 中的运行时参数
-        // 注意：不要覆盖已加载的结构性参数（如 token_len, compress_method）
+        // 注意：不要覆盖已加载的结构性参数（如 token_len, analyzer, compress_method）
         env.setBufferUpdateThreshold(config.buffer_update_threshold);
         env.setMaxIndexCount(config.max_index_count);
         env.setPhraseSearchEnabled(config.enable_phrase_search);
         env.setScoringMethod(config.scoring_method);
 
-        spdlog::info("Loaded settings from existing DB. TokenLen={}, CompressMethod={}.",
-                     env.getTokenLength(), compressMethodToString(env.getCompressMethod()));
+        spdlog::info("Loaded settings from existing DB. TokenLen={}, Analyzer={}, CompressMethod={}.",
+                     env.getTokenLength(), env.getAnalyzer() == wiser::AnalyzerType::HYBRID ? "hybrid" : "ngram",
+                     compressMethodToString(env.getCompressMethod()));
     }
 
     wiser::SearchEngine search_engine(&env);
@@ -17,6 +17,8 @@
 #include <fstream>
 #include <regex>
 #include <iostream>
+#include <utility>
+#include <vector>
 
 namespace wiser {
     WikiLoader::WikiLoader(WiserEnvironment* env)
@@ -73,6 +75,14 @@ namespace wiser {
         bool in_title = false;
         bool in_text = false;
         int processed_pages = 0;
+        // 按批提交，正文由环境并行分词
+        std::vector<std::pair<std::string, std::string>> batch;
+        batch.reserve(kIngestBatchSize);
+        auto submit_batch = [&]() {
+            processed_pages += static_cast<int>(processPages(batch));
+            batch.clear();
+            print_progress(processed_pages, total_for_progress);
+        };
 
         while (std::getline(file, line)) {
             // 达到索引上限则提前退出
@@ -92,12 +102,10 @@ namespace wiser {
 
                 if (!current_title.empty() && !current_content.empty() &&
                     isValidPage(current_title, current_content)) {
-                    std::string cleaned_content = cleanWikiText(current_content);
-
-                    if (processPage(current_title, cleaned_content)) {
-                        ++processed_pages;
-                        print_progress(processed_pages, total_for_progress);
-                        // 每成功处理一个页面后再次检查上限
+                    batch.emplace_back(current_title, cleanWikiText(current_content));
+                    if (batch.size() >= kIngestBatchSize) {
+                        submit_batch();
+                        // 每提交一批页面后再次检查上限
                         if (env_ && env_->hasReachedIndexLimit()) {
                             std::cerr << std::endl;
                             break;
@@ -140,6 +148,10 @@ namespace wiser {
             }
         }
 
+        if (!batch.empty()) {
+            submit_batch();
+        }
+
         // 完成后换行，避免光标停留在同一行
         if (processed_pages > 0) {
             print_progress(processed_pages, total_for_progress);
@@ -162,6 +174,15 @@ namespace wiser {
         }
     }
 
+    size_t WikiLoader::processPages(std::span<const std::pair<std::string, std::string>> pages) {
+        try {
+            return env_->addDocuments(pages);
+        } catch (const std::exception& e) {
+            spdlog::error("Failed to process {} page(s): {}", pages.size(), e.what());
+            return 0;
+        }
+    }
+
     std::string WikiLoader::cleanWikiText(const std::string& raw_text) {
         // 基于正则做一组替换，剥离常见 Wiki/HTML 标记，得到更“文本化”的内容
         std::string cleaned = raw_text;
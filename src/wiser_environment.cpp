@@ -11,11 +11,21 @@
 
 #include "wiser/wiser_environment.h"
 #include "wiser/utils.h"
+#include "wiser/postings_block.h"
 
+#include <algorithm>
+#include <exception>
+#include <limits>
 #include <stdexcept>
 #include <iostream>
+#include <string_view>
+#include <thread>
 
 namespace wiser {
+    namespace {
+        constexpr size_t kMinDocsPerIndexThread = 8; // 每个分词线程至少处理的文档数，文档过少时不值得启动线程
+    } // anonymous namespace
+
     /**
      * @brief WiserEnvironment 构造函数
      * 
@@ -24,6 +34,7 @@ namespace wiser {
      * - search_engine_: 搜索引擎核心组件，传入当前环境指针
      * - tokenizer_: 分词器组件，传入当前环境指针
      * - wiki_loader_: Wikipedia文档加载器，传入当前环境指针
+     * - compactor_: 索引段后台合并器，传入当前环境指针（initialize 时启动）
      * 
      * 注意：配置默认值已在 config.h 的结构体定义中设置，此处无需重复设置
      */
@@ -31,7 +42,8 @@ namespace wiser {
         : indexed_count_(0)           // 已索引文档数量，初始为0
         , search_engine_(this)        // 初始化搜索引擎组件，传入当前环境指针
         , tokenizer_(this)            // 初始化分词器组件，传入当前环境指针
-        , wiki_loader_(this) {        // 初始化Wikipedia加载器，传入当前环境指针
+        , wiki_loader_(this)          // 初始化Wikipedia加载器，传入当前环境指针
+        , compactor_(this) {          // 初始化段合并器，传入当前环境指针
             // Config defaults are already set in struct definition in config.h
             // No need to reset them here unless we use constants from WiserEnvironment which are now redundant
         }
@@ -43,7 +55,9 @@ namespace wiser {
      * 1. 设置数据库路径配置
      * 2. 初始化数据库连接
      * 3. 加载文档长度缓存数据
-     * 4. 从数据库加载配置设置
+     * 4. 预热进程内词元字典
+     * 5. 从数据库加载配置设置
+     * 6. 启动后台段合并线程
      * 
      * @param db_path 数据库文件路径
      * @return bool 初始化成功返回true，失败返回false
@@ -60,6 +74,9 @@ namespace wiser {
             return false;
         }
 
+        // 清理上次运行中断时遗留的未发布段（合并或刷新未完成）
+        database_.dropUnpublishedSegments();
+
         // 加载文档长度缓存
         // 使用代码块限制 counts 变量的作用域
         {
@@ -91,6 +108,11 @@ namespace wiser {
             spdlog::info("Loaded {} document lengths into cache. Total tokens: {}", counts.size(), total_tokens_);
         }
 
+        // 预热词元字典：已持久化的词元存入前缀压缩字典并构建 Bloom 过滤器，之后的词元查找不再经过 SQL
+        token_dictionary_.load(database_.getAllTokens());
+        spdlog::info("Loaded {} tokens into dictionary ({} bytes).", token_dictionary_.size(),
+                     token_dictionary_.memoryUsage());
+
         // 从数据库加载配置
         // 从数据库获取存储的配置信息
         auto db_config = database_.getConfig();
@@ -110,6 +132,12 @@ namespace wiser {
             config_.enable_phrase_search = db_config.enable_phrase_search;
         }
 
+        // 压缩方式决定已有倒排列表的解码方式，必须与库中一致
+        config_.compress_method = db_config.compress_method;
+
+        // 分析器决定词元的切分方式，查询必须与建索引时一致
+        config_.analyzer = db_config.analyzer;
+
         // 标记已初始化，使 set* 立刻持久化
         initialized_ = true;
 
@@ -119,6 +147,9 @@ namespace wiser {
         // database_.setSetting("enable_phrase_search", enable_phrase_search_ ? "1" : "0");
         // database_.setSetting("indexed_count", std::to_string(indexed_count_));
 
+        // 启动后台段合并线程
+        compactor_.start();
+
         // 记录初始化成功日志
         spdlog::info("Wiser environment initialized successfully.");
 
@@ -126,25 +157,48 @@ namespace wiser {
         return true;
     }
 
+    bool WiserEnvironment::setAnalyzer(AnalyzerType analyzer) {
+        if (initialized_ && analyzer != config_.analyzer) {
+            const Count documents = database_.getDocumentCount();
+            if (documents > 0) {
+                spdlog::warn("Index already has {} document(s) built with analyzer {}; ignoring analyzer {} "
+                             "(rebuild the index to change it).",
+                             documents, static_cast<int>(config_.analyzer), static_cast<int>(analyzer));
+                return false;
+            }
+        }
+        config_.analyzer = analyzer;
+        if (initialized_) {
+            database_.setSetting("analyzer", std::to_string(static_cast<int>(config_.analyzer)));
+        }
+        return true;
+    }
+
     /**
      * @brief 关闭搜索引擎环境
      * 
      * 执行优雅的关闭流程：
      * 1. 检查并刷新内存中的索引缓冲区
-     * 2. 保存当前配置到数据库
-     * 3. 关闭数据库连接
-     * 4. 记录关闭日志
+     * 2. 停止后台段合并线程（未完成的合并被放弃，下次启动后重新合并）
+     * 3. 保存当前配置到数据库
+     * 4. 关闭数据库连接
+     * 5. 记录关闭日志
      */
     void WiserEnvironment::shutdown() {
-        // 检查内存索引缓冲区是否还有未写入的数据
-        if (index_buffer_.size() > 0) {
+        // 检查内存索引缓冲区或词元字典是否还有未写入的数据
+        if (index_buffer_.size() > 0 || token_dictionary_.hasPendingTokens()) {
             // 如果有未写入的数据，先刷新到数据库
             flushIndexBuffer();
         }
 
+        // 停止后台合并，之后不再有其他线程访问数据库
+        compactor_.stop();
+
         // 保存当前配置设置到数据库
         // 保存分词器token长度配置
         database_.setSetting("token_len", std::to_string(config_.token_len));
+        // 保存分析器配置
+        database_.setSetting("analyzer", std::to_string(static_cast<int>(config_.analyzer)));
         // 保存压缩方法配置
         database_.setSetting("compress_method", std::to_string(static_cast<int>(config_.compress_method)));
         // 保存已索引文档数量
@@ -235,21 +289,10 @@ namespace wiser {
 
         // 生成倒排索引增量：将正文分词并加入内存缓冲 index_buffer_（尚落盘）
         int term_count = tokenizer_.textToPostingsLists(document_id, body, index_buffer_);
+        max_tokenized_doc_id_ = std::max(max_tokenized_doc_id_, document_id);
 
-        // 更新文档的 token 总数
-        database_.updateDocumentTokenCount(document_id, term_count);
-        // 更新缓存
-        {
-            std::unique_lock<std::shared_mutex> lock(cache_mutex_);
-            if (doc_lengths_cache_.find(document_id) == doc_lengths_cache_.end()) {
-                 // 新文档
-                 total_tokens_ += term_count;
-            } else {
-                 // 更新文档，diff (通常 addDocument 在 wiser 中是新增，但逻辑上支持更新)
-                 total_tokens_ += (term_count - doc_lengths_cache_[document_id]);
-            }
-            doc_lengths_cache_[document_id] = term_count;
-        }
+        // 更新文档的 token 总数与文档长度缓存
+        recordDocumentLength(document_id, term_count);
 
         // 统计已索引文档数（用于 max_index_count_ 限制以及外部进度显示）
         ++indexed_count_;
@@ -272,24 +315,157 @@ namespace wiser {
         // 未达到阈值：数据留在内存缓冲，等待后续文档继续累积或外部显式 flush
     }
 
+    size_t WiserEnvironment::addDocuments(std::span<const std::pair<std::string, std::string>> documents) {
+        // 1) 在调用线程上按顺序写入文档：文档 ID 的分配顺序与逐个 addDocument 相同
+        size_t remaining = std::numeric_limits<size_t>::max();
+        if (config_.max_index_count >= 0) {
+            remaining = config_.max_index_count > indexed_count_
+                            ? static_cast<size_t>(config_.max_index_count - indexed_count_)
+                            : 0;
+        }
+        std::vector<std::pair<DocId, std::string_view>> jobs; // (文档 ID, 正文)
+        jobs.reserve(std::min(documents.size(), remaining));
+        for (const auto& [title, body]: documents) {
+            if (jobs.size() >= remaining) {
+                break;
+            }
+            if (title.empty()) {
+                continue;
+            }
+            if (body.empty()) {
+                spdlog::error("Document body is empty for title: {}", title);
+                continue;
+            }
+            if (!database_.addDocument(title, body, 0)) {
+                spdlog::error("Failed to add document to database: {}", title);
+                continue;
+            }
+            DocId document_id = database_.getDocumentId(title);
+            if (document_id <= 0) {
+                spdlog::error("Failed to get document ID for: {}", title);
+                continue;
+            }
+            jobs.emplace_back(document_id, body);
+        }
+        if (jobs.empty()) {
+            return 0;
+        }
+
+        // 文档 ID 大于此前分过词的所有文档的为新文档，可以并行分词；重复或更新已有标题的文档复用了较小的 ID，
+        // 留到局部索引合并之后在调用线程上按顺序写入 index_buffer_（与 addDocument 相同，经一般的插入/归并路径）。
+        // 这样各局部索引的文档 ID 区间互不重叠且都大于缓冲区中已有的文档，合并时倒排列表总是整段追加
+        std::vector<size_t> fresh;   // 新文档在 jobs 中的下标（文档 ID 递增）
+        std::vector<size_t> reused;  // 复用文档 ID 的下标（保持原顺序）
+        fresh.reserve(jobs.size());
+        for (size_t i = 0; i < jobs.size(); ++i) {
+            if (jobs[i].first > max_tokenized_doc_id_) {
+                max_tokenized_doc_id_ = jobs[i].first;
+                fresh.push_back(i);
+            } else {
+                reused.push_back(i);
+            }
+        }
+
+        // 2) 并行分词：新文档按顺序切成连续的若干段，每段由一个线程写入自己的局部倒排索引
+        size_t threads = config_.index_threads > 0 ? static_cast<size_t>(config_.index_threads)
+                                                   : std::max(1u, std::thread::hardware_concurrency());
+        threads = std::min(threads, (fresh.size() + kMinDocsPerIndexThread - 1) / kMinDocsPerIndexThread);
+        std::vector<int> term_counts(jobs.size());
+        if (threads <= 1) {
+            for (size_t i = 0; i < jobs.size(); ++i) {
+                term_counts[i] = tokenizer_.textToPostingsLists(jobs[i].first, jobs[i].second, index_buffer_);
+            }
+        } else {
+            while (ingest_tokenizers_.size() < threads) {
+                ingest_tokenizers_.emplace_back(this);
+            }
+            std::vector<InvertedIndex> partials(threads);
+            std::vector<std::exception_ptr> errors(threads);
+            std::vector<std::thread> workers;
+            workers.reserve(threads);
+            for (size_t t = 0; t < threads; ++t) {
+                const size_t begin = fresh.size() * t / threads;
+                const size_t end = fresh.size() * (t + 1) / threads;
+                workers.emplace_back([this, &jobs, &fresh, &term_counts, &partials, &errors, t, begin, end] {
+                    // 异常不能逃出线程函数（否则 std::terminate），记下后由调用线程重新抛出
+                    try {
+                        for (size_t k = begin; k < end; ++k) {
+                            const size_t i = fresh[k];
+                            term_counts[i] = ingest_tokenizers_[t].textToPostingsLists(jobs[i].first, jobs[i].second,
+                                                                                       partials[t]);
+                        }
+                    } catch (...) {
+                        errors[t] = std::current_exception();
+                    }
+                });
+            }
+            for (auto& worker: workers) {
+                worker.join();
+            }
+            // 任一线程失败则整批不进入缓冲区（局部索引随之丢弃），文档长度与计数也不更新
+            for (const auto& error: errors) {
+                if (error) {
+                    std::rethrow_exception(error);
+                }
+            }
+            // 3) 按文档 ID 区间依次合并：后一段的文档 ID 都更大，倒排列表整段追加。
+            //    每批结束即合并，而不是留到 flush 时：未刷盘的文档与 addDocument 一样立即可检索，
+            //    flush 与查询也只需面对一个 index_buffer_；局部索引的大小受批大小限制，合并代价与逐个添加相当
+            for (auto& partial: partials) {
+                index_buffer_.merge(std::move(partial));
+            }
+            for (size_t i: reused) {
+                term_counts[i] = tokenizer_.textToPostingsLists(jobs[i].first, jobs[i].second, index_buffer_);
+            }
+        }
+
+        // 4) 按顺序更新文档长度与计数
+        for (size_t i = 0; i < jobs.size(); ++i) {
+            recordDocumentLength(jobs[i].first, term_counts[i]);
+        }
+        indexed_count_ += static_cast<Count>(jobs.size());
+
+        if (config_.buffer_update_threshold > 0 && index_buffer_.size() >= static_cast<size_t>(config_.buffer_update_threshold)) {
+            flushIndexBuffer();
+        }
+        return jobs.size();
+    }
+
+    void WiserEnvironment::recordDocumentLength(DocId document_id, int term_count) {
+        database_.updateDocumentTokenCount(document_id, term_count);
+        std::unique_lock<std::shared_mutex> lock(cache_mutex_);
+        if (doc_lengths_cache_.find(document_id) == doc_lengths_cache_.end()) {
+             // 新文档
+             total_tokens_ += term_count;
+        } else {
+             // 更新文档，diff (通常 addDocument 在 wiser 中是新增，但逻辑上支持更新)
+             total_tokens_ += (term_count - doc_lengths_cache_[document_id]);
+        }
+        doc_lengths_cache_[document_id] = term_count;
+    }
+
     /**
      * @brief 刷新索引缓冲区到数据库
      * 
      * 将内存中的倒排索引缓冲区内容写入数据库：
-     * 1. 检查缓冲区是否为空
+     * 1. 检查缓冲区与待持久化词元是否为空
      * 2. 开始数据库事务
-     * 3. 合并或插入倒排索引数据
-     * 4. 提交事务或回滚错误
-     * 5. 清空缓冲区
+     * 3. 批量写入词元字典中新分配的词元
+     * 4. 将缓冲区写成一个新段并发布
+     * 5. 提交事务或回滚错误
+     * 6. 清空缓冲区，通知后台合并线程
      */
     void WiserEnvironment::flushIndexBuffer() {
         // 检查缓冲区是否为空，避免不必要的数据库操作
-        if (index_buffer_.size() == 0)
+        if (index_buffer_.size() == 0 && !token_dictionary_.hasPendingTokens())
             return;
 
         // 记录调试信息，显示要刷新的token数量
         spdlog::debug("Flushing index buffer with {} token(s).", index_buffer_.size());
 
+        // 与后台段合并的写事务互斥
+        std::lock_guard<std::mutex> write_lock(index_write_mutex_);
+
         // 开始数据库事务，确保数据一致性
         if (!database_.beginTransaction()) {
             spdlog::error("Failed to begin transaction");
@@ -297,35 +473,38 @@ namespace wiser {
         }
 
         try {
-            // 遍历缓冲区中的所有token和对应的倒排列表
-            for (auto& [token_id, postings_list]: index_buffer_) {
-                // 从数据库获取该token现有的倒排列表
-                auto rec = database_.getPostings(token_id);
-
-                if (rec.has_value() && !rec->postings.empty()) {
-                    // 情况1：数据库中已存在该token的倒排列表
-                    PostingsList existing_list;
-                    // 反序列化时使用当前配置的压缩方法
-                    existing_list.deserialize(rec->postings, config_.compress_method);
-                    existing_list.merge(std::move(*postings_list));  // 合并内存中的新数据
-
-                    // 重新序列化合并后的列表
-                    auto serialized = existing_list.serialize(config_.compress_method);
-                    Count new_docs_count = existing_list.getDocumentsCount();
-
-                    // 更新数据库中的倒排列表
-                    if (!database_.updatePostings(token_id, new_docs_count, serialized)) {
-                        throw std::runtime_error("Failed to update postings for token " + std::to_string(token_id));
+            // 先写入新词元（ID 已在字典中分配），段内倒排按词元 ID 引用它们
+            auto pending_tokens = token_dictionary_.getPendingTokens();
+            if (!pending_tokens.empty() && !database_.storeTokens(pending_tokens)) {
+                throw std::runtime_error("Failed to store " + std::to_string(pending_tokens.size()) + " new token(s)");
+            }
+
+            // 总文档数用于判断高文档频率词元是否附带文档位图
+            const Count total_docs = database_.getDocumentCount();
+
+            // 缓冲区写成一个新段：只写入新增数据，不读取、不重写已有倒排；段在提交前发布，查询随事务一起可见
+            if (index_buffer_.size() > 0) {
+                auto segment_id = database_.createSegment();
+                if (!segment_id) {
+                    throw std::runtime_error("Failed to create segment");
+                }
+                std::int64_t segment_size = 0;
+                for (auto& [token_id, postings_list]: index_buffer_) {
+                    const auto& doc_ids = postings_list->getDocumentIds();
+                    if (doc_ids.empty()) {
+                        continue;
                     }
-                } else {
-                    // 情况2：数据库中不存在该token的倒排列表，直接插入
-                    auto serialized = postings_list->serialize(config_.compress_method);
-                    Count docs_count = postings_list->getDocumentsCount();
-
-                    // 插入新的倒排列表到数据库
-                    if (!database_.updatePostings(token_id, docs_count, serialized)) {
-                        throw std::runtime_error("Failed to insert postings for token " + std::to_string(token_id));
+                    SegmentPostingsRecord record{ token_id, postings_list->getDocumentsCount(), doc_ids.front(),
+                                                  doc_ids.back(), {} };
+                    record.postings = postings_list->serialize(config_.compress_method,
+                                                               useDocBitmap(record.docs_count, total_docs));
+                    if (!database_.addSegmentPostings(*segment_id, record)) {
+                        throw std::runtime_error("Failed to write postings for token " + std::to_string(token_id));
                     }
+                    segment_size += static_cast<std::int64_t>(record.postings.size());
+                }
+                if (!database_.publishSegment(*segment_id, segment_size)) {
+                    throw std::runtime_error("Failed to publish segment " + std::to_string(*segment_id));
                 }
             }
 
@@ -333,6 +512,8 @@ namespace wiser {
             if (!database_.commitTransaction()) {
                 throw std::runtime_error("Failed to commit transaction");
             }
+            // 事务提交后新词元才算真正落库；失败时保留待持久化状态，下次 flush 重试
+            token_dictionary_.clearPendingTokens(pending_tokens.size());
 
             // 记录成功刷新的调试信息
             spdlog::debug("Index buffer flushed successfully");
@@ -344,5 +525,8 @@ namespace wiser {
 
         // 清空内存缓冲区，准备接收新的索引数据
         index_buffer_.clear();
+
+        // 段集合已变化，由后台线程判断是否需要合并
+        compactor_.notify();
     }
 } // namespace wiser